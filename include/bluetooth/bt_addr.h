@@ -0,0 +1,26 @@
+#ifndef BT_ADDR_H
+#define BT_ADDR_H
+
+#include "common.h"
+
+/*
+ * Bluetooth device address packed into the low 48 bits of an integer,
+ * most significant byte first (AA:BB:CC:DD:EE:FF -> 0xAABBCCDDEEFF).
+ * Addresses are parsed once at the D-Bus boundary; tables then key on
+ * the integer and never hash or copy strings.
+ */
+typedef uint64_t bt_addr_t;
+
+#define BT_ADDR_STR_LEN 18            // "XX:XX:XX:XX:XX:XX" plus NUL
+#define BT_ADDR_NONE UINT64_MAX       // Never a valid address (more than 48 bits)
+
+/* Parse XX:XX:XX:XX:XX:XX (':', '_' or '-' separators, any case) */
+bool bt_addr_parse(const char* str, bt_addr_t* out);
+
+/* Parse the address out of a BlueZ object path (/org/bluez/hciN/dev_XX_XX_XX_XX_XX_XX[/...]) */
+bool bt_addr_from_path(const char* path, bt_addr_t* out);
+
+/* Format as upper-case XX:XX:XX:XX:XX:XX */
+void bt_addr_format(bt_addr_t addr, char out[BT_ADDR_STR_LEN]);
+
+#endif /* BT_ADDR_H */
@@ -0,0 +1,51 @@
+#ifndef BUS_CORE_H
+#define BUS_CORE_H
+
+#include "common.h"
+#include "dbus_reactor.h"
+#include <dbus/dbus.h>
+
+/*
+ * The process's one private system bus connection and the reactor thread
+ * that dispatches it, shared by every manager. bus_core_get() hands out
+ * references: the first opens the connection and starts the thread, the
+ * last bus_core_unref() stops and closes them. Signals are routed through
+ * a table keyed by interface and member, so a signal costs one lookup and
+ * reaches only the handlers registered for it. Handlers, reactor timers
+ * and pending call notifications all run on the bus thread.
+ */
+typedef struct BusCore BusCore;
+
+/* Signal handler - runs on the bus thread */
+typedef void (*BusSignalHandler)(DBusMessage* message, void* user_data);
+
+/* Work to run on the bus thread */
+typedef void (*BusTask)(void* data);
+
+/* Take a reference to the shared core, opening it if needed (NULL on failure) */
+BusCore* bus_core_get(void);
+
+/* Drop a reference; the last one stops the thread and closes the connection.
+ * Must not be called on the bus thread. */
+void bus_core_unref(BusCore* core);
+
+/* The shared connection (owned by the core) */
+DBusConnection* bus_core_connection(BusCore* core);
+
+/* The reactor running the bus thread, for timers */
+DBusReactor* bus_core_reactor(BusCore* core);
+
+/* Route signals with this interface and member to handler */
+bool bus_core_add_handler(BusCore* core, const char* interface, const char* member,
+                          BusSignalHandler handler, void* user_data);
+
+/* Remove every handler registered with user_data. One may still be running
+ * unless this is called on the bus thread, e.g. from bus_core_run(). */
+void bus_core_remove_handlers(BusCore* core, void* user_data);
+
+/* Run task on the bus thread and wait for it (runs it directly when called
+ * there). Nothing else on the bus thread runs meanwhile, which makes it the
+ * place to detach a manager's handlers and timers for good. */
+void bus_core_run(BusCore* core, BusTask task, void* data);
+
+#endif /* BUS_CORE_H */
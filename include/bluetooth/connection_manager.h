@@ -2,19 +2,56 @@
 #define CONNECTION_MANAGER_H
 
 #include "common.h"
+#include "device_manager.h"
 #include <glib.h>
 
 typedef struct ConnectionManager ConnectionManager;
 
+/* Handle for a bulk connect request (reference counted) */
+typedef struct ConnectBatch ConnectBatch;
+
+/* Handle for an asynchronous operation (reference counted) */
+typedef struct ConnectionOperation ConnectionOperation;
+
+/* Asynchronous operation types */
+typedef enum {
+    OPERATION_CONNECT = 0,
+    OPERATION_DISCONNECT,
+    OPERATION_PAIR,
+    OPERATION_TRUST
+} OperationType;
+
+/* Which adapter a connect goes through when several know the device. A
+ * device whose link is already up is always reached through that adapter. */
+typedef enum {
+    ADAPTER_SELECT_FIRST = 0,         // The first adapter BlueZ reported it on
+    ADAPTER_SELECT_BEST_RSSI,         // Strongest sighting in config.device_manager
+    ADAPTER_SELECT_FEWEST_LINKS,      // Fewest links up plus bulk connects queued or running
+    ADAPTER_SELECT_ROUND_ROBIN        // Take turns across the adapters that know it
+} AdapterSelection;
+
 /* Connection manager configuration */
 typedef struct {
     int connection_timeout;           // Timeout in seconds for connection attempts
     bool auto_reconnect;              // Attempt to reconnect if connection drops
     bool auto_trust;                  // Automatically trust connected devices
+    int reconnect_base_delay_ms;      // First retry delay, doubled per failure (0 = 1000)
+    int reconnect_max_delay_ms;       // Backoff ceiling (0 = 60000)
+    int reconnect_max_attempts;       // Give up after this many failures in a row (0 = never)
+    int max_connects_per_adapter;     // Bulk connect attempts in flight per adapter (0 = 4)
+    DeviceManager* device_manager;    // Optional RSSI source for bulk connect ordering and BEST_RSSI
+    AdapterSelection adapter_selection; // Adapter for connects and pairing (default: first)
+    int max_devices;                  // Devices whose state is tracked, preallocated (0 = 4096)
+    const char* metrics_path;         // Prometheus text file to keep up to date (NULL = none)
+    int metrics_interval_ms;          // How often metrics_path is rewritten (0 = 10000)
     void* user_data;                  // User data for callbacks
 } ConnectionManagerConfig;
 
-/* Connection state change callback */
+/* Connection state change callback. Driven by BlueZ's Connected signals,
+ * so links that come up or drop on their own are reported too, with
+ * CONNECTING, DISCONNECTING and FAILED around our own calls. Runs on the
+ * bus thread or on the thread making a blocking call; a state already
+ * replaced by a newer one when its report is due is skipped. */
 typedef void (*ConnectionStateCallback)(const char* device_address, 
                                         ConnectionState state, 
                                         void* user_data);
@@ -25,6 +62,71 @@ typedef void (*PairingCallback)(const char* device_address,
                                 const char* error_message, 
                                 void* user_data);
 
+/* Asynchronous operation completion callback.
+ * Runs on the bus thread shared with any DeviceManager (keep it short, it
+ * holds up their signals too), or on the thread calling
+ * connection_operation_cancel()/connection_manager_destroy() with ERR_CANCELLED. */
+typedef void (*OperationCallback)(ConnectionOperation* operation,
+                                  ErrorCode result,
+                                  const char* error_message,
+                                  void* user_data);
+
+/* Per-device auto-reconnect statistics */
+typedef struct {
+    uint32_t drops;                   // Link losses seen while the link was wanted
+    uint32_t attempts;                // Reconnect attempts started
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t consecutive_failures;    // Reset by a successful reconnect
+    uint32_t last_delay_ms;           // Backoff (with jitter) chosen for the latest retry
+    bool pending;                     // A retry is scheduled
+} ReconnectStats;
+
+/* A device as BlueZ's signals last described it */
+typedef struct {
+    ConnectionState state;            // As connection_manager_get_state() reports it
+    bool connected;                   // Link up through some adapter
+    bool services_resolved;           // Service discovery on that link has finished
+    bool paired;                      // Paired through any adapter
+    bool trusted;                     // Trusted on any adapter
+} DeviceStatus;
+
+/* Runtime metrics */
+typedef struct {
+    uint64_t signals_received;
+    uint64_t operations_started;      // Connect/Disconnect/Pair/Trust calls, blocking or async
+    uint64_t operations_failed;       // Error replies and timeouts (not cancellations)
+    uint64_t connections;             // Devices with a link up
+    LatencyStats connect_rtt;         // D-Bus round trip per call
+    LatencyStats disconnect_rtt;
+    LatencyStats pair_rtt;
+    LatencyStats trust_rtt;
+    LatencyStats lock_wait;           // Waiting for the manager lock
+    LatencyStats lock_hold;
+} ConnectionManagerStats;
+
+/* Aggregate progress of a bulk connect */
+typedef struct {
+    int total;                        // Addresses in the batch
+    int queued;                       // Waiting for an adapter slot
+    int in_flight;                    // Connect attempts currently running
+    int succeeded;
+    int failed;                       // Failed, timed out, unknown or cancelled
+} ConnectBatchProgress;
+
+/* Bulk connect progress callback - runs after every completed attempt */
+typedef void (*ConnectBatchCallback)(ConnectBatch* batch,
+                                     const ConnectBatchProgress* progress,
+                                     void* user_data);
+
+/* Bulk connect policy */
+typedef struct {
+    const int* priorities;            // Optional per-address priority, higher first (NULL = all equal)
+    int timeout_ms;                   // Deadline per connect attempt (<= 0 = default)
+    ConnectBatchCallback on_progress; // Optional progress callback
+    void* user_data;                  // User data for on_progress
+} ConnectPolicy;
+
 /* Initialize connection manager */
 ConnectionManager* connection_manager_create(const ConnectionManagerConfig* config);
 
@@ -52,10 +154,80 @@ ErrorCode connection_manager_trust(ConnectionManager* manager,
 ErrorCode connection_manager_block(ConnectionManager* manager, 
                                    const char* device_address);
 
-/* Get connection state for a device */
+/* Asynchronous variants - return immediately, completion is reported through
+ * the callback. timeout_ms is the deadline for this call (<= 0 = default).
+ * The returned handle holds a reference for the caller, release it with
+ * connection_operation_unref(). Returns NULL (no callback) if the request
+ * could not be issued, e.g. for an unknown device. */
+ConnectionOperation* connection_manager_connect_async(ConnectionManager* manager,
+                                                      const char* device_address,
+                                                      int timeout_ms,
+                                                      OperationCallback callback,
+                                                      void* user_data);
+ConnectionOperation* connection_manager_disconnect_async(ConnectionManager* manager,
+                                                         const char* device_address,
+                                                         int timeout_ms,
+                                                         OperationCallback callback,
+                                                         void* user_data);
+ConnectionOperation* connection_manager_pair_async(ConnectionManager* manager,
+                                                   const char* device_address,
+                                                   int timeout_ms,
+                                                   OperationCallback callback,
+                                                   void* user_data);
+ConnectionOperation* connection_manager_trust_async(ConnectionManager* manager,
+                                                    const char* device_address,
+                                                    int timeout_ms,
+                                                    OperationCallback callback,
+                                                    void* user_data);
+
+/* Connect to many devices. Attempts are queued on the adapter picked by
+ * config.adapter_selection, ordered by priority then RSSI (from
+ * config.device_manager), and at most
+ * config.max_connects_per_adapter run at once on each adapter.
+ * Release the returned handle with connect_batch_unref(). */
+ConnectBatch* connection_manager_connect_many(ConnectionManager* manager,
+                                              const char* const* addresses,
+                                              size_t count,
+                                              const ConnectPolicy* policy);
+
+/* Bulk connect helpers */
+void connect_batch_get_progress(ConnectBatch* batch, ConnectBatchProgress* progress);
+void connect_batch_cancel(ConnectBatch* batch);
+void connect_batch_unref(ConnectBatch* batch);
+
+/* Cancel an operation; its callback runs with ERR_CANCELLED unless it already completed */
+void connection_operation_cancel(ConnectionOperation* operation);
+
+/* Operation accessors */
+OperationType connection_operation_get_type(const ConnectionOperation* operation);
+const char* connection_operation_get_address(const ConnectionOperation* operation);
+
+/* Operation reference counting */
+ConnectionOperation* connection_operation_ref(ConnectionOperation* operation);
+void connection_operation_unref(ConnectionOperation* operation);
+
+/* Get connection state for a device (DISCONNECTED if BlueZ doesn't know it).
+ * Lock-free, like connection_manager_get_status(). */
 ConnectionState connection_manager_get_state(ConnectionManager* manager, 
                                              const char* device_address);
 
+/* Get what BlueZ last reported about a device, without asking it
+ * (ERR_NO_DEVICE if BlueZ doesn't know it) */
+ErrorCode connection_manager_get_status(ConnectionManager* manager,
+                                        const char* device_address,
+                                        DeviceStatus* status);
+
+/* Get auto-reconnect statistics for a device (ERR_NO_DEVICE if never tracked) */
+ErrorCode connection_manager_get_reconnect_stats(ConnectionManager* manager,
+                                                 const char* device_address,
+                                                 ReconnectStats* stats);
+
+/* Get runtime metrics */
+ErrorCode connection_manager_get_stats(ConnectionManager* manager, ConnectionManagerStats* stats);
+
+/* Write the metrics in Prometheus text format to fd (a file, pipe or socket) */
+ErrorCode connection_manager_write_metrics(ConnectionManager* manager, int fd);
+
 /* Set callbacks */
 void connection_manager_set_state_callback(ConnectionManager* manager, 
                                            ConnectionStateCallback callback);
@@ -0,0 +1,62 @@
+#ifndef CONNECTION_STATES_H
+#define CONNECTION_STATES_H
+
+#include "common.h"
+#include "bt_addr.h"
+#include <stddef.h>
+
+/*
+ * Preallocated connection state store. Every tracked address owns a slot
+ * with one atomic 32-bit state word: its ConnectionState, the link flags
+ * below and an owner tag that changes whenever the slot changes hands.
+ * Reading a device's state is one atomic load and a transition is one
+ * compare-and-swap; neither allocates or takes a lock. Slots never move;
+ * they are found through an open-addressing index probed with atomic
+ * loads. All memory is allocated at create.
+ *
+ * Adding and removing addresses must be serialized by the caller; reads
+ * and state word exchanges are safe from any thread at any time. A reader
+ * only ever waits out an index rebuild, which compacts tombstones once
+ * they fill a quarter of the index.
+ */
+typedef struct ConnectionStates ConnectionStates;
+
+typedef uint32_t StateSlot;
+
+#define STATE_SLOT_NONE UINT32_MAX
+
+/* Fields of a state word */
+#define STATE_WORD_STATE     0x0000000Fu   // ConnectionState
+#define STATE_WORD_CONNECTED 0x00000010u   // Link up through some adapter
+#define STATE_WORD_RESOLVED  0x00000020u   // Services resolved on that link
+#define STATE_WORD_PAIRED    0x00000040u
+#define STATE_WORD_TRUSTED   0x00000080u
+#define STATE_WORD_FLAGS     0x000000F0u
+#define STATE_WORD_OWNER     0xFFFFFF00u   // Changes when the slot is reassigned
+
+/* Create a store for up to max_devices addresses */
+ConnectionStates* connection_states_create(size_t max_devices);
+
+/* Slot of addr, adding it as DISCONNECTED without flags if new;
+ * STATE_SLOT_NONE when the store is full (writer only) */
+StateSlot connection_states_add(ConnectionStates* states, bt_addr_t addr);
+
+/* Stop tracking addr; its slot may be reused afterwards (writer only) */
+void connection_states_remove(ConnectionStates* states, bt_addr_t addr);
+
+/* Slot of addr and its current word, or STATE_SLOT_NONE. Any thread. */
+StateSlot connection_states_find(const ConnectionStates* states, bt_addr_t addr, uint32_t* word);
+
+/* Current word of a slot. Any thread. */
+uint32_t connection_states_load(const ConnectionStates* states, StateSlot slot);
+
+/* Replace a slot's word with desired (owner bits are kept) if it still
+ * holds *word. On failure *word is refreshed; once its owner bits differ
+ * from the ones read, the slot belongs to another address. */
+bool connection_states_exchange(ConnectionStates* states, StateSlot slot,
+                                uint32_t* word, uint32_t desired);
+
+/* Cleanup (no reader may still be running) */
+void connection_states_destroy(ConnectionStates* states);
+
+#endif /* CONNECTION_STATES_H */
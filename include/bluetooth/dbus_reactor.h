@@ -0,0 +1,40 @@
+#ifndef DBUS_REACTOR_H
+#define DBUS_REACTOR_H
+
+#include "common.h"
+#include "timer_wheel.h"
+#include <dbus/dbus.h>
+
+/*
+ * Event loop for a DBusConnection built on the libdbus watch/timeout hooks.
+ * The loop sleeps in poll() until the bus socket is readable, a libdbus
+ * timeout expires or another thread wakes it through an eventfd, so an
+ * idle connection costs no CPU and signals are dispatched as they arrive.
+ * Messages are delivered through the connection's filters/object handlers.
+ * libdbus timeouts and caller timers share one timer wheel.
+ */
+typedef struct DBusReactor DBusReactor;
+
+/* Create a reactor and install its hooks on the connection */
+DBusReactor* dbus_reactor_create(DBusConnection* conn);
+
+/* Run the loop on the calling thread until dbus_reactor_stop() is called */
+void dbus_reactor_run(DBusReactor* reactor);
+
+/* Make dbus_reactor_run() return as soon as possible (any thread) */
+void dbus_reactor_stop(DBusReactor* reactor);
+
+/* Wake the loop so it re-evaluates its watches and dispatch queue (any thread) */
+void dbus_reactor_wakeup(DBusReactor* reactor);
+
+/* Arm (or re-arm) a timer that fires on the reactor thread after delay_ms (any thread) */
+void dbus_reactor_schedule(DBusReactor* reactor, WheelTimer* timer, uint64_t delay_ms);
+
+/* Disarm a timer (any thread). The callback may still be running if the
+ * timer expired concurrently, so owners should outlive the reactor. */
+void dbus_reactor_cancel(DBusReactor* reactor, WheelTimer* timer);
+
+/* Remove the hooks from the connection and free the reactor (loop must be stopped) */
+void dbus_reactor_destroy(DBusReactor* reactor);
+
+#endif /* DBUS_REACTOR_H */
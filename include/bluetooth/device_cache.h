@@ -0,0 +1,61 @@
+#ifndef DEVICE_CACHE_H
+#define DEVICE_CACHE_H
+
+#include "common.h"
+#include "bt_addr.h"
+#include <stddef.h>
+
+/*
+ * Persistent device cache: a memory-mapped file of fixed 64-byte records
+ * behind a versioned header. Updates are appended as new records (the last
+ * record for an address wins) and committed by bumping the header's record
+ * count, so a crash can at worst lose the record being written. When the
+ * file is full, the live records are compacted into a new file that
+ * atomically replaces the old one. Opening a file only maps it and indexes
+ * its records, which takes microseconds for thousands of devices.
+ * Not thread-safe.
+ */
+typedef struct DeviceCache DeviceCache;
+
+#define DEVICE_CACHE_ALIAS_MAX 39
+
+/* Bits of DeviceCacheRecord.flags */
+#define DEVICE_CACHE_USER_ALIAS 0x01      // Alias set locally, not by BlueZ
+#define DEVICE_CACHE_REMOVED 0x80         // Tombstone: forget the address
+
+/* On-disk record (host byte order) */
+typedef struct {
+    bt_addr_t addr;
+    int64_t last_seen;                    // Unix time in seconds
+    uint32_t class;
+    uint8_t type;                         // DeviceType
+    int8_t rssi;                          // Last RSSI
+    uint8_t flags;
+    uint8_t check;                        // Detects torn records
+    uint8_t adapter;                      // N of the /org/bluez/hciN that saw it
+    char alias[DEVICE_CACHE_ALIAS_MAX];   // NUL-terminated, truncated to fit
+} DeviceCacheRecord;
+
+/* Open or create a cache file. A file with another version or a damaged
+ * header is started over. NULL on I/O errors. */
+DeviceCache* device_cache_open(const char* path);
+
+/* Latest record for an address, or NULL. Valid until the next put. */
+const DeviceCacheRecord* device_cache_find(const DeviceCache* cache, bt_addr_t addr);
+
+/* Append a record, superseding any older one for the same address */
+bool device_cache_put(DeviceCache* cache, const DeviceCacheRecord* record);
+
+/* Forget an address (appends a tombstone that compaction drops) */
+bool device_cache_remove(DeviceCache* cache, bt_addr_t addr);
+
+/* Number of distinct devices */
+size_t device_cache_count(const DeviceCache* cache);
+
+/* Iterate the latest records: start with *cursor = 0, NULL when done */
+const DeviceCacheRecord* device_cache_next(const DeviceCache* cache, size_t* cursor);
+
+/* Flush and close */
+void device_cache_close(DeviceCache* cache);
+
+#endif /* DEVICE_CACHE_H */
@@ -2,39 +2,213 @@
 #define DEVICE_MANAGER_H
 
 #include "common.h"
+#include "event_queue.h"
+#include "metrics.h"
 #include <glib.h>
 
 typedef struct DeviceManager DeviceManager;
 
-/* Device manager configuration */
+/* Immutable, reference-counted view of every known device */
+typedef struct DeviceSnapshot DeviceSnapshot;
+
+/* Transport to discover on */
+typedef enum {
+    DISCOVERY_TRANSPORT_AUTO = 0,        // Everything the adapter supports
+    DISCOVERY_TRANSPORT_LE,
+    DISCOVERY_TRANSPORT_BREDR
+} DiscoveryTransport;
+
+/* Discovery filter applied inside bluetoothd (org.bluez.Adapter1.SetDiscoveryFilter) */
+typedef struct {
+    int16_t rssi;                        // Only report devices at or above this RSSI (0 = any)
+    uint16_t pathloss;                   // Only report devices below this pathloss (0 = any, not with rssi)
+    DiscoveryTransport transport;
+    const char** uuids;                  // Service UUIDs to match (copied)
+    size_t uuid_count;
+    bool duplicate_data;                 // Signal repeated advertising data (BlueZ's default is true)
+} DiscoveryFilter;
+
+/* An adapter was plugged in (present) or went away. The path stays valid
+ * until the manager is destroyed. */
+typedef void (*AdapterCallback)(const char* adapter_path, bool present, void* user_data);
+
+/* One Bluetooth adapter as the manager sees it */
+typedef struct {
+    const char* path;                    // e.g. /org/bluez/hci0, valid until destroy
+    bool present;                        // false once unplugged, until it comes back
+    bool discovering;                    // Our discovery runs on it
+    size_t devices;                      // Devices seen through it
+} AdapterInfo;
+
+/* One adapter's view of a device */
+typedef struct {
+    const char* adapter;                 // Adapter path, valid until destroy
+    int8_t rssi;                         // As this adapter last heard it (0 = unknown)
+    uint64_t age_ms;                     // Since this adapter last saw it (UINT64_MAX = never)
+} DeviceSighting;
+
+/* Device manager configuration. Every adapter bluetoothd has, or gets
+ * later, is used; each keeps its own share of the device table. A device
+ * seen by several is fused into one, as the adapter hearing it best has it;
+ * device_manager_get_sightings() has the per-adapter detail.
+ * on_discovered, on_lost, on_scan_status and on_adapter are queued and run
+ * on callback_executor, never under the manager's lock or on the bus
+ * thread, so they may call back into the manager (but not destroy it).
+ * With CALLBACK_EXECUTOR_POOL they may run concurrently and out of order.
+ * With CALLBACK_EXECUTOR_MAIN_CONTEXT and CALLBACK_OVERFLOW_BLOCK, don't
+ * call the manager from a thread that has to run that context. on_error is
+ * still called directly. The device handed to on_discovered and on_lost,
+ * strings included, is only valid during the call. */
 typedef struct {
     int scan_duration;                    // Scan duration in seconds (0 = continuous)
+    int scan_interval;                    // Start a new scan every scan_interval seconds (0 = scan once)
     bool filter_duplicates;              // Filter duplicate device discoveries
+    int duplicate_window_ms;             // Repeated advertisements inside this window are dropped (0 = 1000)
+    int rssi_threshold_db;               // RSSI changes larger than this always pass (0 = 5)
+    int snapshot_interval_ms;            // Max delay before changes show up in snapshots (0 = 100)
+    const char* cache_path;              // Persistent device cache file (NULL = none)
+    int max_devices;                     // Per adapter; beyond this its least recently seen unpaired device is evicted (0 = unlimited)
+    int device_ttl_s;                    // Forget unpaired devices not seen for this long (0 = never)
+    const char* metrics_path;            // Prometheus text file to keep up to date (NULL = none)
+    int metrics_interval_ms;             // How often metrics_path is rewritten (0 = 10000)
+    CallbackExecutor callback_executor;  // Where callbacks run (default: one thread, in order)
+    GMainContext* callback_context;      // CALLBACK_EXECUTOR_MAIN_CONTEXT (NULL = global default)
+    int callback_threads;                // CALLBACK_EXECUTOR_POOL size (0 = 4)
+    int callback_queue_size;             // Events waiting for callbacks (0 = 1024)
+    CallbackOverflow callback_overflow;  // BLOCK stalls the bus thread until there is room
     DeviceDiscoveredCallback on_discovered;
+    DeviceLostCallback on_lost;          // Device evicted, expired or its last adapter gone
     ScanStatusCallback on_scan_status;
+    AdapterCallback on_adapter;          // Adapter hotplug
     ErrorCallback on_error;
     void* user_data;                     // User data for callbacks
 } DeviceManagerConfig;
 
-/* Initialize device manager */
+/* Duplicate filter counters (filter_duplicates) */
+typedef struct {
+    uint64_t received;                   // Device updates seen by the filter
+    uint64_t suppressed;                 // Dropped as duplicates before touching the table
+} DuplicateFilterStats;
+
+/* Signal routing counters - a low rejected count means the bus daemon's
+ * match rules are doing the filtering */
+typedef struct {
+    uint64_t signals_received;           // Signals delivered to the manager
+    uint64_t signals_rejected;           // ...that turned out not to be about our devices
+} BusFilterStats;
+
+/* Runtime metrics */
+typedef struct {
+    uint64_t signals_received;           // Signals delivered to the manager
+    uint64_t signals_interfaces_added;
+    uint64_t signals_properties_changed;
+    uint64_t signals_rejected;           // Not about our devices
+    uint64_t updates_suppressed;         // Dropped by the duplicate filter
+    uint64_t adapters;                   // Adapters present right now
+    uint64_t devices;                    // Devices in the table right now, once per adapter seeing them
+    uint64_t devices_lost;               // Evicted or expired
+    uint64_t snapshots_published;
+    LatencyStats parse;                  // Decoding the properties of one signal
+    LatencyStats lock_wait;              // Waiting for the manager lock
+    LatencyStats lock_hold;              // Holding it
+    uint64_t callbacks_dropped;          // Events lost to a full callback queue
+    LatencyStats callback_delay;         // From an event to its callback starting
+} DeviceManagerStats;
+
+/* Initialize device manager. Devices bluetoothd already knows (paired,
+ * trusted, connected or cached) are loaded up front and show up in
+ * snapshots right away; on_discovered only reports devices found later. */
 DeviceManager* device_manager_create(const DeviceManagerConfig* config);
 
-/* Start device discovery */
+/* Start device discovery on every adapter at once, and on adapters plugged
+ * in while it runs; succeeds if any adapter started. With scan_duration
+ * set, the scan stops by itself after that many seconds and, if
+ * scan_interval is longer, starts again every scan_interval seconds until
+ * stopped. on_scan_status reports every
+ * start and stop of the radio. */
 ErrorCode device_manager_start_discovery(DeviceManager* manager);
 
+/* Set the filter bluetoothd applies to our discovery (NULL clears it).
+ * It is sent right away and again before every scan window. */
+ErrorCode device_manager_set_discovery_filter(DeviceManager* manager, const DiscoveryFilter* filter);
+
+/* Scan right away for duration_ms, whatever the schedule. A duty-cycled
+ * session resumes its schedule afterwards; with no session running, the
+ * scan simply ends. */
+ErrorCode device_manager_scan_burst(DeviceManager* manager, int duration_ms);
+
 /* Stop device discovery */
 ErrorCode device_manager_stop_discovery(DeviceManager* manager);
 
-/* Get discovered devices */
+/* Fill up to max entries of adapters, in the order they were found, and
+ * return how many adapters the manager has seen (present or not) */
+size_t device_manager_get_adapters(DeviceManager* manager, AdapterInfo* adapters, size_t max);
+
+/* Get discovered devices as copies the caller owns, name and alias
+ * included; free with g_list_free_full(list, free). Prefer
+ * device_manager_snapshot(), which does not stall signal processing. */
 GList* device_manager_get_devices(DeviceManager* manager);
 
-/* Get device by address */
+/* Current device snapshot in O(1), never blocking on the dispatcher.
+ * The bus thread publishes a new version at most every
+ * snapshot_interval_ms after a change. Release with device_snapshot_unref()
+ * before destroying the manager. */
+DeviceSnapshot* device_manager_snapshot(DeviceManager* manager);
+
+/* Number of devices in a snapshot */
+size_t device_snapshot_count(const DeviceSnapshot* snapshot);
+
+/* Device at index (sorted by address), NULL if out of range. It and its
+ * strings belong to the snapshot. */
+const BluetoothDevice* device_snapshot_get(const DeviceSnapshot* snapshot, size_t index);
+
+/* Device by address, NULL if absent */
+const BluetoothDevice* device_snapshot_find(const DeviceSnapshot* snapshot, const char* address);
+
+/* Version counter, increases with every published snapshot */
+uint64_t device_snapshot_version(const DeviceSnapshot* snapshot);
+
+/* Take another reference */
+DeviceSnapshot* device_snapshot_ref(DeviceSnapshot* snapshot);
+
+/* Drop a reference */
+void device_snapshot_unref(DeviceSnapshot* snapshot);
+
+/* Get a copy of a device by address that the caller owns, name and alias
+ * included (truncated to DEVICE_STRING_MAX); free() it. NULL if unknown. */
 BluetoothDevice* device_manager_get_device(DeviceManager* manager, const char* address);
 
+/* Copy the current state of one device into out without taking any lock.
+ * Unlike snapshots there is no publish delay; safe from any thread. The
+ * name and alias (truncated to DEVICE_STRING_MAX) are kept per thread and
+ * stay valid until the same thread calls this again.
+ * Returns false if the device is unknown. */
+bool device_manager_read_device(DeviceManager* manager, const char* address, BluetoothDevice* out);
+
+/* Fill up to max sightings of one device, one per adapter that knows it, in
+ * adapter order, and return how many adapters know it */
+size_t device_manager_get_sightings(DeviceManager* manager, const char* address,
+                                    DeviceSighting* sightings, size_t max);
+
+/* Get duplicate filter counters */
+ErrorCode device_manager_get_filter_stats(DeviceManager* manager, DuplicateFilterStats* stats);
+
+/* Get signal routing counters */
+ErrorCode device_manager_get_bus_stats(DeviceManager* manager, BusFilterStats* stats);
+
+/* Get runtime metrics */
+ErrorCode device_manager_get_stats(DeviceManager* manager, DeviceManagerStats* stats);
+
+/* Write the metrics in Prometheus text format to fd (a file, pipe or
+ * socket, e.g. one accepted from a scrape listener) */
+ErrorCode device_manager_write_metrics(DeviceManager* manager, int fd);
+
 /* Set device alias */
 ErrorCode device_manager_set_alias(DeviceManager* manager, const char* address, const char* alias);
 
-/* Remove device */
+/* Forget a device locally: it leaves the table, snapshots, lock-free reads
+ * and the device cache. bluetoothd keeps its own record, so the device is
+ * found again if it is still around. on_lost is not called. */
 ErrorCode device_manager_remove_device(DeviceManager* manager, const char* address);
 
 /* Cleanup */
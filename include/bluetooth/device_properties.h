@@ -0,0 +1,48 @@
+#ifndef DEVICE_PROPERTIES_H
+#define DEVICE_PROPERTIES_H
+
+#include "common.h"
+#include <dbus/dbus.h>
+
+/*
+ * Table-driven decoder for org.bluez.Device1 property dictionaries.
+ * Property names are resolved with a perfect hash on their length and
+ * first character (one probe and one string compare), and each entry
+ * carries its D-Bus type and a typed setter. To support a new property,
+ * add it to the enum and to the table in device_properties.c.
+ */
+typedef enum {
+    DEVICE_PROP_UNKNOWN = 0,
+    DEVICE_PROP_ADDRESS,
+    DEVICE_PROP_NAME,
+    DEVICE_PROP_ALIAS,
+    DEVICE_PROP_CLASS,
+    DEVICE_PROP_PAIRED,
+    DEVICE_PROP_TRUSTED,
+    DEVICE_PROP_BLOCKED,
+    DEVICE_PROP_RSSI,
+    DEVICE_PROP_CONNECTED,
+    DEVICE_PROP_SERVICES_RESOLVED
+} DeviceProperty;
+
+/* Bit for a property in a decode mask */
+#define DEVICE_PROP_BIT(prop) (1u << (prop))
+
+/* Resolve a property name (DEVICE_PROP_UNKNOWN if not handled) */
+DeviceProperty device_property_lookup(const char* key);
+
+/* Decode an a{sv} dictionary (iter positioned on the array) into device.
+ * Entries with an unexpected variant type are skipped. Strings point into
+ * the message. Returns the DEVICE_PROP_BIT mask of properties decoded. */
+uint32_t device_properties_decode(DBusMessageIter* iter, BluetoothDevice* device);
+
+/* Same, also setting *true_mask to the bits of the boolean properties that
+ * were decoded as true (including ones without a BluetoothDevice field,
+ * such as ServicesResolved) */
+uint32_t device_properties_decode_bools(DBusMessageIter* iter, BluetoothDevice* device,
+                                        uint32_t* true_mask);
+
+/* Map a Bluetooth class of device to a DeviceType */
+DeviceType device_type_from_class(uint32_t class);
+
+#endif /* DEVICE_PROPERTIES_H */
@@ -0,0 +1,44 @@
+#ifndef DEVICE_RECORDS_H
+#define DEVICE_RECORDS_H
+
+#include "common.h"
+#include "bt_addr.h"
+#include "device_store.h"
+
+/*
+ * Lock-free read side for device data. Each store slot has a
+ * seqlock-protected copy of its BluetoothDevice, name and alias included
+ * (truncated to DEVICE_STRING_MAX), in memory that never moves,
+ * and an address index is published with atomic pointer swaps. Readers
+ * never block or write shared memory, so they scale with cores while
+ * the writer keeps updating. A reader that races a write simply retries
+ * the copy.
+ *
+ * Writers (publish/remove) must be serialized by the caller. Tombstones
+ * are compacted in place under a sequence counter; a reader that races a
+ * compaction retries the lookup. Only outgrown index generations are
+ * retired, not freed, until destroy (total <= 2x the final index size), so
+ * a slow reader can never touch freed memory.
+ */
+typedef struct DeviceRecords DeviceRecords;
+
+/* Create an empty directory */
+DeviceRecords* device_records_create(void);
+
+/* Write the record for slot and index its address (writer only) */
+bool device_records_publish(DeviceRecords* records, DeviceSlot slot, bt_addr_t addr,
+                            const BluetoothDevice* device);
+
+/* Drop an address from the index; its slot may be reused afterwards (writer only) */
+void device_records_remove(DeviceRecords* records, bt_addr_t addr);
+
+/* Copy the current record for addr into out, its name and alias into text
+ * (out->name/alias point there; "" if text is NULL). Any thread, never
+ * blocks. Returns false if the address is unknown. */
+bool device_records_read(const DeviceRecords* records, bt_addr_t addr, BluetoothDevice* out,
+                         DeviceStrings* text);
+
+/* Cleanup (no reader may still be running) */
+void device_records_destroy(DeviceRecords* records);
+
+#endif /* DEVICE_RECORDS_H */
@@ -0,0 +1,104 @@
+#ifndef DEVICE_STORE_H
+#define DEVICE_STORE_H
+
+#include "common.h"
+#include "bt_addr.h"
+#include <stddef.h>
+
+/*
+ * Compact device storage. Every device lives in a numbered slot. The fields
+ * touched on every advertisement (address, RSSI, state, type, flags,
+ * last-seen time and age list links) are kept as parallel arrays, 28 bytes
+ * per device, so a sweep over 10k devices stays within ~280 KB. Class,
+ * name, alias and user data live in separate cold arrays, and
+ * names/aliases are interned in a StringArena that
+ * device_store_compact_strings() rebuilds from the live devices.
+ * Devices put on the age list are kept ordered by last-seen time, so the
+ * least recently seen one is found in O(1) for eviction and expiry.
+ * BluetoothDevice is only materialized on demand via device_store_load().
+ * Not thread-safe.
+ */
+typedef struct DeviceStore DeviceStore;
+
+typedef uint32_t DeviceSlot;
+
+#define DEVICE_SLOT_NONE UINT32_MAX
+
+/* Bits of the per-device flags byte */
+#define DEVICE_FLAG_PAIRED  0x01
+#define DEVICE_FLAG_TRUSTED 0x02
+#define DEVICE_FLAG_BLOCKED 0x04
+#define DEVICE_FLAG_USER_ALIAS 0x08    // Alias set through the manager, not by BlueZ
+
+/* Create a store sized for at least capacity_hint devices */
+DeviceStore* device_store_create(size_t capacity_hint);
+
+/* Slot of an address, or DEVICE_SLOT_NONE */
+DeviceSlot device_store_find(const DeviceStore* store, bt_addr_t addr);
+
+/* Add a device with empty fields (name/alias ""), or DEVICE_SLOT_NONE when
+ * out of memory. Adding an address that is already present returns its slot. */
+DeviceSlot device_store_add(DeviceStore* store, bt_addr_t addr);
+
+/* Free a slot for reuse */
+void device_store_remove(DeviceStore* store, DeviceSlot slot);
+
+/* Number of devices */
+size_t device_store_count(const DeviceStore* store);
+
+/* Iterate live slots: start with *cursor = 0, returns DEVICE_SLOT_NONE when done */
+DeviceSlot device_store_next(const DeviceStore* store, DeviceSlot* cursor);
+
+/* Hot field accessors */
+bt_addr_t device_store_addr(const DeviceStore* store, DeviceSlot slot);
+int8_t device_store_rssi(const DeviceStore* store, DeviceSlot slot);
+void device_store_set_rssi(DeviceStore* store, DeviceSlot slot, int8_t rssi);
+ConnectionState device_store_state(const DeviceStore* store, DeviceSlot slot);
+void device_store_set_state(DeviceStore* store, DeviceSlot slot, ConnectionState state);
+DeviceType device_store_type(const DeviceStore* store, DeviceSlot slot);
+void device_store_set_type(DeviceStore* store, DeviceSlot slot, DeviceType type);
+uint8_t device_store_flags(const DeviceStore* store, DeviceSlot slot);
+void device_store_set_flag(DeviceStore* store, DeviceSlot slot, uint8_t flag, bool on);
+
+/* Last-seen time in monotonic ms (0 until touched) */
+uint64_t device_store_last_seen(const DeviceStore* store, DeviceSlot slot);
+
+/* Record a sighting at now_ms, moving an aging device to the newest end */
+void device_store_touch(DeviceStore* store, DeviceSlot slot, uint64_t now_ms);
+
+/* Put a device on the age list or take it off (e.g. once paired) */
+void device_store_set_aging(DeviceStore* store, DeviceSlot slot, bool aging);
+
+/* Least recently seen aging device, or DEVICE_SLOT_NONE */
+DeviceSlot device_store_oldest(const DeviceStore* store);
+
+/* Cold field accessors - strings are interned and stay valid until the
+ * next device_store_compact_strings() that compacts */
+uint32_t device_store_class(const DeviceStore* store, DeviceSlot slot);
+void device_store_set_class(DeviceStore* store, DeviceSlot slot, uint32_t class);
+const char* device_store_name(const DeviceStore* store, DeviceSlot slot);
+bool device_store_set_name(DeviceStore* store, DeviceSlot slot, const char* name);
+const char* device_store_alias(const DeviceStore* store, DeviceSlot slot);
+bool device_store_set_alias(DeviceStore* store, DeviceSlot slot, const char* alias);
+void* device_store_user_data(const DeviceStore* store, DeviceSlot slot);
+void device_store_set_user_data(DeviceStore* store, DeviceSlot slot, void* user_data);
+
+/* Materialize a slot as a BluetoothDevice (name/alias point into the arena) */
+void device_store_load(const DeviceStore* store, DeviceSlot slot, BluetoothDevice* out);
+
+/* Move the strings of live devices into a fresh arena once the arena has
+ * doubled since the last compaction, so the names of removed devices stop
+ * taking memory. Every string pointer taken from the store before is then
+ * invalid. Returns true if it compacted. */
+bool device_store_compact_strings(DeviceStore* store);
+
+/* Bytes used by the hot arrays */
+size_t device_store_hot_bytes(const DeviceStore* store);
+
+/* Bytes used by everything else (cold arrays, address index, string arena) */
+size_t device_store_cold_bytes(const DeviceStore* store);
+
+/* Cleanup */
+void device_store_destroy(DeviceStore* store);
+
+#endif /* DEVICE_STORE_H */
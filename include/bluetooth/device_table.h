@@ -0,0 +1,48 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include "common.h"
+#include "bt_addr.h"
+#include <stddef.h>
+
+/*
+ * Open-addressing hash table keyed by bt_addr_t. Keys sit in their own
+ * array and are probed linearly, so a lookup touches one or two cache
+ * lines and never allocates or compares strings. Deletion shifts later
+ * entries back instead of leaving tombstones. Not thread-safe.
+ */
+typedef struct DeviceTable DeviceTable;
+
+/* Value destructor for clear/destroy */
+typedef void (*DeviceTableFreeFunc)(void* value);
+
+/* Create a table sized for at least capacity_hint entries */
+DeviceTable* device_table_create(size_t capacity_hint);
+
+/* Find the value stored for an address (NULL if absent) */
+void* device_table_lookup(const DeviceTable* table, bt_addr_t key);
+
+/* Insert or replace. The previous value (or NULL) is returned through
+ * replaced when given. Fails only when growing the table runs out of memory. */
+bool device_table_insert(DeviceTable* table, bt_addr_t key, void* value, void** replaced);
+
+/* Remove an address and return its value (NULL if absent) */
+void* device_table_remove(DeviceTable* table, bt_addr_t key);
+
+/* Number of entries */
+size_t device_table_count(const DeviceTable* table);
+
+/* Bytes held by the slot arrays */
+size_t device_table_bytes(const DeviceTable* table);
+
+/* Iterate: start with *cursor = 0, returns false when done.
+ * The table must not be modified during iteration. */
+bool device_table_next(const DeviceTable* table, size_t* cursor, bt_addr_t* key, void** value);
+
+/* Remove every entry, calling free_value on each value when given */
+void device_table_clear(DeviceTable* table, DeviceTableFreeFunc free_value);
+
+/* Cleanup, calling free_value on each value when given */
+void device_table_destroy(DeviceTable* table, DeviceTableFreeFunc free_value);
+
+#endif /* DEVICE_TABLE_H */
@@ -0,0 +1,72 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include "common.h"
+#include <glib.h>
+
+/* Where queued callbacks run */
+typedef enum {
+    CALLBACK_EXECUTOR_THREAD = 0,        // One dedicated thread, events in order
+    CALLBACK_EXECUTOR_POOL,              // Several threads, no ordering between batches
+    CALLBACK_EXECUTOR_MAIN_CONTEXT       // The thread running a GLib main context
+} CallbackExecutor;
+
+/* What a full queue does with a new event */
+typedef enum {
+    CALLBACK_OVERFLOW_DROP_OLDEST = 0,   // Drop the oldest queued event to make room
+    CALLBACK_OVERFLOW_DROP_NEWEST,       // Drop the new event
+    CALLBACK_OVERFLOW_BLOCK              // The producer waits for room (never a consumer)
+} CallbackOverflow;
+
+/* Device manager event */
+typedef enum {
+    DEVICE_EVENT_DISCOVERED,
+    DEVICE_EVENT_LOST,
+    DEVICE_EVENT_SCAN_STATUS,
+    DEVICE_EVENT_ADAPTER
+} DeviceEventType;
+
+typedef struct {
+    DeviceEventType type;
+    bool active;                         // SCAN_STATUS, ADAPTER (present)
+    const char* adapter;                 // ADAPTER, owned by the producer
+    uint64_t queued_ns;                  // Set by event_queue_push()
+    BluetoothDevice device;              // DISCOVERED/LOST, name/alias set from strings by the consumer
+    DeviceStrings strings;               // Copied in, as events move through the queue
+} DeviceEvent;
+
+/* Consumer, called with up to a batch of events at a time */
+typedef void (*DeviceEventHandler)(DeviceEvent* events, size_t count, void* user_data);
+
+typedef struct {
+    CallbackExecutor executor;
+    GMainContext* context;               // MAIN_CONTEXT (NULL = global default)
+    int threads;                         // POOL size (0 = 4)
+    int capacity;                        // Events held (0 = 1024)
+    CallbackOverflow overflow;
+} EventQueueConfig;
+
+/*
+ * Bounded event queue that hands batches of events to a handler on an
+ * executor, so producers never run user code. Pushing takes a short
+ * internal lock and only waits with CALLBACK_OVERFLOW_BLOCK; a handler
+ * pushing onto its own full queue drops the oldest event instead of
+ * waiting on itself.
+ */
+typedef struct EventQueue EventQueue;
+
+/* Create a queue and start its executor */
+EventQueue* event_queue_create(const EventQueueConfig* config, DeviceEventHandler handler, void* user_data);
+
+/* Queue events in order, applying the overflow policy */
+void event_queue_push(EventQueue* queue, const DeviceEvent* events, size_t count);
+
+/* Events dropped by the overflow policy so far */
+uint64_t event_queue_dropped(EventQueue* queue);
+
+/* Stop the executor. Thread executors deliver what is still queued first;
+ * a main context executor drops it. Waits for a running batch to finish,
+ * so it must not be called from the handler. */
+void event_queue_destroy(EventQueue* queue);
+
+#endif /* EVENT_QUEUE_H */
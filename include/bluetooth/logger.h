@@ -0,0 +1,56 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "common.h"
+
+/*
+ * Asynchronous logger. Messages below LOGGER_LEVEL are compiled out, so
+ * their arguments are never evaluated. Enabled messages are formatted into
+ * a lock-free ring owned by the calling thread and written out by a
+ * background thread, so logging never blocks on stdout/stderr. If a ring
+ * is full the message is dropped and counted instead.
+ * Errors and warnings go to stderr, the rest to stdout.
+ */
+#define LOGGER_LEVEL_ERROR 0
+#define LOGGER_LEVEL_WARN 1
+#define LOGGER_LEVEL_INFO 2
+#define LOGGER_LEVEL_DEBUG 3
+
+/* Most verbose level compiled in (debug builds keep everything) */
+#ifndef LOGGER_LEVEL
+#ifdef DEBUG
+#define LOGGER_LEVEL LOGGER_LEVEL_DEBUG
+#else
+#define LOGGER_LEVEL LOGGER_LEVEL_INFO
+#endif
+#endif
+
+#define LOGGER_MESSAGE_MAX 192            // Longer messages are truncated
+
+/* Queue a message for the writer thread (use the log_* macros instead) */
+void logger_write(int level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+/* Write out everything queued so far; also runs at exit */
+void logger_flush(void);
+
+#define log_error(...) logger_write(LOGGER_LEVEL_ERROR, __VA_ARGS__)
+
+#if LOGGER_LEVEL >= LOGGER_LEVEL_WARN
+#define log_warn(...) logger_write(LOGGER_LEVEL_WARN, __VA_ARGS__)
+#else
+#define log_warn(...) ((void)0)
+#endif
+
+#if LOGGER_LEVEL >= LOGGER_LEVEL_INFO
+#define log_info(...) logger_write(LOGGER_LEVEL_INFO, __VA_ARGS__)
+#else
+#define log_info(...) ((void)0)
+#endif
+
+#if LOGGER_LEVEL >= LOGGER_LEVEL_DEBUG
+#define log_debug(...) logger_write(LOGGER_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define log_debug(...) ((void)0)
+#endif
+
+#endif /* LOGGER_H */
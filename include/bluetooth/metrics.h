@@ -0,0 +1,59 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "common.h"
+#include <stdio.h>
+
+/* Latency distribution in nanoseconds. Percentiles come from log-linear
+ * (HDR-style) buckets and are accurate to within 12.5%. */
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t mean_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+} LatencyStats;
+
+/*
+ * Counters and latency histograms for one component. Every thread updates
+ * its own stripe with relaxed atomics, so recording never contends with
+ * other threads or takes a lock; reads sum the stripes. Values are
+ * addressed by small integer ids chosen by the owner.
+ */
+typedef struct Metrics Metrics;
+
+/* Create a set of counters and histograms, all zero */
+Metrics* metrics_create(size_t counters, size_t histograms);
+
+/* Monotonic clock in nanoseconds, for timing what gets recorded */
+uint64_t metrics_now_ns(void);
+
+/* Add to a counter */
+void metrics_add(Metrics* metrics, size_t counter, uint64_t value);
+
+/* Record one latency sample */
+void metrics_record(Metrics* metrics, size_t histogram, uint64_t ns);
+
+/* Current counter total */
+uint64_t metrics_count(const Metrics* metrics, size_t counter);
+
+/* Summarize a histogram */
+void metrics_latency(const Metrics* metrics, size_t histogram, LatencyStats* stats);
+
+void metrics_destroy(Metrics* metrics);
+
+/* Prometheus text exposition helpers. Latencies become summaries in seconds. */
+void metrics_print_counter(FILE* out, const char* name, const char* help, uint64_t value);
+void metrics_print_gauge(FILE* out, const char* name, const char* help, uint64_t value);
+void metrics_print_latency(FILE* out, const char* name, const char* help, const LatencyStats* stats);
+
+/* Write a complete dump to a file descriptor (file, pipe or socket) */
+bool metrics_write_fd(int fd, const char* text, size_t length);
+
+/* Replace path with a dump atomically (write to path.tmp, then rename) */
+bool metrics_write_file(const char* path, const char* text, size_t length);
+
+#endif /* METRICS_H */
@@ -0,0 +1,27 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include "common.h"
+#include <stddef.h>
+
+/*
+ * Append-only interning arena for device names and aliases. Each distinct
+ * string is stored once in large chunks and handed out as a stable
+ * const char* that lives until the arena is destroyed, so thousands of
+ * devices advertising the same name share one copy. Not thread-safe.
+ */
+typedef struct StringArena StringArena;
+
+/* Create an empty arena */
+StringArena* string_arena_create(void);
+
+/* Return the interned copy of str (NULL is treated as ""), or NULL when out of memory */
+const char* string_arena_intern(StringArena* arena, const char* str);
+
+/* Bytes held by string data and the intern index */
+size_t string_arena_bytes(const StringArena* arena);
+
+/* Cleanup - every interned pointer becomes invalid */
+void string_arena_destroy(StringArena* arena);
+
+#endif /* STRING_ARENA_H */
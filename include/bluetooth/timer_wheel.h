@@ -0,0 +1,57 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "common.h"
+#include <stddef.h>
+
+/*
+ * Hierarchical timing wheel (4 levels x 64 slots). Scheduling, cancelling
+ * and expiring a timer are O(1) no matter how many timers are pending, so
+ * thousands of per-device retries cost no more per tick than one.
+ * Timers are intrusive: the owner embeds a WheelTimer and keeps it alive
+ * while it is scheduled. The wheel itself is not thread-safe.
+ */
+typedef struct TimerWheel TimerWheel;
+
+/* Timer expiry callback */
+typedef void (*WheelTimerCallback)(void* user_data);
+
+/* Timer node, embed in the owning structure */
+typedef struct WheelTimer {
+    struct WheelTimer* next;
+    struct WheelTimer* prev;
+    uint64_t expires;                 // Absolute tick
+    int level;                        // Wheel level, -1 once expired
+    WheelTimerCallback callback;
+    void* user_data;
+    bool armed;                       // Linked into the wheel or its expired list
+} WheelTimer;
+
+/* Prepare a timer before its first use */
+void wheel_timer_init(WheelTimer* timer, WheelTimerCallback callback, void* user_data);
+
+/* Create a wheel with the given tick length, starting at now_ms */
+TimerWheel* timer_wheel_create(uint32_t tick_ms, uint64_t now_ms);
+
+/* (Re)schedule a timer delay_ms after now_ms, rounded up to the next tick */
+void timer_wheel_schedule(TimerWheel* wheel, WheelTimer* timer, uint64_t now_ms, uint64_t delay_ms);
+
+/* Unschedule a timer (no-op if it is not armed) */
+void timer_wheel_cancel(TimerWheel* wheel, WheelTimer* timer);
+
+/* Move the wheel forward to now_ms, queueing expired timers */
+void timer_wheel_advance(TimerWheel* wheel, uint64_t now_ms);
+
+/* Take the next expired timer (disarmed) or NULL; the caller runs its callback */
+WheelTimer* timer_wheel_pop_expired(TimerWheel* wheel);
+
+/* Milliseconds until the wheel next needs advancing (-1 = nothing scheduled) */
+int64_t timer_wheel_next_timeout(TimerWheel* wheel, uint64_t now_ms);
+
+/* Number of armed timers */
+size_t timer_wheel_count(const TimerWheel* wheel);
+
+/* Cleanup (timers still armed are simply forgotten) */
+void timer_wheel_destroy(TimerWheel* wheel);
+
+#endif /* TIMER_WHEEL_H */
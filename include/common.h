@@ -16,7 +16,8 @@ typedef enum {
     ERR_NO_DEVICE = -7,
     ERR_CONNECTION = -8,
     ERR_PAIRING = -9,
-    ERR_TIMEOUT = -10        // Added for timeout errors..
+    ERR_TIMEOUT = -10,       // Added for timeout errors..
+    ERR_CANCELLED = -11      // Asynchronous operation was cancelled
 } ErrorCode;
 
 /* Device types */
@@ -40,11 +41,17 @@ typedef enum {
     STATE_FAILED
 } ConnectionState;
 
-/* Bluetooth device structure */
+/* Longest name or alias a fixed-size copy keeps, NUL included (BlueZ
+ * names are at most 248 bytes) */
+#define DEVICE_STRING_MAX 249
+
+/* Bluetooth device structure - a copy of one device. name and alias are
+ * never NULL; who owns them depends on where the copy came from, see
+ * device_manager.h. */
 typedef struct {
     char address[18];          // MAC address (XX:XX:XX:XX:XX:XX)
-    char name[256];           // Device name
-    char alias[256];          // User-defined alias
+    const char* name;         // Device name
+    const char* alias;        // User-defined alias
     DeviceType type;          // Device type
     ConnectionState state;    // Current connection state
     int8_t rssi;             // Signal strength
@@ -55,8 +62,15 @@ typedef struct {
     void* user_data;         // User-defined data
 } BluetoothDevice;
 
+/* Storage for the name and alias of a BluetoothDevice copy */
+typedef struct {
+    char name[DEVICE_STRING_MAX];
+    char alias[DEVICE_STRING_MAX];
+} DeviceStrings;
+
 /* Callback function types */
 typedef void (*DeviceDiscoveredCallback)(BluetoothDevice* device, void* user_data);
+typedef void (*DeviceLostCallback)(BluetoothDevice* device, void* user_data);
 typedef void (*ScanStatusCallback)(bool scanning, void* user_data);
 typedef void (*ErrorCallback)(ErrorCode error, const char* message, void* user_data);
 
@@ -0,0 +1,79 @@
+#include "bluetooth/bt_addr.h"
+#include <string.h>
+
+/* Hex digit value, or 0xFF for anything else (a lookup, since branching on
+ * digit vs letter mispredicts on random addresses) */
+static const uint8_t hex_value[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+       0,    1,    2,    3,    4,    5,    6,    7,    8,    9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF,   10,   11,   12,   13,   14,   15, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF,   10,   11,   12,   13,   14,   15, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static const char hex_digit[16] = "0123456789ABCDEF";
+
+/* Parse exactly 17 characters; the caller checks what follows */
+static bool parse_17(const unsigned char* s, bt_addr_t* out) {
+    bt_addr_t addr = 0;
+    
+    for (int i = 0; i < 6; i++) {
+        const unsigned char* p = s + i * 3;
+        // Check each character before reading the next so short strings stop at NUL
+        uint8_t hi = hex_value[p[0]];
+        if (hi == 0xFF) return false;
+        uint8_t lo = hex_value[p[1]];
+        if (lo == 0xFF) return false;
+        if (i < 5 && p[2] != ':' && p[2] != '_' && p[2] != '-') return false;
+        addr = (addr << 8) | (bt_addr_t)(hi << 4 | lo);
+    }
+    
+    *out = addr;
+    return true;
+}
+
+bool bt_addr_parse(const char* str, bt_addr_t* out) {
+    if (!str || !out) return false;
+    
+    const unsigned char* s = (const unsigned char*)str;
+    bt_addr_t addr;
+    if (!parse_17(s, &addr) || s[17] != '\0') return false;
+    
+    *out = addr;
+    return true;
+}
+
+bool bt_addr_from_path(const char* path, bt_addr_t* out) {
+    if (!path || !out) return false;
+    
+    const char* dev = strstr(path, "/dev_");
+    if (!dev) return false;
+    
+    const unsigned char* s = (const unsigned char*)dev + 5;
+    bt_addr_t addr;
+    if (!parse_17(s, &addr) || (s[17] != '\0' && s[17] != '/')) return false;
+    
+    *out = addr;
+    return true;
+}
+
+void bt_addr_format(bt_addr_t addr, char out[BT_ADDR_STR_LEN]) {
+    for (int i = 0; i < 6; i++) {
+        uint8_t byte = (uint8_t)(addr >> (40 - i * 8));
+        out[i * 3] = hex_digit[byte >> 4];
+        out[i * 3 + 1] = hex_digit[byte & 0x0F];
+        out[i * 3 + 2] = ':';
+    }
+    out[17] = '\0';
+}
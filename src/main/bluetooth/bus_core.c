@@ -0,0 +1,294 @@
+#include "bluetooth/bus_core.h"
+#include "bluetooth/logger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <glib.h>
+
+#define MAX_ROUTE_HANDLERS 8      // Handlers per interface/member pair
+
+/* One registered handler */
+typedef struct {
+    BusSignalHandler handler;
+    void* user_data;
+} BusHandler;
+
+/* Handlers for one interface/member pair, also the route table key */
+typedef struct {
+    char* interface;
+    char* member;
+    BusHandler handlers[MAX_ROUTE_HANDLERS];
+    size_t count;
+} Route;
+
+/* Internal core structure */
+struct BusCore {
+    int refcount;                 // Under cores_lock
+    DBusConnection* conn;
+    DBusReactor* reactor;
+    pthread_t thread;
+    pthread_mutex_t mutex;        // Guards routes (leaf lock, never held across handlers)
+    GHashTable* routes;           // Route* (keyed by its interface and member) -> same
+};
+
+/* A task handed to the bus thread by bus_core_run() */
+typedef struct {
+    BusTask task;
+    void* data;
+    WheelTimer timer;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool done;
+} BusCall;
+
+static pthread_mutex_t cores_lock = PTHREAD_MUTEX_INITIALIZER;
+static BusCore* shared_core;
+
+static guint route_hash(gconstpointer key) {
+    const Route* route = key;
+    return g_str_hash(route->interface) * 31 + g_str_hash(route->member);
+}
+
+static gboolean route_equal(gconstpointer a, gconstpointer b) {
+    const Route* x = a;
+    const Route* y = b;
+    return strcmp(x->member, y->member) == 0 && strcmp(x->interface, y->interface) == 0;
+}
+
+static void route_free(gpointer data) {
+    Route* route = data;
+    free(route->interface);
+    free(route->member);
+    free(route);
+}
+
+/* Hand each signal to the handlers of its route - runs on the bus thread */
+static DBusHandlerResult route_signal(DBusConnection* conn, DBusMessage* msg, void* data) {
+    (void)conn;
+    BusCore* core = data;
+    
+    if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_SIGNAL) {
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    }
+    
+    Route key = {
+        .interface = (char*)dbus_message_get_interface(msg),
+        .member = (char*)dbus_message_get_member(msg)
+    };
+    if (!key.interface || !key.member) return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+    
+    // Copy so handlers run without the lock and may (un)register others
+    BusHandler handlers[MAX_ROUTE_HANDLERS];
+    size_t count = 0;
+    
+    pthread_mutex_lock(&core->mutex);
+    const Route* route = g_hash_table_lookup(core->routes, &key);
+    if (route) {
+        count = route->count;
+        memcpy(handlers, route->handlers, count * sizeof(BusHandler));
+    }
+    pthread_mutex_unlock(&core->mutex);
+    
+    for (size_t i = 0; i < count; i++) {
+        handlers[i].handler(msg, handlers[i].user_data);
+    }
+    
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void* bus_thread(void* arg) {
+    BusCore* core = arg;
+    
+    log_debug("Bus thread started..");
+    dbus_reactor_run(core->reactor);
+    log_debug("Bus thread exiting..");
+    
+    return NULL;
+}
+
+static void core_free(BusCore* core) {
+    if (core->reactor) {
+        dbus_connection_remove_filter(core->conn, route_signal, core);
+        dbus_reactor_destroy(core->reactor);
+    }
+    if (core->routes) {
+        g_hash_table_destroy(core->routes);
+    }
+    if (core->conn) {
+        // Private connections must be closed before the last unref
+        dbus_connection_close(core->conn);
+        dbus_connection_unref(core->conn);
+    }
+    pthread_mutex_destroy(&core->mutex);
+    free(core);
+}
+
+static BusCore* core_open(void) {
+    BusCore* core = calloc(1, sizeof(BusCore));
+    if (!core) return NULL;
+    
+    if (pthread_mutex_init(&core->mutex, NULL) != 0) {
+        free(core);
+        return NULL;
+    }
+    
+    DBusError error;
+    dbus_error_init(&error);
+    
+    core->conn = dbus_bus_get_private(DBUS_BUS_SYSTEM, &error);
+    if (!core->conn) {
+        log_error("Failed to connect to D-Bus: %s", error.message);
+        dbus_error_free(&error);
+        core_free(core);
+        return NULL;
+    }
+    dbus_connection_set_exit_on_disconnect(core->conn, FALSE);
+    
+    core->routes = g_hash_table_new_full(route_hash, route_equal, route_free, NULL);
+    core->reactor = dbus_reactor_create(core->conn);
+    if (!core->reactor) {
+        core_free(core);
+        return NULL;
+    }
+    if (!dbus_connection_add_filter(core->conn, route_signal, core, NULL)) {
+        dbus_reactor_destroy(core->reactor);
+        core->reactor = NULL;
+        core_free(core);
+        return NULL;
+    }
+    
+    if (pthread_create(&core->thread, NULL, bus_thread, core) != 0) {
+        core_free(core);
+        return NULL;
+    }
+    
+    return core;
+}
+
+BusCore* bus_core_get(void) {
+    pthread_mutex_lock(&cores_lock);
+    if (!shared_core) {
+        shared_core = core_open();
+    }
+    BusCore* core = shared_core;
+    if (core) {
+        core->refcount++;
+    }
+    pthread_mutex_unlock(&cores_lock);
+    
+    return core;
+}
+
+void bus_core_unref(BusCore* core) {
+    if (!core) return;
+    
+    pthread_mutex_lock(&cores_lock);
+    bool last = --core->refcount == 0;
+    if (last) {
+        shared_core = NULL;
+    }
+    pthread_mutex_unlock(&cores_lock);
+    
+    if (!last) return;
+    
+    dbus_reactor_stop(core->reactor);
+    pthread_join(core->thread, NULL);
+    core_free(core);
+}
+
+DBusConnection* bus_core_connection(BusCore* core) {
+    return core ? core->conn : NULL;
+}
+
+DBusReactor* bus_core_reactor(BusCore* core) {
+    return core ? core->reactor : NULL;
+}
+
+bool bus_core_add_handler(BusCore* core, const char* interface, const char* member,
+                          BusSignalHandler handler, void* user_data) {
+    if (!core || !interface || !member || !handler) return false;
+    
+    Route key = { .interface = (char*)interface, .member = (char*)member };
+    bool added = false;
+    
+    pthread_mutex_lock(&core->mutex);
+    Route* route = g_hash_table_lookup(core->routes, &key);
+    if (!route && (route = calloc(1, sizeof(Route))) != NULL) {
+        route->interface = strdup(interface);
+        route->member = strdup(member);
+        if (!route->interface || !route->member) {
+            route_free(route);
+            route = NULL;
+        } else {
+            g_hash_table_insert(core->routes, route, route);
+        }
+    }
+    if (route && route->count < MAX_ROUTE_HANDLERS) {
+        route->handlers[route->count++] = (BusHandler){ handler, user_data };
+        added = true;
+    }
+    pthread_mutex_unlock(&core->mutex);
+    
+    return added;
+}
+
+void bus_core_remove_handlers(BusCore* core, void* user_data) {
+    if (!core) return;
+    
+    pthread_mutex_lock(&core->mutex);
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, core->routes);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        Route* route = key;
+        size_t kept = 0;
+        
+        for (size_t i = 0; i < route->count; i++) {
+            if (route->handlers[i].user_data != user_data) {
+                route->handlers[kept++] = route->handlers[i];
+            }
+        }
+        route->count = kept;
+        if (kept == 0) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+    pthread_mutex_unlock(&core->mutex);
+}
+
+/* Run a bus_core_run() task and wake its caller - on the bus thread */
+static void call_fired(void* data) {
+    BusCall* call = data;
+    call->task(call->data);
+    
+    pthread_mutex_lock(&call->mutex);
+    call->done = true;
+    pthread_cond_signal(&call->cond);
+    pthread_mutex_unlock(&call->mutex);
+}
+
+void bus_core_run(BusCore* core, BusTask task, void* data) {
+    if (!core || !task) return;
+    
+    if (pthread_equal(pthread_self(), core->thread)) {
+        task(data);
+        return;
+    }
+    
+    // The reactor is done with the timer once its callback starts
+    BusCall call = { .task = task, .data = data };
+    pthread_mutex_init(&call.mutex, NULL);
+    pthread_cond_init(&call.cond, NULL);
+    wheel_timer_init(&call.timer, call_fired, &call);
+    
+    dbus_reactor_schedule(core->reactor, &call.timer, 0);
+    
+    pthread_mutex_lock(&call.mutex);
+    while (!call.done) {
+        pthread_cond_wait(&call.cond, &call.mutex);
+    }
+    pthread_mutex_unlock(&call.mutex);
+    
+    pthread_cond_destroy(&call.cond);
+    pthread_mutex_destroy(&call.mutex);
+}
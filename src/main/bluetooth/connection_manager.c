@@ -1,61 +1,422 @@
 #include "bluetooth/connection_manager.h"
+#include "bluetooth/bus_core.h"
+#include "bluetooth/connection_states.h"
+#include "bluetooth/dbus_reactor.h"
+#include "bluetooth/device_properties.h"
+#include "bluetooth/device_table.h"
+#include "bluetooth/logger.h"
+#include "bluetooth/metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 #include <dbus/dbus.h>
 #include <glib.h>
 
 #define BLUEZ_SERVICE "org.bluez"
 #define DEVICE_INTERFACE "org.bluez.Device1"
 #define ADAPTER_INTERFACE "org.bluez.Adapter1"
+#define OBJECT_MANAGER_INTERFACE "org.freedesktop.DBus.ObjectManager"
+#define PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
+#define DEFAULT_METRICS_INTERVAL_MS 10000
+#define DEFAULT_MAX_DEVICES 4096
+#define MAX_DEVICE_OBJECTS 16     // Adapters one address is tracked on
+#define ADAPTER_PATH_MAX 64
+
+/* Device1 properties tracked per object, as DEVICE_PROP_BIT()s */
+#define TRACKED_PROPERTIES (DEVICE_PROP_BIT(DEVICE_PROP_CONNECTED) | \
+                            DEVICE_PROP_BIT(DEVICE_PROP_SERVICES_RESOLVED) | \
+                            DEVICE_PROP_BIT(DEVICE_PROP_PAIRED) | \
+                            DEVICE_PROP_BIT(DEVICE_PROP_TRUSTED))
+
+/* Metrics counters */
+enum {
+    COUNT_SIGNALS_RECEIVED,
+    COUNT_OPERATIONS_STARTED,
+    COUNT_OPERATIONS_FAILED,
+    COUNTER_COUNT
+};
+
+/* Metrics histograms - round trips are indexed by OperationType */
+enum {
+    LATENCY_LOCK_WAIT = OPERATION_TRUST + 1,
+    LATENCY_LOCK_HOLD,
+    LATENCY_COUNT
+};
+
+/* Asynchronous operation in flight on the shared bus connection */
+struct ConnectionOperation {
+    ConnectionManager* manager;
+    OperationType type;
+    char address[18];
+    DBusPendingCall* pending;
+    OperationCallback callback;
+    void* user_data;
+    atomic_int refcount;
+    uint64_t started_ns;      // When the call went out, for the round-trip histogram
+    bool completed;           // Protected by manager->mutex, set exactly once
+};
+
+/* One queued address of a bulk connect */
+typedef struct {
+    ConnectBatch* batch;
+    char address[18];
+    int priority;
+    int8_t rssi;
+    uint64_t seq;             // FIFO tie-break
+    struct AdapterQueue* queue;
+    char* device_path;        // Object on queue's adapter the attempt goes to
+} ScheduledConnect;
+
+/* Per-adapter state: priority queue of scheduled connects and link load */
+typedef struct AdapterQueue {
+    ScheduledConnect** heap;  // Binary max-heap (priority, rssi, then oldest)
+    size_t size;
+    size_t capacity;
+    int in_flight;
+    int links;                // Devices whose link is up on this adapter
+} AdapterQueue;
+
+/* BlueZ Device1 objects for one address, one per adapter, in the order
+ * they appeared */
+typedef struct {
+    char* paths[MAX_DEVICE_OBJECTS];
+    uint16_t flags[MAX_DEVICE_OBJECTS]; // TRACKED_PROPERTIES that are true, per object
+    size_t count;
+    int link;                 // Index of the object whose link is up (-1 = none)
+    StateSlot slot;           // The device's state word in manager->states (NONE = store full)
+} DeviceObjects;
+
+/* Bulk connect request */
+struct ConnectBatch {
+    ConnectionManager* manager;
+    ConnectPolicy policy;
+    ConnectBatchProgress progress;   // Protected by manager->mutex
+    GList* operations;               // ConnectionOperation* in flight for this batch
+    bool cancelled;
+    atomic_int refcount;
+};
+
+/* Auto-reconnect state for one device (lives until the manager is destroyed) */
+typedef struct {
+    struct ConnectionManager* manager;
+    char address[18];
+    WheelTimer timer;         // Backoff timer on the reactor's wheel
+    ConnectionOperation* attempt;  // Reconnect in flight (owned reference) or NULL
+    bool wanted;              // BlueZ reported the link up and nobody asked to drop it
+    bool user_disconnected;   // Dropped on purpose, ignore links until the next connect request
+    ReconnectStats stats;
+} ReconnectEntry;
 
 /* Internal connection manager structure */
 struct ConnectionManager {
     ConnectionManagerConfig config;
-    DBusConnection* conn;
+    BusCore* bus;             // Shared connection and bus thread
+    DBusConnection* conn;     // The bus core's
+    DBusReactor* reactor;     // The bus core's, for our timers
+    size_t match_count;       // Leading entries of match_rules added at create
     pthread_mutex_t mutex;
-    GHashTable* connections;  // device_address -> ConnectionState
+    uint64_t locked_at_ns;    // When mutex was last taken (under mutex)
+    Metrics* metrics;
+    WheelTimer metrics_timer; // Rewrites config.metrics_path
+    DeviceTable* device_objects; // bt_addr_t -> DeviceObjects*
+    ConnectionStates* states; // bt_addr_t -> state word, read and moved without the lock
+    int links;                // Devices with a link up
+    GHashTable* operations;   // In-flight ConnectionOperation* (set)
+    GHashTable* adapter_queues; // adapter path -> AdapterQueue* (bulk connect scheduler, link counts)
+    uint64_t schedule_seq;
+    size_t next_adapter;      // ADAPTER_SELECT_ROUND_ROBIN turn
+    bool closing;             // Set by destroy, stops the scheduler starting new attempts
+    DeviceTable* reconnects;   // bt_addr_t -> ReconnectEntry*
+    unsigned int jitter_seed; // rand_r() state for backoff jitter (under mutex)
     ConnectionStateCallback state_callback;
     PairingCallback pairing_callback;
     void* pairing_user_data;
 };
 
-/* Helper to convert address to device path format */
-static char* address_to_path(const char* address) {
-    char path[256];
-    snprintf(path, sizeof(path), "/org/bluez/hci0/dev_%s", address);
+/* Take manager->mutex, recording how long we waited for it */
+static void lock_manager(ConnectionManager* manager) {
+    uint64_t start = metrics_now_ns();
+    pthread_mutex_lock(&manager->mutex);
+    manager->locked_at_ns = metrics_now_ns();
+    metrics_record(manager->metrics, LATENCY_LOCK_WAIT, manager->locked_at_ns - start);
+}
+
+/* Release manager->mutex, recording how long it was held */
+static void unlock_manager(ConnectionManager* manager) {
+    uint64_t held = metrics_now_ns() - manager->locked_at_ns;
+    pthread_mutex_unlock(&manager->mutex);
+    metrics_record(manager->metrics, LATENCY_LOCK_HOLD, held);
+}
+
+/* Blocking Device1 call, counted and timed like an async operation */
+static DBusMessage* call_blocking(ConnectionManager* manager, OperationType type,
+                                  DBusMessage* msg, int timeout_ms, DBusError* error) {
+    metrics_add(manager->metrics, COUNT_OPERATIONS_STARTED, 1);
     
-    // Replace colons with underscores
-    for (char* p = path; *p; p++) {
-        if (*p == ':') *p = '_';
+    uint64_t start = metrics_now_ns();
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, timeout_ms, error);
+    metrics_record(manager->metrics, type, metrics_now_ns() - start);
+    
+    if (!reply) {
+        metrics_add(manager->metrics, COUNT_OPERATIONS_FAILED, 1);
+    }
+    return reply;
+}
+
+/* Normalize an address to the upper-case form BlueZ reports */
+static void normalize_address(const char* address, char out[18]) {
+    size_t i;
+    for (i = 0; i < 17 && address[i]; i++) {
+        out[i] = (char)toupper((unsigned char)address[i]);
     }
+    out[i] = '\0';
+}
+
+/* Length of the adapter part of a device object path, e.g. /org/bluez/hci1 */
+static size_t adapter_path_len(const char* device_path) {
+    const char* dev = strstr(device_path, "/dev_");
+    return dev ? (size_t)(dev - device_path) : strlen(device_path);
+}
+
+/* Per-adapter state of the adapter owning a device object (manager->mutex held) */
+static AdapterQueue* adapter_state(ConnectionManager* manager, const char* device_path, bool create) {
+    char adapter[ADAPTER_PATH_MAX];
+    size_t len = adapter_path_len(device_path);
+    if (len >= sizeof(adapter)) return NULL;
+    
+    memcpy(adapter, device_path, len);
+    adapter[len] = '\0';
+    
+    AdapterQueue* queue = g_hash_table_lookup(manager->adapter_queues, adapter);
+    if (!queue && create) {
+        queue = calloc(1, sizeof(AdapterQueue));
+        char* key = strdup(adapter);
+        if (!queue || !key) {
+            free(queue);
+            free(key);
+            return NULL;
+        }
+        g_hash_table_insert(manager->adapter_queues, key, queue);
+    }
+    return queue;
+}
+
+/* Index of an object path in objects, -1 if absent */
+static int find_object(const DeviceObjects* objects, const char* object_path) {
+    for (size_t i = 0; i < objects->count; i++) {
+        if (strcmp(objects->paths[i], object_path) == 0) return (int)i;
+    }
+    return -1;
+}
+
+/* Index of the object under an adapter path, -1 if absent */
+static int find_adapter_object(const DeviceObjects* objects, const char* adapter_path) {
+    size_t len = strlen(adapter_path);
+    for (size_t i = 0; i < objects->count; i++) {
+        if (adapter_path_len(objects->paths[i]) == len &&
+            strncmp(objects->paths[i], adapter_path, len) == 0) return (int)i;
+    }
+    return -1;
+}
+
+/* Record the device's link as up on objects->paths[index], or as down
+ * there, keeping the link counts in step (manager->mutex held). Returns
+ * false if that is what was recorded already. */
+static bool set_link(ConnectionManager* manager, DeviceObjects* objects, int index, bool up) {
+    if (up ? objects->link == index : objects->link != index) return false;
+    
+    if (objects->link >= 0) {
+        AdapterQueue* queue = adapter_state(manager, objects->paths[objects->link], false);
+        if (queue && queue->links > 0) queue->links--;
+        manager->links--;
+    }
+    objects->link = up ? index : -1;
+    if (up) {
+        AdapterQueue* queue = adapter_state(manager, objects->paths[index], true);
+        if (queue) queue->links++;
+        manager->links++;
+    }
+    return true;
+}
+
+/* Store the tracked properties decoded for one object */
+static void set_object_flags(DeviceObjects* objects, int index, uint32_t decoded, uint32_t truths) {
+    uint32_t changed = decoded & TRACKED_PROPERTIES;
+    uint32_t flags = (objects->flags[index] & ~changed) | (truths & changed);
+    
+    // BlueZ clears ServicesResolved when the link goes, don't depend on the order
+    if (!(flags & DEVICE_PROP_BIT(DEVICE_PROP_CONNECTED))) {
+        flags &= ~DEVICE_PROP_BIT(DEVICE_PROP_SERVICES_RESOLVED);
+    }
+    objects->flags[index] = (uint16_t)flags;
+}
+
+/* The STATE_WORD_* flags of a device (manager->mutex held) */
+static uint32_t word_flags(const DeviceObjects* objects) {
+    uint32_t flags = 0;
+    uint32_t any = 0;
+    
+    for (size_t i = 0; i < objects->count; i++) {
+        any |= objects->flags[i];
+    }
+    if (objects->link >= 0) {
+        flags |= STATE_WORD_CONNECTED;
+        if (objects->flags[objects->link] & DEVICE_PROP_BIT(DEVICE_PROP_SERVICES_RESOLVED)) {
+            flags |= STATE_WORD_RESOLVED;
+        }
+    }
+    if (any & DEVICE_PROP_BIT(DEVICE_PROP_PAIRED)) flags |= STATE_WORD_PAIRED;
+    if (any & DEVICE_PROP_BIT(DEVICE_PROP_TRUSTED)) flags |= STATE_WORD_TRUSTED;
+    return flags;
+}
+
+/* Publish a device's flags to its state word after a signal and, if its
+ * link moved, the state the link is in. manager->mutex held, which keeps
+ * the slot ours. Returns true if the state changed, setting *state. */
+static bool publish_state(ConnectionManager* manager, const DeviceObjects* objects,
+                          bool moved, ConnectionState* state) {
+    if (objects->slot == STATE_SLOT_NONE) return false;
+    
+    uint32_t flags = word_flags(objects);
+    uint32_t word = connection_states_load(manager->states, objects->slot);
+    do {
+        *state = (ConnectionState)(word & STATE_WORD_STATE);
+        if (moved) {
+            *state = (flags & STATE_WORD_CONNECTED) ? STATE_CONNECTED : STATE_DISCONNECTED;
+        }
+    } while (!connection_states_exchange(manager->states, objects->slot, &word, flags | (uint32_t)*state));
     
-    return strdup(path);
+    return (word & STATE_WORD_STATE) != (uint32_t)*state;
 }
 
-/* Helper to get device path from BlueZ */
-static char* get_device_path(ConnectionManager* manager, const char* address) {
+/* Hand a state change to state_callback - never with manager->mutex held.
+ * Changes are made by compare-and-swap from the bus thread and from
+ * callers, then reported outside of it, so a report can be overtaken by a
+ * later change and its report (a caller's CONNECTING after the bus thread
+ * saw CONNECTED). The word is read again first and a state that is no
+ * longer current is not reported; the change that replaced it is. */
+static void report_state(ConnectionManager* manager, bt_addr_t addr, ConnectionState state) {
+    if (!manager->state_callback) return;
+    
+    uint32_t word;
+    if (connection_states_find(manager->states, addr, &word) != STATE_SLOT_NONE &&
+        (word & STATE_WORD_STATE) != (uint32_t)state) {
+        return;
+    }
+    
+    char address[BT_ADDR_STR_LEN];
+    bt_addr_format(addr, address);
+    manager->state_callback(address, state, manager->config.user_data);
+}
+
+static void device_objects_free(void* data) {
+    DeviceObjects* objects = data;
+    for (size_t i = 0; i < objects->count; i++) {
+        free(objects->paths[i]);
+    }
+    free(objects);
+}
+
+/* Add a Device1 object to the index from its property dict */
+static void index_device_object(ConnectionManager* manager,
+                                const char* object_path,
+                                DBusMessageIter* props_iter) {
+    BluetoothDevice device = {0};
+    uint32_t truths = 0;
+    uint32_t decoded = device_properties_decode_bools(props_iter, &device, &truths);
+    bt_addr_t addr;
+    bool notify = false;
+    
+    if (!(decoded & DEVICE_PROP_BIT(DEVICE_PROP_ADDRESS)) || !bt_addr_parse(device.address, &addr)) return;
+    
+    lock_manager(manager);
+    
+    DeviceObjects* objects = device_table_lookup(manager->device_objects, addr);
+    if (!objects && (objects = calloc(1, sizeof(DeviceObjects))) != NULL) {
+        objects->link = -1;
+        objects->slot = STATE_SLOT_NONE;
+        if (!device_table_insert(manager->device_objects, addr, objects, NULL)) {
+            free(objects);
+            objects = NULL;
+        }
+    }
+    if (objects && objects->slot == STATE_SLOT_NONE) {
+        objects->slot = connection_states_add(manager->states, addr);
+        if (objects->slot == STATE_SLOT_NONE) {
+            log_warn("Connection state store full, not tracking %s", device.address);
+        }
+    }
+    
+    ConnectionState state = STATE_DISCONNECTED;
+    if (objects) {
+        int index = find_object(objects, object_path);
+        if (index < 0 && objects->count < MAX_DEVICE_OBJECTS &&
+            (objects->paths[objects->count] = strdup(object_path)) != NULL) {
+            index = (int)objects->count++;
+        }
+        if (index >= 0) {
+            set_object_flags(objects, index, decoded, truths);
+            bool moved = device.state == STATE_CONNECTED && set_link(manager, objects, index, true);
+            notify = publish_state(manager, objects, moved, &state);
+        }
+    }
+    
+    unlock_manager(manager);
+    
+    if (notify) {
+        report_state(manager, addr, state);
+    }
+}
+
+/* Walk an a{sa{sv}} interface dict and index it if it carries Device1 */
+static void index_object_interfaces(ConnectionManager* manager,
+                                    const char* object_path,
+                                    DBusMessageIter* ifaces_iter) {
+    DBusMessageIter iface_iter;
+    dbus_message_iter_recurse(ifaces_iter, &iface_iter);
+    
+    while (dbus_message_iter_get_arg_type(&iface_iter) == DBUS_TYPE_DICT_ENTRY) {
+        DBusMessageIter iface_entry;
+        char *interface = NULL;
+        
+        dbus_message_iter_recurse(&iface_iter, &iface_entry);
+        dbus_message_iter_get_basic(&iface_entry, &interface);
+        
+        if (strcmp(interface, DEVICE_INTERFACE) == 0) {
+            dbus_message_iter_next(&iface_entry);
+            index_device_object(manager, object_path, &iface_entry);
+            return;
+        }
+        
+        dbus_message_iter_next(&iface_iter);
+    }
+}
+
+/* Fill the path index from a single GetManagedObjects call */
+static ErrorCode load_device_paths(ConnectionManager* manager) {
     DBusError error;
     DBusMessage *msg, *reply;
-    char *device_path = NULL;
     
     dbus_error_init(&error);
     
     msg = dbus_message_new_method_call(BLUEZ_SERVICE,
                                        "/",
-                                       "org.freedesktop.DBus.ObjectManager",
+                                       OBJECT_MANAGER_INTERFACE,
                                        "GetManagedObjects");
+    if (!msg) return ERR_DBUS;
     
     reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 3000, &error);
     dbus_message_unref(msg);
     
     if (!reply) {
-        printf("DEBUG: GetManagedObjects failed: %s\n", error.message);
+        log_error("GetManagedObjects failed: %s", error.message);
         dbus_error_free(&error);
-        // Fall back to constructed path
-        return address_to_path(address);
+        return ERR_BLUEZ;
     }
     
     DBusMessageIter iter, array_iter;
@@ -65,76 +426,952 @@ static char* get_device_path(ConnectionManager* manager, const char* address) {
         dbus_message_iter_recurse(&iter, &array_iter);
         
         while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_DICT_ENTRY) {
-            DBusMessageIter entry_iter, iface_iter;
+            DBusMessageIter entry_iter;
             char *object_path = NULL;
             
             dbus_message_iter_recurse(&array_iter, &entry_iter);
             dbus_message_iter_get_basic(&entry_iter, &object_path);
-            
-            // Check if this path matches our device
             dbus_message_iter_next(&entry_iter);
-            dbus_message_iter_recurse(&entry_iter, &iface_iter);
             
-            while (dbus_message_iter_get_arg_type(&iface_iter) == DBUS_TYPE_DICT_ENTRY) {
-                DBusMessageIter iface_entry;
-                char *interface = NULL;
-                
-                dbus_message_iter_recurse(&iface_iter, &iface_entry);
-                dbus_message_iter_get_basic(&iface_entry, &interface);
-                
-                if (strcmp(interface, DEVICE_INTERFACE) == 0) {
-                    // Found a device, check if it matches our address
-                    char* addr_in_path = strrchr(object_path, '/');
-                    if (addr_in_path) {
-                        addr_in_path++; // Skip the '/'
-                        
-                        // Convert dev_XX_XX_XX to XX:XX:XX format
-                        char converted[18];
-                        int j = 0;
-                        for (int i = 4; addr_in_path[i] && j < 17; i++) {
-                            if (addr_in_path[i] == '_') {
-                                converted[j++] = ':';
-                            } else {
-                                converted[j++] = addr_in_path[i];
-                            }
-                        }
-                        converted[j] = '\0';
-                        
-                        if (strcasecmp(converted, address) == 0) {
-                            device_path = strdup(object_path);
-                            dbus_message_unref(reply);
-                            return device_path;
-                        }
-                    }
-                }
-                
-                dbus_message_iter_next(&iface_iter);
-            }
+            index_object_interfaces(manager, object_path, &entry_iter);
             
             dbus_message_iter_next(&array_iter);
         }
     }
     
     dbus_message_unref(reply);
+    return SUCCESS;
+}
+
+/* Drop a removed Device1 object from the index */
+static void handle_interfaces_removed(ConnectionManager* manager, DBusMessage* message) {
+    DBusMessageIter iter, array_iter;
+    char *object_path = NULL;
+    
+    dbus_message_iter_init(message, &iter);
+    dbus_message_iter_get_basic(&iter, &object_path);
+    dbus_message_iter_next(&iter);
+    
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) return;
+    dbus_message_iter_recurse(&iter, &array_iter);
+    
+    while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_STRING) {
+        char *interface = NULL;
+        dbus_message_iter_get_basic(&array_iter, &interface);
+        
+        if (strcmp(interface, DEVICE_INTERFACE) == 0) {
+            bt_addr_t addr;
+            if (!bt_addr_from_path(object_path, &addr)) return;
+            
+            DeviceObjects* removed = NULL;
+            bool notify = false;
+            ConnectionState state = STATE_DISCONNECTED;
+            
+            lock_manager(manager);
+            DeviceObjects* objects = device_table_lookup(manager->device_objects, addr);
+            int index = objects ? find_object(objects, object_path) : -1;
+            if (index >= 0) {
+                bool moved = set_link(manager, objects, index, false);
+                free(objects->paths[index]);
+                objects->count--;
+                memmove(&objects->paths[index], &objects->paths[index + 1],
+                        (objects->count - (size_t)index) * sizeof(char*));
+                memmove(&objects->flags[index], &objects->flags[index + 1],
+                        (objects->count - (size_t)index) * sizeof(uint16_t));
+                if (objects->link > index) objects->link--;
+                notify = publish_state(manager, objects, moved, &state);
+                if (objects->count == 0) {
+                    connection_states_remove(manager->states, addr);
+                    removed = device_table_remove(manager->device_objects, addr);
+                }
+            }
+            unlock_manager(manager);
+            
+            free(removed);
+            if (notify) {
+                report_state(manager, addr, state);
+            }
+            return;
+        }
+        
+        dbus_message_iter_next(&array_iter);
+    }
+}
+
+static void handle_link_change(ConnectionManager* manager, bt_addr_t addr, bool connected);
+
+/* Track Connected, ServicesResolved, Paired and Trusted from a Device1
+ * PropertiesChanged signal; link changes move the device's state */
+static void handle_properties_changed(ConnectionManager* manager, DBusMessage* message) {
+    const char* object_path = dbus_message_get_path(message);
+    bt_addr_t addr;
+    if (!bt_addr_from_path(object_path, &addr)) return;
+    
+    DBusMessageIter iter;
+    char *interface_name = NULL;
+    
+    dbus_message_iter_init(message, &iter);
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING) return;
+    dbus_message_iter_get_basic(&iter, &interface_name);
+    if (strcmp(interface_name, DEVICE_INTERFACE) != 0) return;
+    
+    dbus_message_iter_next(&iter);
+    
+    BluetoothDevice device = {0};
+    uint32_t truths = 0;
+    uint32_t decoded = device_properties_decode_bools(&iter, &device, &truths) & TRACKED_PROPERTIES;
+    if (!decoded) return;
+    
+    bool link_changed = decoded & DEVICE_PROP_BIT(DEVICE_PROP_CONNECTED);
+    bool connected = device.state == STATE_CONNECTED;
+    bool notify = false;
+    ConnectionState state = STATE_DISCONNECTED;
+    
+    lock_manager(manager);
+    DeviceObjects* objects = device_table_lookup(manager->device_objects, addr);
+    int index = objects ? find_object(objects, object_path) : -1;
+    if (index >= 0) {
+        set_object_flags(objects, index, decoded, truths);
+        bool moved = link_changed && set_link(manager, objects, index, connected);
+        notify = publish_state(manager, objects, moved, &state);
+    }
+    unlock_manager(manager);
+    
+    if (notify) {
+        report_state(manager, addr, state);
+    }
+    if (link_changed) {
+        handle_link_change(manager, addr, connected);
+    }
+}
+
+/* Signal handlers keeping the path index and link state current, routed
+ * by the bus core - run on the bus thread */
+
+static void on_interfaces_added(DBusMessage* msg, void* data) {
+    ConnectionManager* manager = data;
+    DBusMessageIter iter;
+    char *object_path = NULL;
+    
+    metrics_add(manager->metrics, COUNT_SIGNALS_RECEIVED, 1);
+    
+    dbus_message_iter_init(msg, &iter);
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_OBJECT_PATH) return;
+    dbus_message_iter_get_basic(&iter, &object_path);
+    dbus_message_iter_next(&iter);
+    
+    if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_ARRAY) {
+        index_object_interfaces(manager, object_path, &iter);
+    }
+}
+
+static void on_interfaces_removed(DBusMessage* msg, void* data) {
+    ConnectionManager* manager = data;
+    metrics_add(manager->metrics, COUNT_SIGNALS_RECEIVED, 1);
+    handle_interfaces_removed(manager, msg);
+}
+
+static void on_properties_changed(DBusMessage* msg, void* data) {
+    ConnectionManager* manager = data;
+    metrics_add(manager->metrics, COUNT_SIGNALS_RECEIVED, 1);
+    handle_properties_changed(manager, msg);
+}
+
+/* Match rules for the signals above */
+static const char* const match_rules[] = {
+    "type='signal',sender='" BLUEZ_SERVICE "',"
+    "interface='" OBJECT_MANAGER_INTERFACE "',member='InterfacesAdded'",
+    "type='signal',sender='" BLUEZ_SERVICE "',"
+    "interface='" OBJECT_MANAGER_INTERFACE "',member='InterfacesRemoved'",
+    "type='signal',sender='" BLUEZ_SERVICE "',"
+    "interface='" PROPERTIES_INTERFACE "',member='PropertiesChanged',"
+    "arg0='" DEVICE_INTERFACE "'"
+};
+
+/* Render every metric in Prometheus text format into a malloc'd buffer */
+static bool format_metrics(ConnectionManager* manager, char** text, size_t* length) {
+    ConnectionManagerStats stats;
+    connection_manager_get_stats(manager, &stats);
+    
+    FILE* out = open_memstream(text, length);
+    if (!out) return false;
+    
+    metrics_print_counter(out, "blueteeth_cm_signals_total", "Signals delivered to the connection manager",
+                          stats.signals_received);
+    metrics_print_counter(out, "blueteeth_cm_operations_total", "Connect/Disconnect/Pair/Trust calls",
+                          stats.operations_started);
+    metrics_print_counter(out, "blueteeth_cm_operations_failed_total", "Calls that failed or timed out",
+                          stats.operations_failed);
+    metrics_print_gauge(out, "blueteeth_cm_connections", "Devices with a link up",
+                        stats.connections);
+    metrics_print_latency(out, "blueteeth_cm_connect_seconds", "Connect round trip", &stats.connect_rtt);
+    metrics_print_latency(out, "blueteeth_cm_disconnect_seconds", "Disconnect round trip",
+                          &stats.disconnect_rtt);
+    metrics_print_latency(out, "blueteeth_cm_pair_seconds", "Pair round trip", &stats.pair_rtt);
+    metrics_print_latency(out, "blueteeth_cm_trust_seconds", "Trust round trip", &stats.trust_rtt);
+    metrics_print_latency(out, "blueteeth_cm_lock_wait_seconds", "Time waiting for the manager lock",
+                          &stats.lock_wait);
+    metrics_print_latency(out, "blueteeth_cm_lock_hold_seconds", "Time holding the manager lock",
+                          &stats.lock_hold);
+    
+    return fclose(out) == 0;
+}
+
+/* Rewrite config.metrics_path and re-arm - runs on the bus thread */
+static void metrics_timer_fired(void* data) {
+    ConnectionManager* manager = data;
+    char* text = NULL;
+    size_t length = 0;
+    
+    if (format_metrics(manager, &text, &length) &&
+        !metrics_write_file(manager->config.metrics_path, text, length)) {
+        log_warn("Could not write metrics to %s", manager->config.metrics_path);
+    }
+    free(text);
     
-    // If not found in managed objects, construct path
-    return address_to_path(address);
+    int interval = manager->config.metrics_interval_ms > 0 ?
+                   manager->config.metrics_interval_ms : DEFAULT_METRICS_INTERVAL_MS;
+    dbus_reactor_schedule(manager->reactor, &manager->metrics_timer, (uint64_t)interval);
+}
+
+/* Stop every handler and timer of ours for good - runs on the bus thread
+ * through bus_core_run(), so none of them is running meanwhile */
+static void detach_from_bus(void* data) {
+    ConnectionManager* manager = data;
+    
+    bus_core_remove_handlers(manager->bus, manager);
+    dbus_reactor_cancel(manager->reactor, &manager->metrics_timer);
+    
+    lock_manager(manager);
+    size_t cursor = 0;
+    void* value;
+    while (device_table_next(manager->reconnects, &cursor, NULL, &value)) {
+        ReconnectEntry* entry = value;
+        dbus_reactor_cancel(manager->reactor, &entry->timer);
+    }
+    unlock_manager(manager);
 }
 
-/* Update connection state */
+/* Pick the object to connect through per config.adapter_selection
+ * (manager->mutex held). sightings were read from config.device_manager
+ * before the lock was taken. */
+static int select_object(ConnectionManager* manager, const DeviceObjects* objects,
+                         const DeviceSighting* sightings, size_t sighting_count) {
+    if (objects->count < 2) return 0;
+    
+    int best = 0;
+    switch (manager->config.adapter_selection) {
+        case ADAPTER_SELECT_BEST_RSSI: {
+            int8_t best_rssi = 0;
+            for (size_t i = 0; i < sighting_count; i++) {
+                if (sightings[i].rssi == 0 || (best_rssi != 0 && sightings[i].rssi <= best_rssi)) continue;
+                int index = find_adapter_object(objects, sightings[i].adapter);
+                if (index >= 0) {
+                    best = index;
+                    best_rssi = sightings[i].rssi;
+                }
+            }
+            break;
+        }
+        case ADAPTER_SELECT_FEWEST_LINKS: {
+            int best_load = INT_MAX;
+            for (size_t i = 0; i < objects->count; i++) {
+                AdapterQueue* queue = adapter_state(manager, objects->paths[i], false);
+                int load = queue ? queue->links + queue->in_flight + (int)queue->size : 0;
+                if (load < best_load) {
+                    best = (int)i;
+                    best_load = load;
+                }
+            }
+            break;
+        }
+        case ADAPTER_SELECT_ROUND_ROBIN:
+            best = (int)(manager->next_adapter++ % objects->count);
+            break;
+        case ADAPTER_SELECT_FIRST:
+        default:
+            break;
+    }
+    return best;
+}
+
+/* Look up the BlueZ object path to send an operation to (no D-Bus traffic).
+ * A device with a link up is reached through that adapter; otherwise
+ * connects and pairing pick one per config.adapter_selection and the rest
+ * use the first. */
+static char* get_device_path(ConnectionManager* manager, const char* address, OperationType type) {
+    bt_addr_t addr;
+    char* device_path = NULL;
+    bool select = type == OPERATION_CONNECT || type == OPERATION_PAIR;
+    DeviceSighting sightings[MAX_DEVICE_OBJECTS];
+    size_t sighting_count = 0;
+    
+    if (bt_addr_parse(address, &addr)) {
+        if (select && manager->config.adapter_selection == ADAPTER_SELECT_BEST_RSSI &&
+            manager->config.device_manager) {
+            sighting_count = device_manager_get_sightings(manager->config.device_manager, address,
+                                                          sightings, MAX_DEVICE_OBJECTS);
+            if (sighting_count > MAX_DEVICE_OBJECTS) sighting_count = MAX_DEVICE_OBJECTS;
+        }
+        
+        lock_manager(manager);
+        const DeviceObjects* objects = device_table_lookup(manager->device_objects, addr);
+        if (objects && objects->count > 0) {
+            int index = 0;
+            if (objects->link >= 0) {
+                index = objects->link;
+            } else if (select) {
+                index = select_object(manager, objects, sightings, sighting_count);
+            }
+            device_path = strdup(objects->paths[index]);
+        }
+        unlock_manager(manager);
+    }
+    
+    if (!device_path) {
+        log_warn("Device %s is not known to BlueZ", address);
+    }
+    
+    return device_path;
+}
+
+/* Build a Properties.Set(Device1.Trusted = true) call */
+static DBusMessage* new_trust_call(const char* device_path) {
+    DBusMessage* msg = dbus_message_new_method_call(BLUEZ_SERVICE,
+                                                    device_path,
+                                                    PROPERTIES_INTERFACE,
+                                                    "Set");
+    if (!msg) return NULL;
+    
+    const char* interface = DEVICE_INTERFACE;
+    const char* property = "Trusted";
+    dbus_bool_t trusted = TRUE;
+    
+    DBusMessageIter iter, value_iter;
+    dbus_message_iter_init_append(msg, &iter);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
+    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &property);
+    
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, "b", &value_iter);
+    dbus_message_iter_append_basic(&value_iter, DBUS_TYPE_BOOLEAN, &trusted);
+    dbus_message_iter_close_container(&iter, &value_iter);
+    
+    return msg;
+}
+
+/* Move a device's state word to state - a compare-and-swap on its slot,
+ * with no lock or allocation - and report the change. With settle, state
+ * is what a finished call asked for, and becomes FAILED unless the call
+ * succeeded or the link got there anyway. */
+static void move_state(ConnectionManager* manager, const char* device_address,
+                       ConnectionState state, bool settle, bool succeeded) {
+    bt_addr_t addr;
+    uint32_t word;
+    if (!bt_addr_parse(device_address, &addr)) return;
+    
+    StateSlot slot = connection_states_find(manager->states, addr, &word);
+    if (slot == STATE_SLOT_NONE) return;
+    
+    uint32_t owner = word & STATE_WORD_OWNER;
+    ConnectionState next;
+    for (;;) {
+        bool linked = word & STATE_WORD_CONNECTED;
+        next = state;
+        if (settle && !succeeded && linked != (state == STATE_CONNECTED)) {
+            next = STATE_FAILED;
+        }
+        if ((word & STATE_WORD_STATE) == (uint32_t)next) return;
+        if (connection_states_exchange(manager->states, slot, &word,
+                                       (word & ~STATE_WORD_STATE) | (uint32_t)next)) break;
+        if ((word & STATE_WORD_OWNER) != owner) return;  // Removed meanwhile
+    }
+    
+    report_state(manager, addr, next);
+}
+
+/* Move a device to CONNECTING or DISCONNECTING as we ask BlueZ to change it */
 static void update_connection_state(ConnectionManager* manager,
                                    const char* device_address,
                                    ConnectionState state) {
-    pthread_mutex_lock(&manager->mutex);
+    move_state(manager, device_address, state, false, true);
+}
+
+/* Settle a device once a connect (want_link) or disconnect returned: on
+ * the state asked for if the call worked or the link got there anyway,
+ * FAILED otherwise. A reply can overtake the Connected signal on its way
+ * to the bus thread, which then confirms the state without a second report. */
+static void settle_connection_state(ConnectionManager* manager,
+                                    const char* device_address,
+                                    bool want_link,
+                                    bool succeeded) {
+    move_state(manager, device_address, want_link ? STATE_CONNECTED : STATE_DISCONNECTED,
+               true, succeeded);
+}
+
+/* Default deadline for each operation type, matching the blocking calls */
+static int default_timeout_ms(ConnectionManager* manager, OperationType type) {
+    switch (type) {
+        case OPERATION_CONNECT:
+            return manager->config.connection_timeout > 0 ?
+                   manager->config.connection_timeout * 1000 : 25000;
+        case OPERATION_PAIR:
+            return 30000;
+        case OPERATION_DISCONNECT:
+        case OPERATION_TRUST:
+        default:
+            return 5000;
+    }
+}
+
+/* Map a D-Bus error reply to our error codes */
+static ErrorCode operation_error_code(OperationType type, const char* error_name) {
+    if (error_name && strcmp(error_name, DBUS_ERROR_NO_REPLY) == 0) {
+        return ERR_TIMEOUT;
+    }
+    
+    switch (type) {
+        case OPERATION_CONNECT:
+        case OPERATION_DISCONNECT:
+            return ERR_CONNECTION;
+        case OPERATION_PAIR:
+            return ERR_PAIRING;
+        case OPERATION_TRUST:
+        default:
+            return ERR_DBUS;
+    }
+}
+
+static void trust_after_pair_done(ConnectionOperation* operation, ErrorCode result,
+                                  const char* error_message, void* user_data) {
+    (void)user_data;
+    if (result != SUCCESS) {
+        log_warn("Auto-trust of %s failed: %s", operation->address,
+                 error_message ? error_message : "unknown error");
+    }
+}
+
+/* Complete an operation exactly once: state, callbacks, then drop the in-flight reference */
+static void finish_operation(ConnectionOperation* operation,
+                             ErrorCode result,
+                             const char* error_message) {
+    ConnectionManager* manager = operation->manager;
+    
+    lock_manager(manager);
+    if (operation->completed) {
+        unlock_manager(manager);
+        return;
+    }
+    operation->completed = true;
+    g_hash_table_remove(manager->operations, operation);
+    unlock_manager(manager);
     
-    ConnectionState* new_state = malloc(sizeof(ConnectionState));
-    *new_state = state;
-    g_hash_table_replace(manager->connections, strdup(device_address), new_state);
+    if (result != SUCCESS && result != ERR_CANCELLED) {
+        metrics_add(manager->metrics, COUNT_OPERATIONS_FAILED, 1);
+    }
     
-    pthread_mutex_unlock(&manager->mutex);
+    switch (operation->type) {
+        case OPERATION_CONNECT:
+            settle_connection_state(manager, operation->address, true, result == SUCCESS);
+            break;
+        case OPERATION_DISCONNECT:
+            settle_connection_state(manager, operation->address, false, result == SUCCESS);
+            break;
+        case OPERATION_PAIR:
+            if (manager->pairing_callback) {
+                manager->pairing_callback(operation->address, result == SUCCESS,
+                                          error_message, manager->pairing_user_data);
+            }
+            if (result == SUCCESS && manager->config.auto_trust) {
+                connection_operation_unref(
+                    connection_manager_trust_async(manager, operation->address, 0,
+                                                   trust_after_pair_done, NULL));
+            }
+            break;
+        case OPERATION_TRUST:
+            break;
+    }
+    
+    if (operation->callback) {
+        operation->callback(operation, result, error_message, operation->user_data);
+    }
+    
+    dbus_pending_call_unref(operation->pending);
+    operation->pending = NULL;
+    connection_operation_unref(operation);
+}
+
+/* DBusPendingCall notify - runs on the bus thread while dispatching */
+static void operation_reply_notify(DBusPendingCall* pending, void* data) {
+    ConnectionOperation* operation = (ConnectionOperation*)data;
+    
+    DBusMessage* reply = dbus_pending_call_steal_reply(pending);
+    if (!reply) return;
+    
+    // Timeouts arrive here too, as an error reply made up by libdbus
+    metrics_record(operation->manager->metrics, operation->type,
+                   metrics_now_ns() - operation->started_ns);
+    
+    if (dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR) {
+        DBusError error;
+        dbus_error_init(&error);
+        dbus_set_error_from_message(&error, reply);
+        finish_operation(operation, operation_error_code(operation->type, error.name),
+                         error.message);
+        dbus_error_free(&error);
+    } else {
+        finish_operation(operation, SUCCESS, NULL);
+    }
+    
+    dbus_message_unref(reply);
+}
+
+/* Issue the D-Bus call for an operation on a given object without waiting
+ * for the reply */
+static ConnectionOperation* send_operation(ConnectionManager* manager,
+                                           OperationType type,
+                                           const char* device_address,
+                                           const char* device_path,
+                                           int timeout_ms,
+                                           OperationCallback callback,
+                                           void* user_data) {
+    static const char* const methods[] = {
+        [OPERATION_CONNECT] = "Connect",
+        [OPERATION_DISCONNECT] = "Disconnect",
+        [OPERATION_PAIR] = "Pair",
+    };
+    
+    DBusMessage* msg = type == OPERATION_TRUST ?
+                       new_trust_call(device_path) :
+                       dbus_message_new_method_call(BLUEZ_SERVICE, device_path,
+                                                    DEVICE_INTERFACE, methods[type]);
+    if (!msg) return NULL;
+    
+    ConnectionOperation* operation = calloc(1, sizeof(ConnectionOperation));
+    if (!operation) {
+        dbus_message_unref(msg);
+        return NULL;
+    }
+    
+    operation->manager = manager;
+    operation->type = type;
+    normalize_address(device_address, operation->address);
+    operation->callback = callback;
+    operation->user_data = user_data;
+    atomic_init(&operation->refcount, 2);  // Caller + in-flight call
+    
+    if (timeout_ms <= 0) {
+        timeout_ms = default_timeout_ms(manager, type);
+    }
+    
+    metrics_add(manager->metrics, COUNT_OPERATIONS_STARTED, 1);
+    operation->started_ns = metrics_now_ns();
+    if (!dbus_connection_send_with_reply(manager->conn, msg, &operation->pending, timeout_ms) ||
+        !operation->pending) {
+        dbus_message_unref(msg);
+        free(operation);
+        return NULL;
+    }
+    dbus_message_unref(msg);
+    
+    lock_manager(manager);
+    bool closing = manager->closing;
+    if (!closing) {
+        g_hash_table_insert(manager->operations, operation, operation);
+    }
+    unlock_manager(manager);
     
-    if (manager->state_callback) {
-        manager->state_callback(device_address, state, manager->config.user_data);
+    // E.g. auto-trust after a pair that completed during destroy
+    if (closing) {
+        dbus_pending_call_cancel(operation->pending);
+        finish_operation(operation, ERR_CANCELLED, "Connection manager closing");
+        return operation;
+    }
+    
+    if (type == OPERATION_CONNECT) {
+        update_connection_state(manager, operation->address, STATE_CONNECTING);
+    } else if (type == OPERATION_DISCONNECT) {
+        update_connection_state(manager, operation->address, STATE_DISCONNECTING);
+    }
+    
+    if (!dbus_pending_call_set_notify(operation->pending, operation_reply_notify,
+                                      operation, NULL)) {
+        dbus_pending_call_cancel(operation->pending);
+        finish_operation(operation, ERR_MEMORY, "Out of memory");
+        return operation;
+    }
+    
+    // The reply may have been dispatched before the notify was attached
+    if (dbus_pending_call_get_completed(operation->pending)) {
+        operation_reply_notify(operation->pending, operation);
+    }
+    
+    return operation;
+}
+
+/* Issue the D-Bus call for an operation without waiting for the reply */
+static ConnectionOperation* start_operation(ConnectionManager* manager,
+                                            OperationType type,
+                                            const char* device_address,
+                                            int timeout_ms,
+                                            OperationCallback callback,
+                                            void* user_data) {
+    if (!manager || !device_address) return NULL;
+    
+    char* device_path = get_device_path(manager, device_address, type);
+    if (!device_path) return NULL;
+    
+    ConnectionOperation* operation = send_operation(manager, type, device_address, device_path,
+                                                    timeout_ms, callback, user_data);
+    free(device_path);
+    return operation;
+}
+
+/* Auto-reconnect engine */
+
+#define DEFAULT_RECONNECT_BASE_MS 1000
+#define DEFAULT_RECONNECT_MAX_MS 60000
+
+static void reconnect_timer_fired(void* data);
+
+/* Arm the backoff timer for the next retry (manager->mutex held) */
+static void schedule_reconnect(ConnectionManager* manager, ReconnectEntry* entry) {
+    int max_attempts = manager->config.reconnect_max_attempts;
+    if (max_attempts > 0 && entry->stats.consecutive_failures >= (uint32_t)max_attempts) {
+        log_warn("Giving up reconnecting %s after %u attempts",
+                 entry->address, entry->stats.consecutive_failures);
+        entry->wanted = false;
+        entry->stats.pending = false;
+        return;
+    }
+    
+    uint64_t base = manager->config.reconnect_base_delay_ms > 0 ?
+                    (uint64_t)manager->config.reconnect_base_delay_ms : DEFAULT_RECONNECT_BASE_MS;
+    uint64_t ceiling = manager->config.reconnect_max_delay_ms > 0 ?
+                       (uint64_t)manager->config.reconnect_max_delay_ms : DEFAULT_RECONNECT_MAX_MS;
+    
+    uint32_t shift = entry->stats.consecutive_failures < 16 ? entry->stats.consecutive_failures : 16;
+    uint64_t delay = base << shift;
+    if (delay > ceiling) delay = ceiling;
+    
+    // Equal jitter: keep half the backoff, randomize the rest so a fleet drop spreads out
+    delay = delay / 2 + (uint64_t)rand_r(&manager->jitter_seed) % (delay / 2 + 1);
+    
+    entry->stats.last_delay_ms = (uint32_t)delay;
+    entry->stats.pending = true;
+    dbus_reactor_schedule(manager->reactor, &entry->timer, delay);
+}
+
+/* Completion of a reconnect attempt */
+static void reconnect_done(ConnectionOperation* operation, ErrorCode result,
+                           const char* error_message, void* user_data) {
+    ReconnectEntry* entry = user_data;
+    ConnectionManager* manager = entry->manager;
+    ConnectionOperation* finished = NULL;
+    
+    lock_manager(manager);
+    if (operation && entry->attempt == operation) {
+        finished = entry->attempt;
+        entry->attempt = NULL;
+    }
+    if (result == SUCCESS) {
+        entry->stats.successes++;
+        entry->stats.consecutive_failures = 0;
+    } else {
+        entry->stats.failures++;
+        entry->stats.consecutive_failures++;
+        if (entry->wanted && !manager->closing && result != ERR_CANCELLED) {
+            log_warn("Reconnect to %s failed: %s", entry->address,
+                     error_message ? error_message : "unknown error");
+            schedule_reconnect(manager, entry);
+        }
+    }
+    unlock_manager(manager);
+    
+    if (finished) {
+        connection_operation_unref(finished);
+    }
+}
+
+/* Backoff expired - runs on the bus thread */
+static void reconnect_timer_fired(void* data) {
+    ReconnectEntry* entry = data;
+    ConnectionManager* manager = entry->manager;
+    
+    lock_manager(manager);
+    bool go = entry->wanted && !manager->closing;
+    entry->stats.pending = false;
+    if (go) entry->stats.attempts++;
+    unlock_manager(manager);
+    
+    if (!go) return;
+    
+    ConnectionOperation* operation = start_operation(manager, OPERATION_CONNECT, entry->address, 0,
+                                                     reconnect_done, entry);
+    if (!operation) {
+        reconnect_done(NULL, ERR_NO_DEVICE, "Device not found", entry);
+        return;
+    }
+    
+    // Keep the handle so a deliberate disconnect can cancel the attempt
+    lock_manager(manager);
+    bool keep = !operation->completed && entry->wanted && !entry->attempt;
+    if (keep) {
+        entry->attempt = operation;
+    }
+    unlock_manager(manager);
+    
+    if (!keep) {
+        connection_operation_unref(operation);
+    }
+}
+
+/* Connected property changed - runs on the bus thread */
+static void handle_link_change(ConnectionManager* manager, bt_addr_t addr, bool connected) {
+    if (!manager->config.auto_reconnect) return;
+    
+    lock_manager(manager);
+    
+    ReconnectEntry* entry = device_table_lookup(manager->reconnects, addr);
+    if (connected) {
+        if (!entry) {
+            entry = calloc(1, sizeof(ReconnectEntry));
+            if (!entry) {
+                unlock_manager(manager);
+                return;
+            }
+            entry->manager = manager;
+            bt_addr_format(addr, entry->address);
+            wheel_timer_init(&entry->timer, reconnect_timer_fired, entry);
+            if (!device_table_insert(manager->reconnects, addr, entry, NULL)) {
+                free(entry);
+                unlock_manager(manager);
+                return;
+            }
+        }
+        
+        // Link is up (by us or by the device) - keep it that way from now on
+        if (entry->user_disconnected) {
+            unlock_manager(manager);
+            return;
+        }
+        entry->wanted = true;
+        entry->stats.consecutive_failures = 0;
+        entry->stats.pending = false;
+        dbus_reactor_cancel(manager->reactor, &entry->timer);
+    } else if (entry && entry->wanted && !manager->closing) {
+        entry->stats.drops++;
+        log_info("Link to %s dropped, reconnecting", entry->address);
+        schedule_reconnect(manager, entry);
+    }
+    
+    unlock_manager(manager);
+}
+
+/* A deliberate disconnect must not be undone by the reconnect engine */
+static void forget_reconnect(ConnectionManager* manager, const char* device_address) {
+    bt_addr_t addr;
+    if (!bt_addr_parse(device_address, &addr)) return;
+    
+    ConnectionOperation* attempt = NULL;
+    
+    lock_manager(manager);
+    ReconnectEntry* entry = device_table_lookup(manager->reconnects, addr);
+    if (entry) {
+        entry->wanted = false;
+        entry->user_disconnected = true;
+        entry->stats.pending = false;
+        dbus_reactor_cancel(manager->reactor, &entry->timer);
+        attempt = entry->attempt;
+        entry->attempt = NULL;
+    }
+    unlock_manager(manager);
+    
+    if (attempt) {
+        connection_operation_cancel(attempt);
+        connection_operation_unref(attempt);
+    }
+}
+
+/* An explicit connect request re-enables reconnects after a deliberate disconnect */
+static void allow_reconnect(ConnectionManager* manager, const char* device_address) {
+    bt_addr_t addr;
+    if (!bt_addr_parse(device_address, &addr)) return;
+    
+    lock_manager(manager);
+    ReconnectEntry* entry = device_table_lookup(manager->reconnects, addr);
+    if (entry) {
+        entry->user_disconnected = false;
+    }
+    unlock_manager(manager);
+}
+
+static void reconnect_entry_free(void* data) {
+    ReconnectEntry* entry = data;
+    if (entry->attempt) {
+        connection_operation_unref(entry->attempt);
+    }
+    free(entry);
+}
+
+/* Bulk connect scheduler */
+
+#define DEFAULT_CONNECTS_PER_ADAPTER 4
+
+/* Heap order: higher priority, then stronger RSSI, then oldest */
+static bool scheduled_before(const ScheduledConnect* a, const ScheduledConnect* b) {
+    if (a->priority != b->priority) return a->priority > b->priority;
+    if (a->rssi != b->rssi) return a->rssi > b->rssi;
+    return a->seq < b->seq;
+}
+
+static bool adapter_queue_push(AdapterQueue* queue, ScheduledConnect* entry) {
+    if (queue->size == queue->capacity) {
+        size_t capacity = queue->capacity ? queue->capacity * 2 : 16;
+        ScheduledConnect** heap = realloc(queue->heap, capacity * sizeof(ScheduledConnect*));
+        if (!heap) return false;
+        queue->heap = heap;
+        queue->capacity = capacity;
+    }
+    
+    size_t i = queue->size++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!scheduled_before(entry, queue->heap[parent])) break;
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = entry;
+    return true;
+}
+
+static ScheduledConnect* adapter_queue_pop(AdapterQueue* queue) {
+    if (queue->size == 0) return NULL;
+    
+    ScheduledConnect* top = queue->heap[0];
+    ScheduledConnect* last = queue->heap[--queue->size];
+    size_t i = 0;
+    
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= queue->size) break;
+        if (child + 1 < queue->size && scheduled_before(queue->heap[child + 1], queue->heap[child])) {
+            child++;
+        }
+        if (!scheduled_before(queue->heap[child], last)) break;
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    if (queue->size > 0) queue->heap[i] = last;
+    
+    return top;
+}
+
+static void adapter_queue_free(gpointer data) {
+    AdapterQueue* queue = data;
+    for (size_t i = 0; i < queue->size; i++) {
+        connect_batch_unref(queue->heap[i]->batch);
+        free(queue->heap[i]->device_path);
+        free(queue->heap[i]);
+    }
+    free(queue->heap);
+    free(queue);
+}
+
+/* Report progress outside the manager lock */
+static void notify_batch_progress(ConnectBatch* batch, const ConnectBatchProgress* progress) {
+    if (batch->policy.on_progress) {
+        batch->policy.on_progress(batch, progress, batch->policy.user_data);
+    }
+}
+
+static void pump_adapter_queue(ConnectionManager* manager, AdapterQueue* queue);
+
+/* Completion of one scheduled connect - frees its adapter slot and refills it */
+static void scheduled_connect_done(ConnectionOperation* operation, ErrorCode result,
+                                   const char* error_message, void* user_data) {
+    (void)error_message;
+    ScheduledConnect* entry = user_data;
+    ConnectBatch* batch = entry->batch;
+    ConnectionManager* manager = batch->manager;
+    ConnectBatchProgress progress;
+    
+    lock_manager(manager);
+    entry->queue->in_flight--;
+    batch->progress.in_flight--;
+    if (result == SUCCESS) {
+        batch->progress.succeeded++;
+    } else {
+        batch->progress.failed++;
+    }
+    GList* link = operation ? g_list_find(batch->operations, operation) : NULL;
+    if (link) {
+        batch->operations = g_list_delete_link(batch->operations, link);
+    }
+    progress = batch->progress;
+    unlock_manager(manager);
+    
+    // Drop the batch's handle; finish_operation still holds its own reference
+    if (link) {
+        connection_operation_unref(operation);
+    }
+    
+    notify_batch_progress(batch, &progress);
+    pump_adapter_queue(manager, entry->queue);
+    
+    connect_batch_unref(batch);
+    free(entry->device_path);
+    free(entry);
+}
+
+/* Start queued connects until the adapter is at its in-flight limit */
+static void pump_adapter_queue(ConnectionManager* manager, AdapterQueue* queue) {
+    int limit = manager->config.max_connects_per_adapter > 0 ?
+                manager->config.max_connects_per_adapter : DEFAULT_CONNECTS_PER_ADAPTER;
+    
+    for (;;) {
+        lock_manager(manager);
+        
+        ScheduledConnect* entry = NULL;
+        while (!manager->closing && queue->in_flight < limit && (entry = adapter_queue_pop(queue)) != NULL) {
+            if (!entry->batch->cancelled) break;
+            // Cancelled batches already counted their queued entries as failed
+            connect_batch_unref(entry->batch);
+            free(entry->device_path);
+            free(entry);
+            entry = NULL;
+        }
+        
+        if (!entry) {
+            unlock_manager(manager);
+            return;
+        }
+        
+        ConnectBatch* batch = entry->batch;
+        queue->in_flight++;
+        batch->progress.queued--;
+        batch->progress.in_flight++;
+        unlock_manager(manager);
+        
+        // Through the adapter the entry was queued on
+        allow_reconnect(manager, entry->address);
+        ConnectionOperation* operation = send_operation(manager, OPERATION_CONNECT, entry->address,
+                                                        entry->device_path, batch->policy.timeout_ms,
+                                                        scheduled_connect_done, entry);
+        
+        if (!operation) {
+            scheduled_connect_done(NULL, ERR_MEMORY, NULL, entry);
+            continue;
+        }
+        
+        lock_manager(manager);
+        if (!operation->completed) {
+            batch->operations = g_list_prepend(batch->operations, operation);
+            operation = NULL;
+        }
+        unlock_manager(manager);
+        
+        // Handle stays referenced by the batch until the attempt completes
+        connection_operation_unref(operation);
     }
 }
 
@@ -145,25 +1382,62 @@ ConnectionManager* connection_manager_create(const ConnectionManagerConfig* conf
     if (!manager) return NULL;
     
     manager->config = *config;
+    manager->metrics = metrics_create(COUNTER_COUNT, LATENCY_COUNT);
+    wheel_timer_init(&manager->metrics_timer, metrics_timer_fired, manager);
     
-    if (pthread_mutex_init(&manager->mutex, NULL) != 0) {
+    if (!manager->metrics || pthread_mutex_init(&manager->mutex, NULL) != 0) {
+        metrics_destroy(manager->metrics);
         free(manager);
         return NULL;
     }
     
-    DBusError error;
-    dbus_error_init(&error);
-    
-    manager->conn = dbus_bus_get(DBUS_BUS_SYSTEM, &error);
-    if (!manager->conn) {
-        fprintf(stderr, "Failed to connect to D-Bus: %s\n", error.message);
-        dbus_error_free(&error);
+    // Same connection and thread as any DeviceManager in the process
+    manager->bus = bus_core_get();
+    if (!manager->bus) {
         pthread_mutex_destroy(&manager->mutex);
+        metrics_destroy(manager->metrics);
         free(manager);
         return NULL;
     }
+    manager->conn = bus_core_connection(manager->bus);
+    manager->reactor = bus_core_reactor(manager->bus);
+    
+    manager->device_objects = device_table_create(0);
+    manager->states = connection_states_create(manager->config.max_devices > 0 ?
+                                               (size_t)manager->config.max_devices : DEFAULT_MAX_DEVICES);
+    manager->operations = g_hash_table_new(g_direct_hash, g_direct_equal);
+    manager->adapter_queues = g_hash_table_new_full(g_str_hash, g_str_equal, free, adapter_queue_free);
+    manager->reconnects = device_table_create(0);
+    manager->jitter_seed = (unsigned int)time(NULL) ^ (unsigned int)(uintptr_t)manager;
+    if (!manager->device_objects || !manager->states || !manager->reconnects) {
+        connection_manager_destroy(manager);
+        return NULL;
+    }
+    
+    if (!bus_core_add_handler(manager->bus, OBJECT_MANAGER_INTERFACE, "InterfacesAdded",
+                              on_interfaces_added, manager) ||
+        !bus_core_add_handler(manager->bus, OBJECT_MANAGER_INTERFACE, "InterfacesRemoved",
+                              on_interfaces_removed, manager) ||
+        !bus_core_add_handler(manager->bus, PROPERTIES_INTERFACE, "PropertiesChanged",
+                              on_properties_changed, manager)) {
+        connection_manager_destroy(manager);
+        return NULL;
+    }
+    
+    // Subscribe before the initial load so no object appears in between
+    size_t rule_count = sizeof(match_rules) / sizeof(match_rules[0]);
+    for (; manager->match_count < rule_count; manager->match_count++) {
+        dbus_bus_add_match(manager->conn, match_rules[manager->match_count], NULL);
+    }
+    
+    if (load_device_paths(manager) == SUCCESS) {
+        log_debug("Indexed %zu known device(s)", device_table_count(manager->device_objects));
+    }
+    
+    if (manager->config.metrics_path) {
+        dbus_reactor_schedule(manager->reactor, &manager->metrics_timer, 0);
+    }
     
-    manager->connections = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
     return manager;
 }
 
@@ -171,10 +1445,12 @@ ErrorCode connection_manager_connect(ConnectionManager* manager,
                                      const char* device_address) {
     if (!manager || !device_address) return ERR_INVALID_ARG;
     
-    printf("Attempting to connect to: %s\n", device_address);
+    log_debug("Attempting to connect to: %s", device_address);
+    allow_reconnect(manager, device_address);
     
-    char* device_path = get_device_path(manager, device_address);
-    printf("DEBUG: Using device path: %s\n", device_path);
+    char* device_path = get_device_path(manager, device_address, OPERATION_CONNECT);
+    if (!device_path) return ERR_NO_DEVICE;
+    log_debug("Using device path: %s", device_path);
     
     update_connection_state(manager, device_address, STATE_CONNECTING);
     
@@ -190,28 +1466,27 @@ ErrorCode connection_manager_connect(ConnectionManager* manager,
     
     if (!msg) {
         free(device_path);
-        update_connection_state(manager, device_address, STATE_FAILED);
+        settle_connection_state(manager, device_address, true, false);
         return ERR_DBUS;
     }
     
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 
-                                                      manager->config.connection_timeout * 1000, 
-                                                      &error);
+    reply = call_blocking(manager, OPERATION_CONNECT, msg,
+                          manager->config.connection_timeout * 1000, &error);
     dbus_message_unref(msg);
     
     if (!reply) {
-        fprintf(stderr, "Connect failed: %s\n", error.message);
+        log_error("Connect failed: %s", error.message);
         dbus_error_free(&error);
         free(device_path);
-        update_connection_state(manager, device_address, STATE_FAILED);
+        settle_connection_state(manager, device_address, true, false);
         return ERR_CONNECTION;
     }
     
     dbus_message_unref(reply);
     free(device_path);
     
-    printf("Connect successful!\n");
-    update_connection_state(manager, device_address, STATE_CONNECTED);
+    log_debug("Connected to %s", device_address);
+    settle_connection_state(manager, device_address, true, true);
     return SUCCESS;
 }
 
@@ -219,10 +1494,13 @@ ErrorCode connection_manager_disconnect(ConnectionManager* manager,
                                         const char* device_address) {
     if (!manager || !device_address) return ERR_INVALID_ARG;
     
-    printf("Disconnecting from: %s\n", device_address);
-    update_connection_state(manager, device_address, STATE_DISCONNECTING);
+    log_debug("Disconnecting from: %s", device_address);
+    forget_reconnect(manager, device_address);
+    
+    char* device_path = get_device_path(manager, device_address, OPERATION_DISCONNECT);
+    if (!device_path) return ERR_NO_DEVICE;
     
-    char* device_path = get_device_path(manager, device_address);
+    update_connection_state(manager, device_address, STATE_DISCONNECTING);
     
     DBusError error;
     DBusMessage *msg, *reply;
@@ -236,26 +1514,26 @@ ErrorCode connection_manager_disconnect(ConnectionManager* manager,
     
     if (!msg) {
         free(device_path);
-        update_connection_state(manager, device_address, STATE_FAILED);
+        settle_connection_state(manager, device_address, false, false);
         return ERR_DBUS;
     }
     
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 5000, &error);
+    reply = call_blocking(manager, OPERATION_DISCONNECT, msg, 5000, &error);
     dbus_message_unref(msg);
     
     if (!reply) {
-        fprintf(stderr, "Disconnect failed: %s\n", error.message);
+        log_error("Disconnect failed: %s", error.message);
         dbus_error_free(&error);
         free(device_path);
-        update_connection_state(manager, device_address, STATE_FAILED);
+        settle_connection_state(manager, device_address, false, false);
         return ERR_CONNECTION;
     }
     
     dbus_message_unref(reply);
     free(device_path);
     
-    printf("Disconnect successful!\n");
-    update_connection_state(manager, device_address, STATE_DISCONNECTED);
+    log_debug("Disconnected from %s", device_address);
+    settle_connection_state(manager, device_address, false, true);
     return SUCCESS;
 }
 
@@ -263,9 +1541,16 @@ ErrorCode connection_manager_pair(ConnectionManager* manager,
                                   const char* device_address) {
     if (!manager || !device_address) return ERR_INVALID_ARG;
     
-    printf("Attempting to pair with: %s\n", device_address);
+    log_debug("Attempting to pair with: %s", device_address);
     
-    char* device_path = get_device_path(manager, device_address);
+    char* device_path = get_device_path(manager, device_address, OPERATION_PAIR);
+    if (!device_path) {
+        if (manager->pairing_callback) {
+            manager->pairing_callback(device_address, false, "Device not found", 
+                                     manager->pairing_user_data);
+        }
+        return ERR_NO_DEVICE;
+    }
     
     DBusError error;
     DBusMessage *msg, *reply;
@@ -286,11 +1571,11 @@ ErrorCode connection_manager_pair(ConnectionManager* manager,
         return ERR_DBUS;
     }
     
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 30000, &error);
+    reply = call_blocking(manager, OPERATION_PAIR, msg, 30000, &error);
     dbus_message_unref(msg);
     
     if (!reply) {
-        fprintf(stderr, "Pair failed: %s\n", error.message);
+        log_error("Pair failed: %s", error.message);
         if (manager->pairing_callback) {
             manager->pairing_callback(device_address, false, error.message, 
                                      manager->pairing_user_data);
@@ -303,7 +1588,7 @@ ErrorCode connection_manager_pair(ConnectionManager* manager,
     dbus_message_unref(reply);
     free(device_path);
     
-    printf("Pairing successful!\n");
+    log_debug("Paired with %s", device_address);
     
     if (manager->pairing_callback) {
         manager->pairing_callback(device_address, true, NULL, manager->pairing_user_data);
@@ -321,9 +1606,10 @@ ErrorCode connection_manager_trust(ConnectionManager* manager,
                                    const char* device_address) {
     if (!manager || !device_address) return ERR_INVALID_ARG;
     
-    printf("Setting device as trusted: %s\n", device_address);
+    log_debug("Setting device as trusted: %s", device_address);
     
-    char* device_path = get_device_path(manager, device_address);
+    char* device_path = get_device_path(manager, device_address, OPERATION_TRUST);
+    if (!device_path) return ERR_NO_DEVICE;
     
     DBusError error;
     DBusMessage *msg, *reply;
@@ -331,34 +1617,18 @@ ErrorCode connection_manager_trust(ConnectionManager* manager,
     dbus_error_init(&error);
     
     // Set the "Trusted" property to true
-    msg = dbus_message_new_method_call(BLUEZ_SERVICE,
-                                       device_path,
-                                       "org.freedesktop.DBus.Properties",
-                                       "Set");
+    msg = new_trust_call(device_path);
     
     if (!msg) {
         free(device_path);
         return ERR_DBUS;
     }
     
-    const char* interface = DEVICE_INTERFACE;
-    const char* property = "Trusted";
-    dbus_bool_t trusted = TRUE;
-    
-    DBusMessageIter iter, value_iter;
-    dbus_message_iter_init_append(msg, &iter);
-    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &interface);
-    dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &property);
-    
-    dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, "b", &value_iter);
-    dbus_message_iter_append_basic(&value_iter, DBUS_TYPE_BOOLEAN, &trusted);
-    dbus_message_iter_close_container(&iter, &value_iter);
-    
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 5000, &error);
+    reply = call_blocking(manager, OPERATION_TRUST, msg, 5000, &error);
     dbus_message_unref(msg);
     
     if (!reply) {
-        fprintf(stderr, "Trust failed: %s\n", error.message);
+        log_error("Trust failed: %s", error.message);
         dbus_error_free(&error);
         free(device_path);
         return ERR_DBUS;
@@ -367,10 +1637,266 @@ ErrorCode connection_manager_trust(ConnectionManager* manager,
     dbus_message_unref(reply);
     free(device_path);
     
-    printf("Device trusted successfully!\n");
+    log_debug("Trusted %s", device_address);
+    return SUCCESS;
+}
+
+ConnectionOperation* connection_manager_connect_async(ConnectionManager* manager,
+                                                      const char* device_address,
+                                                      int timeout_ms,
+                                                      OperationCallback callback,
+                                                      void* user_data) {
+    if (manager && device_address) {
+        allow_reconnect(manager, device_address);
+    }
+    return start_operation(manager, OPERATION_CONNECT, device_address,
+                           timeout_ms, callback, user_data);
+}
+
+ConnectionOperation* connection_manager_disconnect_async(ConnectionManager* manager,
+                                                         const char* device_address,
+                                                         int timeout_ms,
+                                                         OperationCallback callback,
+                                                         void* user_data) {
+    if (manager && device_address) {
+        forget_reconnect(manager, device_address);
+    }
+    return start_operation(manager, OPERATION_DISCONNECT, device_address,
+                           timeout_ms, callback, user_data);
+}
+
+ConnectionOperation* connection_manager_pair_async(ConnectionManager* manager,
+                                                   const char* device_address,
+                                                   int timeout_ms,
+                                                   OperationCallback callback,
+                                                   void* user_data) {
+    return start_operation(manager, OPERATION_PAIR, device_address,
+                           timeout_ms, callback, user_data);
+}
+
+ConnectionOperation* connection_manager_trust_async(ConnectionManager* manager,
+                                                    const char* device_address,
+                                                    int timeout_ms,
+                                                    OperationCallback callback,
+                                                    void* user_data) {
+    return start_operation(manager, OPERATION_TRUST, device_address,
+                           timeout_ms, callback, user_data);
+}
+
+ConnectBatch* connection_manager_connect_many(ConnectionManager* manager,
+                                              const char* const* addresses,
+                                              size_t count,
+                                              const ConnectPolicy* policy) {
+    if (!manager || (!addresses && count > 0)) return NULL;
+    
+    ConnectBatch* batch = calloc(1, sizeof(ConnectBatch));
+    if (!batch) return NULL;
+    
+    batch->manager = manager;
+    if (policy) {
+        batch->policy = *policy;
+    }
+    batch->progress.total = (int)count;
+    atomic_init(&batch->refcount, 1);  // Caller; each queued entry adds one
+    
+    GList* touched = NULL;
+    int unknown = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        char* device_path = addresses[i] ? get_device_path(manager, addresses[i], OPERATION_CONNECT) : NULL;
+        ScheduledConnect* entry = device_path ? calloc(1, sizeof(ScheduledConnect)) : NULL;
+        
+        if (!entry) {
+            free(device_path);
+            unknown++;
+            continue;
+        }
+        
+        entry->batch = batch;
+        normalize_address(addresses[i], entry->address);
+        entry->priority = batch->policy.priorities ? batch->policy.priorities[i] : 0;
+        entry->rssi = INT8_MIN;
+        
+        if (manager->config.device_manager) {
+            BluetoothDevice device;
+            if (device_manager_read_device(manager->config.device_manager, entry->address, &device)) {
+                entry->rssi = device.rssi;
+            }
+        }
+        
+        entry->device_path = device_path;
+        
+        lock_manager(manager);
+        
+        AdapterQueue* queue = adapter_state(manager, device_path, true);
+        
+        entry->queue = queue;
+        entry->seq = manager->schedule_seq++;
+        atomic_fetch_add(&batch->refcount, 1);
+        
+        if (queue && adapter_queue_push(queue, entry)) {
+            batch->progress.queued++;
+            if (!g_list_find(touched, queue)) {
+                touched = g_list_prepend(touched, queue);
+            }
+        } else {
+            atomic_fetch_sub(&batch->refcount, 1);
+            free(entry->device_path);
+            free(entry);
+            unknown++;
+        }
+        
+        unlock_manager(manager);
+    }
+    
+    lock_manager(manager);
+    batch->progress.failed += unknown;
+    unlock_manager(manager);
+    
+    for (GList* iter = touched; iter; iter = iter->next) {
+        pump_adapter_queue(manager, iter->data);
+    }
+    g_list_free(touched);
+    
+    return batch;
+}
+
+void connect_batch_get_progress(ConnectBatch* batch, ConnectBatchProgress* progress) {
+    if (!batch || !progress) return;
+    
+    pthread_mutex_lock(&batch->manager->mutex);
+    *progress = batch->progress;
+    pthread_mutex_unlock(&batch->manager->mutex);
+}
+
+void connect_batch_cancel(ConnectBatch* batch) {
+    if (!batch) return;
+    
+    ConnectionManager* manager = batch->manager;
+    GList* running = NULL;
+    
+    lock_manager(manager);
+    if (batch->cancelled) {
+        unlock_manager(manager);
+        return;
+    }
+    
+    // Queued entries are dropped when they reach the head of their queue
+    batch->cancelled = true;
+    batch->progress.failed += batch->progress.queued;
+    batch->progress.queued = 0;
+    
+    for (GList* iter = batch->operations; iter; iter = iter->next) {
+        running = g_list_prepend(running, connection_operation_ref(iter->data));
+    }
+    unlock_manager(manager);
+    
+    for (GList* iter = running; iter; iter = iter->next) {
+        connection_operation_cancel(iter->data);
+    }
+    g_list_free_full(running, (GDestroyNotify)connection_operation_unref);
+}
+
+void connect_batch_unref(ConnectBatch* batch) {
+    if (!batch) return;
+    
+    if (atomic_fetch_sub(&batch->refcount, 1) == 1) {
+        g_list_free_full(batch->operations, (GDestroyNotify)connection_operation_unref);
+        free(batch);
+    }
+}
+
+void connection_operation_cancel(ConnectionOperation* operation) {
+    if (!operation) return;
+    
+    ConnectionManager* manager = operation->manager;
+    
+    // finish_operation() drops the pending call once completed is set, so
+    // hold a reference of our own while cancelling outside the lock
+    lock_manager(manager);
+    DBusPendingCall* pending = operation->completed ? NULL : dbus_pending_call_ref(operation->pending);
+    unlock_manager(manager);
+    if (!pending) return;
+
+    // Any reply that still arrives is ignored by libdbus
+    dbus_pending_call_cancel(pending);
+    dbus_pending_call_unref(pending);
+    finish_operation(operation, ERR_CANCELLED, "Operation cancelled");
+}
+
+OperationType connection_operation_get_type(const ConnectionOperation* operation) {
+    return operation->type;
+}
+
+const char* connection_operation_get_address(const ConnectionOperation* operation) {
+    return operation->address;
+}
+
+ConnectionOperation* connection_operation_ref(ConnectionOperation* operation) {
+    if (operation) {
+        atomic_fetch_add(&operation->refcount, 1);
+    }
+    return operation;
+}
+
+void connection_operation_unref(ConnectionOperation* operation) {
+    if (!operation) return;
+    
+    if (atomic_fetch_sub(&operation->refcount, 1) == 1) {
+        free(operation);
+    }
+}
+
+ErrorCode connection_manager_get_reconnect_stats(ConnectionManager* manager,
+                                                 const char* device_address,
+                                                 ReconnectStats* stats) {
+    if (!manager || !device_address || !stats) return ERR_INVALID_ARG;
+    
+    bt_addr_t addr;
+    if (!bt_addr_parse(device_address, &addr)) return ERR_INVALID_ARG;
+    
+    lock_manager(manager);
+    ReconnectEntry* entry = device_table_lookup(manager->reconnects, addr);
+    if (entry) {
+        *stats = entry->stats;
+    }
+    unlock_manager(manager);
+    
+    return entry ? SUCCESS : ERR_NO_DEVICE;
+}
+
+ErrorCode connection_manager_get_stats(ConnectionManager* manager, ConnectionManagerStats* stats) {
+    if (!manager || !stats) return ERR_INVALID_ARG;
+    
+    // Read without lock_manager() so asking doesn't show up in the lock figures
+    pthread_mutex_lock(&manager->mutex);
+    stats->connections = (uint64_t)manager->links;
+    pthread_mutex_unlock(&manager->mutex);
+    
+    stats->signals_received = metrics_count(manager->metrics, COUNT_SIGNALS_RECEIVED);
+    stats->operations_started = metrics_count(manager->metrics, COUNT_OPERATIONS_STARTED);
+    stats->operations_failed = metrics_count(manager->metrics, COUNT_OPERATIONS_FAILED);
+    metrics_latency(manager->metrics, OPERATION_CONNECT, &stats->connect_rtt);
+    metrics_latency(manager->metrics, OPERATION_DISCONNECT, &stats->disconnect_rtt);
+    metrics_latency(manager->metrics, OPERATION_PAIR, &stats->pair_rtt);
+    metrics_latency(manager->metrics, OPERATION_TRUST, &stats->trust_rtt);
+    metrics_latency(manager->metrics, LATENCY_LOCK_WAIT, &stats->lock_wait);
+    metrics_latency(manager->metrics, LATENCY_LOCK_HOLD, &stats->lock_hold);
     return SUCCESS;
 }
 
+ErrorCode connection_manager_write_metrics(ConnectionManager* manager, int fd) {
+    if (!manager || fd < 0) return ERR_INVALID_ARG;
+    
+    char* text = NULL;
+    size_t length = 0;
+    if (!format_metrics(manager, &text, &length)) return ERR_MEMORY;
+    
+    bool ok = metrics_write_fd(fd, text, length);
+    free(text);
+    return ok ? SUCCESS : ERR_IPC;
+}
+
 void connection_manager_set_state_callback(ConnectionManager* manager, 
                                            ConnectionStateCallback callback) {
     if (manager) {
@@ -389,25 +1915,91 @@ ConnectionState connection_manager_get_state(ConnectionManager* manager,
                                              const char* device_address) {
     if (!manager || !device_address) return STATE_DISCONNECTED;
     
-    pthread_mutex_lock(&manager->mutex);
-    ConnectionState* state = g_hash_table_lookup(manager->connections, device_address);
-    ConnectionState result = state ? *state : STATE_DISCONNECTED;
-    pthread_mutex_unlock(&manager->mutex);
+    bt_addr_t addr;
+    if (!bt_addr_parse(device_address, &addr)) return STATE_DISCONNECTED;
+    
+    uint32_t word;
+    if (connection_states_find(manager->states, addr, &word) == STATE_SLOT_NONE) return STATE_DISCONNECTED;
     
-    return result;
+    return (ConnectionState)(word & STATE_WORD_STATE);
+}
+
+ErrorCode connection_manager_get_status(ConnectionManager* manager,
+                                        const char* device_address,
+                                        DeviceStatus* status) {
+    if (!manager || !device_address || !status) return ERR_INVALID_ARG;
+    
+    bt_addr_t addr;
+    if (!bt_addr_parse(device_address, &addr)) return ERR_INVALID_ARG;
+    
+    uint32_t word;
+    if (connection_states_find(manager->states, addr, &word) == STATE_SLOT_NONE) return ERR_NO_DEVICE;
+    
+    status->state = (ConnectionState)(word & STATE_WORD_STATE);
+    status->connected = word & STATE_WORD_CONNECTED;
+    status->services_resolved = word & STATE_WORD_RESOLVED;
+    status->paired = word & STATE_WORD_PAIRED;
+    status->trusted = word & STATE_WORD_TRUSTED;
+    return SUCCESS;
 }
 
 void connection_manager_destroy(ConnectionManager* manager) {
     if (!manager) return;
     
-    if (manager->connections) {
-        g_hash_table_destroy(manager->connections);
+    lock_manager(manager);
+    manager->closing = true;
+    unlock_manager(manager);
+    
+    for (size_t i = 0; i < manager->match_count; i++) {
+        dbus_bus_remove_match(manager->conn, match_rules[i], NULL);
+    }
+    
+    // Nothing new starts once closing is set - cancel whatever is still in flight
+    if (manager->operations) {
+        GList* pending = NULL;
+        
+        lock_manager(manager);
+        GHashTableIter iter;
+        gpointer key;
+        g_hash_table_iter_init(&iter, manager->operations);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            pending = g_list_prepend(pending, connection_operation_ref(key));
+        }
+        unlock_manager(manager);
+        
+        for (GList* op = pending; op; op = op->next) {
+            connection_operation_cancel(op->data);
+        }
+        g_list_free_full(pending, (GDestroyNotify)connection_operation_unref);
+    }
+    
+    // Also waits out a reply the bus thread may be delivering right now
+    if (manager->bus) {
+        bus_core_run(manager->bus, detach_from_bus, manager);
     }
     
-    if (manager->conn) {
-        dbus_connection_unref(manager->conn);
+    if (manager->operations) {
+        g_hash_table_destroy(manager->operations);
     }
     
+    if (manager->adapter_queues) {
+        g_hash_table_destroy(manager->adapter_queues);
+    }
+    
+    // Detached from the bus thread, so no backoff timer can fire any more
+    if (manager->reconnects) {
+        device_table_destroy(manager->reconnects, reconnect_entry_free);
+    }
+    
+    if (manager->device_objects) {
+        device_table_destroy(manager->device_objects, device_objects_free);
+    }
+    connection_states_destroy(manager->states);
+    
+    // The last manager out closes the connection
+    bus_core_unref(manager->bus);
+    
     pthread_mutex_destroy(&manager->mutex);
+    metrics_destroy(manager->metrics);
     free(manager);
 }
@@ -0,0 +1,232 @@
+#include "bluetooth/connection_states.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define MIN_INDEX_CAPACITY 64
+#define INDEX_TOMBSTONE (BT_ADDR_NONE - 1)       // Removed entry, probing continues
+#define GOLDEN_RATIO_64 0x9E3779B97F4A7C15ULL
+#define OWNER_STEP 0x100u                        // Lowest bit of STATE_WORD_OWNER
+
+/* Internal store structure. Slots hold the words; the index maps addresses
+ * to slots with open addressing, its entries only going EMPTY -> key ->
+ * TOMBSTONE (or a tombstone is reused) between rebuilds. */
+struct ConnectionStates {
+    size_t max_devices;
+    atomic_uint* words;                          // Per slot
+    atomic_uint_least64_t* owners;               // Address per slot, BT_ADDR_NONE if free
+    StateSlot* free_slots;                       // Writer-only stack
+    size_t free_count;
+    size_t capacity;                             // Index size, power of two >= 2x max_devices
+    int shift;
+    atomic_uint_least64_t* keys;                 // BT_ADDR_NONE = empty
+    atomic_uint* slots;
+    atomic_uint seq;                             // Odd while the index is being rebuilt
+    size_t live;                                 // Writer-only counters
+    size_t used;                                 // live + tombstones
+};
+
+/* Same Fibonacci hashing as DeviceTable */
+static inline size_t home_slot(const ConnectionStates* states, bt_addr_t key) {
+    return (size_t)((key * GOLDEN_RATIO_64) >> states->shift);
+}
+
+/* Index entry holding addr, or capacity; *reuse gets the first entry a
+ * new key could take, or capacity (writer only) */
+static size_t index_find(const ConnectionStates* states, bt_addr_t addr, size_t* reuse) {
+    size_t mask = states->capacity - 1;
+    size_t i = home_slot(states, addr);
+    
+    *reuse = states->capacity;
+    for (size_t probes = 0; probes < states->capacity; probes++) {
+        bt_addr_t key = atomic_load_explicit(&states->keys[i], memory_order_relaxed);
+        if (key == addr) return i;
+        if (key == BT_ADDR_NONE) {
+            if (*reuse == states->capacity) *reuse = i;
+            break;
+        }
+        if (key == INDEX_TOMBSTONE && *reuse == states->capacity) *reuse = i;
+        i = (i + 1) & mask;
+    }
+    return states->capacity;
+}
+
+/* First empty index entry for addr (writer only, the index is never full) */
+static size_t index_empty(const ConnectionStates* states, bt_addr_t addr) {
+    size_t mask = states->capacity - 1;
+    size_t i = home_slot(states, addr);
+    
+    while (atomic_load_explicit(&states->keys[i], memory_order_relaxed) != BT_ADDR_NONE) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Rehash every live slot into a tombstone-free index. Readers that probe
+ * meanwhile see seq change and retry. */
+static void index_rebuild(ConnectionStates* states) {
+    unsigned seq = atomic_load_explicit(&states->seq, memory_order_relaxed);
+    atomic_store_explicit(&states->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    for (size_t i = 0; i < states->capacity; i++) {
+        atomic_store_explicit(&states->keys[i], BT_ADDR_NONE, memory_order_relaxed);
+    }
+    for (StateSlot slot = 0; slot < states->max_devices; slot++) {
+        bt_addr_t owner = atomic_load_explicit(&states->owners[slot], memory_order_relaxed);
+        if (owner == BT_ADDR_NONE) continue;
+        
+        size_t i = index_empty(states, owner);
+        atomic_store_explicit(&states->slots[i], slot, memory_order_relaxed);
+        atomic_store_explicit(&states->keys[i], owner, memory_order_relaxed);
+    }
+    states->used = states->live;
+    
+    atomic_store_explicit(&states->seq, seq + 2, memory_order_release);
+}
+
+ConnectionStates* connection_states_create(size_t max_devices) {
+    if (max_devices == 0 || max_devices >= STATE_SLOT_NONE) return NULL;
+    
+    ConnectionStates* states = calloc(1, sizeof(ConnectionStates));
+    if (!states) return NULL;
+    
+    size_t capacity = MIN_INDEX_CAPACITY;
+    while (capacity / 2 < max_devices) capacity *= 2;
+    
+    states->words = malloc(max_devices * sizeof(*states->words));
+    states->owners = malloc(max_devices * sizeof(*states->owners));
+    states->free_slots = malloc(max_devices * sizeof(*states->free_slots));
+    states->keys = malloc(capacity * sizeof(*states->keys));
+    states->slots = malloc(capacity * sizeof(*states->slots));
+    if (!states->words || !states->owners || !states->free_slots || !states->keys || !states->slots) {
+        connection_states_destroy(states);
+        return NULL;
+    }
+    
+    // Hand out low slots first
+    for (size_t i = 0; i < max_devices; i++) {
+        atomic_init(&states->words[i], STATE_DISCONNECTED);
+        atomic_init(&states->owners[i], BT_ADDR_NONE);
+        states->free_slots[i] = (StateSlot)(max_devices - 1 - i);
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&states->keys[i], BT_ADDR_NONE);
+        atomic_init(&states->slots[i], 0);
+    }
+    atomic_init(&states->seq, 0);
+    
+    int bits = 0;
+    while (((size_t)1 << bits) < capacity) bits++;
+    states->max_devices = max_devices;
+    states->free_count = max_devices;
+    states->capacity = capacity;
+    states->shift = 64 - bits;
+    return states;
+}
+
+StateSlot connection_states_add(ConnectionStates* states, bt_addr_t addr) {
+    if (!states || addr == BT_ADDR_NONE || addr == INDEX_TOMBSTONE) return STATE_SLOT_NONE;
+    
+    size_t reuse;
+    size_t i = index_find(states, addr, &reuse);
+    if (i < states->capacity) {
+        return atomic_load_explicit(&states->slots[i], memory_order_relaxed);
+    }
+    if (states->free_count == 0) return STATE_SLOT_NONE;
+    
+    if (atomic_load_explicit(&states->keys[reuse], memory_order_relaxed) == BT_ADDR_NONE) {
+        // Claiming an empty entry - keep the index at most 3/4 used
+        if ((states->used + 1) * 4 > states->capacity * 3) {
+            index_rebuild(states);
+            reuse = index_empty(states, addr);
+        }
+        states->used++;
+    }
+    
+    StateSlot slot = states->free_slots[--states->free_count];
+    uint32_t owner = atomic_load_explicit(&states->words[slot], memory_order_relaxed) & STATE_WORD_OWNER;
+    atomic_store_explicit(&states->words[slot], owner | STATE_DISCONNECTED, memory_order_relaxed);
+    atomic_store_explicit(&states->owners[slot], addr, memory_order_release);
+    
+    // Slot first, then the key with release so a reader that sees the key sees the slot
+    atomic_store_explicit(&states->slots[reuse], slot, memory_order_relaxed);
+    atomic_store_explicit(&states->keys[reuse], addr, memory_order_release);
+    states->live++;
+    return slot;
+}
+
+void connection_states_remove(ConnectionStates* states, bt_addr_t addr) {
+    if (!states || addr == BT_ADDR_NONE || addr == INDEX_TOMBSTONE) return;
+    
+    size_t reuse;
+    size_t i = index_find(states, addr, &reuse);
+    if (i == states->capacity) return;
+    
+    StateSlot slot = atomic_load_explicit(&states->slots[i], memory_order_relaxed);
+    atomic_store_explicit(&states->keys[i], INDEX_TOMBSTONE, memory_order_release);
+    atomic_store_explicit(&states->owners[slot], BT_ADDR_NONE, memory_order_release);
+    
+    // New owner tag: exchanges still holding the old word fail from now on
+    uint32_t owner = atomic_load_explicit(&states->words[slot], memory_order_relaxed) & STATE_WORD_OWNER;
+    atomic_store_explicit(&states->words[slot], ((owner + OWNER_STEP) & STATE_WORD_OWNER) | STATE_DISCONNECTED,
+                          memory_order_release);
+                          
+    states->free_slots[states->free_count++] = slot;
+    states->live--;
+}
+
+StateSlot connection_states_find(const ConnectionStates* states, bt_addr_t addr, uint32_t* word) {
+    if (!states || addr == BT_ADDR_NONE || addr == INDEX_TOMBSTONE) return STATE_SLOT_NONE;
+    
+    size_t mask = states->capacity - 1;
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&states->seq, memory_order_acquire);
+        if (seq & 1) continue;
+        
+        size_t i = home_slot(states, addr);
+        for (size_t probes = 0; probes < states->capacity; probes++) {
+            bt_addr_t key = atomic_load_explicit(&states->keys[i], memory_order_acquire);
+            if (key == BT_ADDR_NONE) break;
+            if (key == addr) {
+                StateSlot slot = atomic_load_explicit(&states->slots[i], memory_order_acquire);
+                if (slot >= states->max_devices) break;
+                
+                // Still ours after the read, so value isn't a later owner's word
+                uint32_t value = atomic_load_explicit(&states->words[slot], memory_order_acquire);
+                if (atomic_load_explicit(&states->owners[slot], memory_order_acquire) != addr) break;
+                if (word) *word = value;
+                return slot;
+            }
+            i = (i + 1) & mask;
+        }
+        
+        // A miss only counts if no rebuild ran underneath it
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&states->seq, memory_order_relaxed) == seq) return STATE_SLOT_NONE;
+    }
+}
+
+uint32_t connection_states_load(const ConnectionStates* states, StateSlot slot) {
+    if (!states || slot >= states->max_devices) return STATE_DISCONNECTED;
+    return atomic_load_explicit(&states->words[slot], memory_order_acquire);
+}
+
+bool connection_states_exchange(ConnectionStates* states, StateSlot slot,
+                                uint32_t* word, uint32_t desired) {
+    if (!states || !word || slot >= states->max_devices) return false;
+    
+    desired = (desired & ~STATE_WORD_OWNER) | (*word & STATE_WORD_OWNER);
+    return atomic_compare_exchange_strong_explicit(&states->words[slot], word, desired,
+                                                   memory_order_acq_rel, memory_order_acquire);
+}
+
+void connection_states_destroy(ConnectionStates* states) {
+    if (!states) return;
+    
+    free(states->words);
+    free(states->owners);
+    free(states->free_slots);
+    free(states->keys);
+    free(states->slots);
+    free(states);
+}
@@ -0,0 +1,443 @@
+#include "bluetooth/dbus_reactor.h"
+#include "bluetooth/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <glib.h>
+
+#define REACTOR_TICK_MS 10
+
+/* libdbus timeout driven by a wheel timer. The entry is the timeout's data
+ * and lives until libdbus finalizes the DBusTimeout. */
+typedef struct {
+    struct DBusReactor* reactor;
+    DBusTimeout* owner;       // The DBusTimeout this entry is attached to
+    DBusTimeout* timeout;     // NULL once libdbus has removed it
+    bool in_flight;           // dbus_timeout_handle() running on the reactor thread
+    WheelTimer timer;
+} ReactorTimeout;
+
+/* Internal reactor structure */
+struct DBusReactor {
+    DBusConnection* conn;
+    pthread_mutex_t mutex;    // Protects watches/timers (leaf lock, never held across callbacks)
+    pthread_cond_t handled;   // Signalled when a timeout handler returns
+    GList* watches;           // DBusWatch*
+    GList* timeouts;          // ReactorTimeout* attached to a live DBusTimeout
+    GList* dead_timeouts;     // ReactorTimeout* finalized by libdbus, freed by the loop
+    pthread_t thread;         // Thread inside dbus_reactor_run()
+    TimerWheel* timers;       // libdbus timeouts and dbus_reactor_schedule() timers
+    int wake_fd;              // eventfd used to interrupt poll()
+    atomic_bool running;
+};
+
+/* Monotonic clock in milliseconds */
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Watch hooks - called by libdbus from whichever thread touches the connection */
+
+static dbus_bool_t add_watch(DBusWatch* watch, void* data) {
+    DBusReactor* reactor = data;
+
+    pthread_mutex_lock(&reactor->mutex);
+    reactor->watches = g_list_prepend(reactor->watches, watch);
+    pthread_mutex_unlock(&reactor->mutex);
+
+    dbus_reactor_wakeup(reactor);
+    return TRUE;
+}
+
+static void remove_watch(DBusWatch* watch, void* data) {
+    DBusReactor* reactor = data;
+
+    pthread_mutex_lock(&reactor->mutex);
+    reactor->watches = g_list_remove(reactor->watches, watch);
+    pthread_mutex_unlock(&reactor->mutex);
+
+    dbus_reactor_wakeup(reactor);
+}
+
+static void toggle_watch(DBusWatch* watch, void* data) {
+    (void)watch;
+    // Enabled state is re-read every iteration, the loop only has to notice
+    dbus_reactor_wakeup((DBusReactor*)data);
+}
+
+/* Timeout hooks */
+
+/* Wheel callback for a libdbus timeout - runs on the reactor thread.
+ * The handler runs unlocked (it takes the connection lock), so the entry
+ * stays in flight meanwhile and release_timeout() keeps libdbus from
+ * freeing the DBusTimeout under it. */
+static void reactor_timeout_fired(void* data) {
+    ReactorTimeout* entry = data;
+    DBusReactor* reactor = entry->reactor;
+    
+    pthread_mutex_lock(&reactor->mutex);
+    DBusTimeout* timeout = entry->timeout;
+    if (!timeout || !dbus_timeout_get_enabled(timeout)) {
+        pthread_mutex_unlock(&reactor->mutex);
+        return;
+    }
+    
+    // libdbus timeouts repeat until removed or disabled
+    timer_wheel_schedule(reactor->timers, &entry->timer, now_ms(),
+                         dbus_timeout_get_interval(timeout));
+    entry->in_flight = true;
+    pthread_mutex_unlock(&reactor->mutex);
+    
+    dbus_timeout_handle(timeout);
+    
+    pthread_mutex_lock(&reactor->mutex);
+    entry->in_flight = false;
+    pthread_cond_broadcast(&reactor->handled);
+    pthread_mutex_unlock(&reactor->mutex);
+}
+
+/* Data free function of a DBusTimeout, called by libdbus right before it
+ * frees the timeout and never with the connection lock held. Waits out a
+ * handler still using the timeout; the entry itself is freed by the loop
+ * so an expiry popped from the wheel never sees a dangling pointer. */
+static void release_timeout(void* data) {
+    ReactorTimeout* entry = data;
+    DBusReactor* reactor = entry->reactor;
+    
+    pthread_mutex_lock(&reactor->mutex);
+    timer_wheel_cancel(reactor->timers, &entry->timer);
+    entry->timeout = NULL;
+    entry->owner = NULL;
+    while (entry->in_flight && !pthread_equal(reactor->thread, pthread_self())) {
+        pthread_cond_wait(&reactor->handled, &reactor->mutex);
+    }
+    reactor->timeouts = g_list_remove(reactor->timeouts, entry);
+    reactor->dead_timeouts = g_list_prepend(reactor->dead_timeouts, entry);
+    pthread_mutex_unlock(&reactor->mutex);
+}
+
+static dbus_bool_t add_timeout(DBusTimeout* timeout, void* data) {
+    DBusReactor* reactor = data;
+
+    // A timeout added again after removal keeps its entry
+    ReactorTimeout* entry = dbus_timeout_get_data(timeout);
+    if (!entry) {
+        entry = calloc(1, sizeof(ReactorTimeout));
+        if (!entry) return FALSE;
+
+        entry->reactor = reactor;
+        entry->owner = timeout;
+        wheel_timer_init(&entry->timer, reactor_timeout_fired, entry);
+        dbus_timeout_set_data(timeout, entry, release_timeout);
+
+        pthread_mutex_lock(&reactor->mutex);
+        reactor->timeouts = g_list_prepend(reactor->timeouts, entry);
+        pthread_mutex_unlock(&reactor->mutex);
+    }
+
+    pthread_mutex_lock(&reactor->mutex);
+    entry->timeout = timeout;
+    if (dbus_timeout_get_enabled(timeout)) {
+        timer_wheel_schedule(reactor->timers, &entry->timer, now_ms(),
+                             dbus_timeout_get_interval(timeout));
+    }
+    pthread_mutex_unlock(&reactor->mutex);
+
+    dbus_reactor_wakeup(reactor);
+    return TRUE;
+}
+
+static void remove_timeout(DBusTimeout* timeout, void* data) {
+    DBusReactor* reactor = data;
+    ReactorTimeout* entry = dbus_timeout_get_data(timeout);
+    if (!entry) return;
+
+    // Called with the connection lock held, so this must not wait for a
+    // handler in flight (it needs that lock); release_timeout() does
+    pthread_mutex_lock(&reactor->mutex);
+    timer_wheel_cancel(reactor->timers, &entry->timer);
+    entry->timeout = NULL;
+    pthread_mutex_unlock(&reactor->mutex);
+}
+
+static void toggle_timeout(DBusTimeout* timeout, void* data) {
+    DBusReactor* reactor = data;
+    ReactorTimeout* entry = dbus_timeout_get_data(timeout);
+    if (!entry) return;
+
+    // Re-enabling restarts the interval
+    pthread_mutex_lock(&reactor->mutex);
+    if (dbus_timeout_get_enabled(timeout)) {
+        timer_wheel_schedule(reactor->timers, &entry->timer, now_ms(),
+                             dbus_timeout_get_interval(timeout));
+    } else {
+        timer_wheel_cancel(reactor->timers, &entry->timer);
+    }
+    pthread_mutex_unlock(&reactor->mutex);
+
+    dbus_reactor_wakeup(reactor);
+}
+
+/* Wakeup hooks - new outgoing data or newly queued incoming messages */
+
+static void wakeup_main(void* data) {
+    dbus_reactor_wakeup((DBusReactor*)data);
+}
+
+static void dispatch_status_changed(DBusConnection* conn, DBusDispatchStatus status, void* data) {
+    (void)conn;
+    if (status == DBUS_DISPATCH_DATA_REMAINS) {
+        dbus_reactor_wakeup((DBusReactor*)data);
+    }
+}
+
+/* Drain the incoming queue through the connection's filters */
+static void dispatch_all(DBusReactor* reactor) {
+    while (atomic_load(&reactor->running) &&
+           dbus_connection_dispatch(reactor->conn) == DBUS_DISPATCH_DATA_REMAINS) {
+        // Keep going until the queue is empty
+    }
+}
+
+/* Advance the wheel and run every expired timer without holding the lock */
+static void run_timers(DBusReactor* reactor) {
+    pthread_mutex_lock(&reactor->mutex);
+    timer_wheel_advance(reactor->timers, now_ms());
+    
+    WheelTimer* timer;
+    while (atomic_load(&reactor->running) && (timer = timer_wheel_pop_expired(reactor->timers)) != NULL) {
+        WheelTimerCallback callback = timer->callback;
+        void* user_data = timer->user_data;
+        
+        pthread_mutex_unlock(&reactor->mutex);
+        callback(user_data);
+        pthread_mutex_lock(&reactor->mutex);
+    }
+    pthread_mutex_unlock(&reactor->mutex);
+}
+
+/* Public API Implementation */
+
+DBusReactor* dbus_reactor_create(DBusConnection* conn) {
+    if (!conn) return NULL;
+
+    DBusReactor* reactor = calloc(1, sizeof(DBusReactor));
+    if (!reactor) return NULL;
+
+    reactor->conn = dbus_connection_ref(conn);
+
+    if (pthread_mutex_init(&reactor->mutex, NULL) != 0) {
+        dbus_connection_unref(reactor->conn);
+        free(reactor);
+        return NULL;
+    }
+    if (pthread_cond_init(&reactor->handled, NULL) != 0) {
+        pthread_mutex_destroy(&reactor->mutex);
+        dbus_connection_unref(reactor->conn);
+        free(reactor);
+        return NULL;
+    }
+
+    reactor->timers = timer_wheel_create(REACTOR_TICK_MS, now_ms());
+    reactor->wake_fd = reactor->timers ? eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) : -1;
+    if (reactor->wake_fd < 0) {
+        timer_wheel_destroy(reactor->timers);
+        pthread_cond_destroy(&reactor->handled);
+        pthread_mutex_destroy(&reactor->mutex);
+        dbus_connection_unref(reactor->conn);
+        free(reactor);
+        return NULL;
+    }
+
+    atomic_init(&reactor->running, true);
+
+    if (!dbus_connection_set_watch_functions(conn, add_watch, remove_watch,
+                                             toggle_watch, reactor, NULL) ||
+        !dbus_connection_set_timeout_functions(conn, add_timeout, remove_timeout,
+                                               toggle_timeout, reactor, NULL)) {
+        dbus_reactor_destroy(reactor);
+        return NULL;
+    }
+
+    dbus_connection_set_wakeup_main_function(conn, wakeup_main, reactor, NULL);
+    dbus_connection_set_dispatch_status_function(conn, dispatch_status_changed, reactor, NULL);
+
+    return reactor;
+}
+
+void dbus_reactor_run(DBusReactor* reactor) {
+    if (!reactor) return;
+
+    struct pollfd* fds = NULL;
+    DBusWatch** polled = NULL;
+    size_t capacity = 0;
+
+    pthread_mutex_lock(&reactor->mutex);
+    reactor->thread = pthread_self();
+    pthread_mutex_unlock(&reactor->mutex);
+
+    while (atomic_load(&reactor->running)) {
+        // Messages may already be queued (e.g. read by another thread's blocking call)
+        dispatch_all(reactor);
+        if (!atomic_load(&reactor->running)) break;
+
+        pthread_mutex_lock(&reactor->mutex);
+
+        // Safe to free here: no timer callback is running on this thread
+        GList* dead = reactor->dead_timeouts;
+        reactor->dead_timeouts = NULL;
+
+        size_t needed = g_list_length(reactor->watches) + 1;
+        if (needed > capacity) {
+            struct pollfd* new_fds = realloc(fds, needed * sizeof(struct pollfd));
+            if (new_fds) fds = new_fds;
+            DBusWatch** new_polled = realloc(polled, needed * sizeof(DBusWatch*));
+            if (new_polled) polled = new_polled;
+            if (new_fds && new_polled) capacity = needed;
+        }
+
+        size_t count = 0;
+        if (capacity > 0) {
+            fds[count].fd = reactor->wake_fd;
+            fds[count].events = POLLIN;
+            fds[count].revents = 0;
+            polled[count] = NULL;
+            count++;
+        }
+
+        for (GList* iter = reactor->watches; iter && count < capacity; iter = iter->next) {
+            DBusWatch* watch = iter->data;
+            if (!dbus_watch_get_enabled(watch)) continue;
+
+            unsigned int flags = dbus_watch_get_flags(watch);
+            fds[count].fd = dbus_watch_get_unix_fd(watch);
+            fds[count].events = 0;
+            if (flags & DBUS_WATCH_READABLE) fds[count].events |= POLLIN;
+            if (flags & DBUS_WATCH_WRITABLE) fds[count].events |= POLLOUT;
+            fds[count].revents = 0;
+            polled[count] = watch;
+            count++;
+        }
+
+        int64_t next = timer_wheel_next_timeout(reactor->timers, now_ms());
+        int timeout = next > INT32_MAX ? INT32_MAX : (int)next;
+        pthread_mutex_unlock(&reactor->mutex);
+
+        g_list_free_full(dead, free);
+
+        if (count == 0) {
+            // Out of memory for the poll set; back off instead of spinning
+            struct timespec ts = { 0, 10000000L };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+
+        int ready = poll(fds, count, timeout);
+        if (ready < 0 && errno != EINTR) {
+            log_error("Reactor poll failed: %s", strerror(errno));
+            break;
+        }
+
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) {
+                uint64_t value;
+                ssize_t n = read(reactor->wake_fd, &value, sizeof(value));
+                (void)n;
+            }
+
+            for (size_t i = 1; i < count; i++) {
+                if (!fds[i].revents) continue;
+
+                unsigned int flags = 0;
+                if (fds[i].revents & POLLIN) flags |= DBUS_WATCH_READABLE;
+                if (fds[i].revents & POLLOUT) flags |= DBUS_WATCH_WRITABLE;
+                if (fds[i].revents & POLLERR) flags |= DBUS_WATCH_ERROR;
+                if (fds[i].revents & POLLHUP) flags |= DBUS_WATCH_HANGUP;
+
+                // Skip watches libdbus dropped while we were sleeping
+                pthread_mutex_lock(&reactor->mutex);
+                bool alive = g_list_find(reactor->watches, polled[i]) != NULL;
+                pthread_mutex_unlock(&reactor->mutex);
+
+                if (alive) {
+                    dbus_watch_handle(polled[i], flags);
+                }
+            }
+        }
+
+        run_timers(reactor);
+    }
+
+    free(fds);
+    free(polled);
+}
+
+void dbus_reactor_schedule(DBusReactor* reactor, WheelTimer* timer, uint64_t delay_ms) {
+    if (!reactor || !timer) return;
+
+    pthread_mutex_lock(&reactor->mutex);
+    timer_wheel_schedule(reactor->timers, timer, now_ms(), delay_ms);
+    pthread_mutex_unlock(&reactor->mutex);
+
+    // Let the loop shorten its poll() timeout if needed
+    dbus_reactor_wakeup(reactor);
+}
+
+void dbus_reactor_cancel(DBusReactor* reactor, WheelTimer* timer) {
+    if (!reactor || !timer) return;
+
+    pthread_mutex_lock(&reactor->mutex);
+    timer_wheel_cancel(reactor->timers, timer);
+    pthread_mutex_unlock(&reactor->mutex);
+}
+
+void dbus_reactor_stop(DBusReactor* reactor) {
+    if (!reactor) return;
+
+    atomic_store(&reactor->running, false);
+    dbus_reactor_wakeup(reactor);
+}
+
+void dbus_reactor_wakeup(DBusReactor* reactor) {
+    if (!reactor) return;
+
+    uint64_t one = 1;
+    ssize_t n = write(reactor->wake_fd, &one, sizeof(one));
+    (void)n;  // EAGAIN means a wakeup is already pending
+}
+
+void dbus_reactor_destroy(DBusReactor* reactor) {
+    if (!reactor) return;
+
+    // Clearing the hooks makes libdbus remove every watch and timeout
+    dbus_connection_set_dispatch_status_function(reactor->conn, NULL, NULL, NULL);
+    dbus_connection_set_wakeup_main_function(reactor->conn, NULL, NULL, NULL);
+    dbus_connection_set_watch_functions(reactor->conn, NULL, NULL, NULL, NULL, NULL);
+    dbus_connection_set_timeout_functions(reactor->conn, NULL, NULL, NULL, NULL, NULL);
+
+    // Timeouts still owned by pending calls outlive the reactor; detach
+    // them (which runs release_timeout) so their finalization never sees it
+    while (reactor->timeouts) {
+        ReactorTimeout* entry = reactor->timeouts->data;
+        dbus_timeout_set_data(entry->owner, NULL, NULL);
+    }
+
+    g_list_free(reactor->watches);
+    g_list_free_full(reactor->dead_timeouts, free);
+    timer_wheel_destroy(reactor->timers);
+
+    close(reactor->wake_fd);
+    dbus_connection_unref(reactor->conn);
+    pthread_cond_destroy(&reactor->handled);
+    pthread_mutex_destroy(&reactor->mutex);
+    free(reactor);
+}
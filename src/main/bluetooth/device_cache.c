@@ -0,0 +1,285 @@
+#include "bluetooth/device_cache.h"
+#include "bluetooth/device_table.h"
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC 0x43445442u           // "BTDC"
+#define CACHE_VERSION 2
+#define MIN_CAPACITY 1024
+
+_Static_assert(sizeof(DeviceCacheRecord) == 64, "cache records must stay 64 bytes");
+
+/* File header, padded to one record */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t capacity;                    // Records the file has room for
+    uint64_t count;                       // Records committed
+    uint8_t pad[32];
+} CacheHeader;
+
+_Static_assert(sizeof(CacheHeader) == sizeof(DeviceCacheRecord), "header must be one record");
+
+/* Internal cache structure */
+struct DeviceCache {
+    char* path;
+    int fd;
+    CacheHeader* header;                  // Start of the mapping
+    DeviceCacheRecord* records;           // Follows the header
+    size_t map_size;
+    DeviceTable* index;                   // bt_addr_t -> record index + 1
+};
+
+static size_t file_size(uint64_t capacity) {
+    return sizeof(CacheHeader) + capacity * sizeof(DeviceCacheRecord);
+}
+
+/* XOR of every byte but the check itself, never 0 so zeroed space fails */
+static uint8_t record_check(const DeviceCacheRecord* record) {
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint8_t check = 0x5A;
+    
+    for (size_t i = 0; i < sizeof(*record); i++) {
+        if (bytes + i != &record->check) check ^= bytes[i];
+    }
+    return check ? check : 1;
+}
+
+static bool map_file(DeviceCache* cache, size_t size) {
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+    if (map == MAP_FAILED) return false;
+    
+    cache->header = map;
+    cache->records = (DeviceCacheRecord*)((CacheHeader*)map + 1);
+    cache->map_size = size;
+    return true;
+}
+
+static void unmap_file(DeviceCache* cache) {
+    if (cache->header) {
+        munmap(cache->header, cache->map_size);
+        cache->header = NULL;
+    }
+}
+
+/* Write an empty file with room for capacity records */
+static bool init_file(int fd, uint64_t capacity) {
+    CacheHeader header = {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .record_size = sizeof(DeviceCacheRecord),
+        .capacity = capacity,
+        .count = 0
+    };
+    
+    return ftruncate(fd, 0) == 0 &&
+           ftruncate(fd, (off_t)file_size(capacity)) == 0 &&
+           pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+}
+
+/* Index every committed record, later ones replacing earlier ones */
+static bool build_index(DeviceCache* cache) {
+    device_table_clear(cache->index, NULL);
+    
+    for (uint64_t i = 0; i < cache->header->count; i++) {
+        const DeviceCacheRecord* record = &cache->records[i];
+        if (record->check != record_check(record) || record->addr == BT_ADDR_NONE) continue;
+        
+        if (record->flags & DEVICE_CACHE_REMOVED) {
+            device_table_remove(cache->index, record->addr);
+            continue;
+        }
+        if (!device_table_insert(cache->index, record->addr, (void*)(uintptr_t)(i + 1), NULL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Rewrite the live records into a fresh file and swap it in */
+static bool compact(DeviceCache* cache) {
+    size_t live = device_table_count(cache->index);
+    uint64_t capacity = MIN_CAPACITY;
+    while (capacity < live * 2) capacity *= 2;
+    
+    size_t tmp_len = strlen(cache->path) + 5;
+    char* tmp_path = malloc(tmp_len);
+    if (!tmp_path) return false;
+    snprintf(tmp_path, tmp_len, "%s.tmp", cache->path);
+    
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(tmp_path);
+        return false;
+    }
+    
+    bool ok = init_file(fd, capacity);
+    
+    // Copy in file order so the new file stays in update order
+    uint64_t written = 0;
+    for (uint64_t i = 0; ok && i < cache->header->count; i++) {
+        const DeviceCacheRecord* record = &cache->records[i];
+        void* latest = device_table_lookup(cache->index, record->addr);
+        if (!latest || (uintptr_t)latest != i + 1) continue;
+        
+        off_t offset = (off_t)file_size(written);
+        ok = pwrite(fd, record, sizeof(*record), offset) == (ssize_t)sizeof(*record);
+        written++;
+    }
+    
+    if (ok) {
+        uint64_t count = written;
+        ok = pwrite(fd, &count, sizeof(count), offsetof(CacheHeader, count)) == (ssize_t)sizeof(count) &&
+             fsync(fd) == 0;
+    }
+    
+    // Map and index the new file before giving up the old one, so a
+    // failure anywhere leaves the cache working on the old file
+    DeviceCache fresh = { .fd = fd, .index = ok ? device_table_create(0) : NULL };
+    ok = ok && fresh.index && map_file(&fresh, file_size(capacity)) && build_index(&fresh) &&
+         rename(tmp_path, cache->path) == 0;
+    
+    if (!ok) {
+        unmap_file(&fresh);
+        device_table_destroy(fresh.index, NULL);
+        close(fd);
+        unlink(tmp_path);
+        free(tmp_path);
+        return false;
+    }
+    free(tmp_path);
+    
+    unmap_file(cache);
+    close(cache->fd);
+    device_table_destroy(cache->index, NULL);
+    
+    cache->fd = fresh.fd;
+    cache->header = fresh.header;
+    cache->records = fresh.records;
+    cache->map_size = fresh.map_size;
+    cache->index = fresh.index;
+    return true;
+}
+
+DeviceCache* device_cache_open(const char* path) {
+    if (!path) return NULL;
+    
+    DeviceCache* cache = calloc(1, sizeof(DeviceCache));
+    if (!cache) return NULL;
+    
+    cache->path = strdup(path);
+    cache->index = device_table_create(0);
+    cache->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (!cache->path || !cache->index || cache->fd < 0) {
+        device_cache_close(cache);
+        return NULL;
+    }
+    
+    // Validate the header; anything unexpected means starting over
+    struct stat st;
+    CacheHeader header;
+    bool valid = fstat(cache->fd, &st) == 0 &&
+                 pread(cache->fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                 header.magic == CACHE_MAGIC && header.version == CACHE_VERSION &&
+                 header.record_size == sizeof(DeviceCacheRecord) &&
+                 header.count <= header.capacity &&
+                 (uint64_t)st.st_size >= file_size(header.capacity);
+    
+    if (!valid) {
+        header.capacity = MIN_CAPACITY;
+        if (!init_file(cache->fd, header.capacity)) {
+            device_cache_close(cache);
+            return NULL;
+        }
+    }
+    
+    if (!map_file(cache, file_size(header.capacity)) || !build_index(cache)) {
+        device_cache_close(cache);
+        return NULL;
+    }
+    
+    return cache;
+}
+
+const DeviceCacheRecord* device_cache_find(const DeviceCache* cache, bt_addr_t addr) {
+    if (!cache) return NULL;
+    
+    uintptr_t index = (uintptr_t)device_table_lookup(cache->index, addr);
+    return index ? &cache->records[index - 1] : NULL;
+}
+
+/* Append a record and commit it */
+static bool append(DeviceCache* cache, const DeviceCacheRecord* record, uint64_t* written) {    
+    if (cache->header->count == cache->header->capacity && !compact(cache)) {
+        return false;
+    }
+    
+    uint64_t index = cache->header->count;
+    DeviceCacheRecord* slot = &cache->records[index];
+    
+    *slot = *record;
+    slot->alias[DEVICE_CACHE_ALIAS_MAX - 1] = '\0';
+    slot->check = record_check(slot);
+    
+    // Commit only once the record itself is in place
+    atomic_thread_fence(memory_order_release);
+    cache->header->count = index + 1;
+    
+    *written = index;
+    return true;
+}
+
+bool device_cache_put(DeviceCache* cache, const DeviceCacheRecord* record) {
+    if (!cache || !record || record->addr == BT_ADDR_NONE) return false;
+    
+    DeviceCacheRecord copy = *record;
+    copy.flags &= (uint8_t)~DEVICE_CACHE_REMOVED;
+    
+    uint64_t index;
+    return append(cache, &copy, &index) &&
+           device_table_insert(cache->index, record->addr, (void*)(uintptr_t)(index + 1), NULL);
+}
+
+bool device_cache_remove(DeviceCache* cache, bt_addr_t addr) {
+    if (!cache || !device_table_lookup(cache->index, addr)) return false;
+    
+    // Forget the address only once the tombstone is on disk
+    DeviceCacheRecord tombstone = { .addr = addr, .flags = DEVICE_CACHE_REMOVED };
+    uint64_t index;
+    return append(cache, &tombstone, &index) && device_table_remove(cache->index, addr);
+}
+
+size_t device_cache_count(const DeviceCache* cache) {
+    return cache ? device_table_count(cache->index) : 0;
+}
+
+const DeviceCacheRecord* device_cache_next(const DeviceCache* cache, size_t* cursor) {
+    bt_addr_t addr;
+    void* index;
+    
+    if (!cache || !cursor || !device_table_next(cache->index, cursor, &addr, &index)) return NULL;
+    return &cache->records[(uintptr_t)index - 1];
+}
+
+void device_cache_close(DeviceCache* cache) {
+    if (!cache) return;
+    
+    if (cache->header) {
+        msync(cache->header, cache->map_size, MS_ASYNC);
+    }
+    unmap_file(cache);
+    if (cache->fd >= 0) {
+        close(cache->fd);
+    }
+    device_table_destroy(cache->index, NULL);
+    free(cache->path);
+    free(cache);
+}
@@ -1,132 +1,773 @@
 #include "bluetooth/device_manager.h"
+#include "bluetooth/bus_core.h"
+#include "bluetooth/dbus_reactor.h"
+#include "bluetooth/device_cache.h"
+#include "bluetooth/device_properties.h"
+#include "bluetooth/device_records.h"
+#include "bluetooth/device_store.h"
+#include "bluetooth/device_table.h"
+#include "bluetooth/event_queue.h"
+#include "bluetooth/logger.h"
+#include "bluetooth/metrics.h"
+#include "bluetooth/string_arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 #include <dbus/dbus.h>
 
 #define BLUEZ_SERVICE "org.bluez"
+#define BLUEZ_ROOT "/org/bluez"
 #define OBJECT_MANAGER_INTERFACE "org.freedesktop.DBus.ObjectManager"
 #define ADAPTER_INTERFACE "org.bluez.Adapter1"
 #define DEVICE_INTERFACE "org.bluez.Device1"
 
-/* Internal device manager structure */
+#define DEFAULT_SNAPSHOT_INTERVAL_MS 100
+#define DEFAULT_DUPLICATE_WINDOW_MS 1000
+#define DEFAULT_RSSI_THRESHOLD_DB 5
+#define MATCH_RULE_MAX 512
+#define MATCH_RULE_COUNT 3
+#define CACHE_REFRESH_S 300            // Rewrite an unchanged cache record at most this often
+#define AGING_INTERVAL_MS 5000         // Longest gap between aging passes
+#define DEFAULT_METRICS_INTERVAL_MS 10000
+#define ADAPTER_BITS 4
+#define MAX_ADAPTERS (1 << ADAPTER_BITS) // Adapter slots over the manager's lifetime
+#define CALL_TIMEOUT_MS 1000
+
+/* Metrics counters */
+enum {
+    COUNT_SIGNALS_RECEIVED,
+    COUNT_SIGNALS_REJECTED,
+    COUNT_INTERFACES_ADDED,
+    COUNT_PROPERTIES_CHANGED,
+    COUNT_UPDATES_RECEIVED,
+    COUNT_UPDATES_SUPPRESSED,
+    COUNT_DEVICES_LOST,
+    COUNT_SNAPSHOTS,
+    COUNTER_COUNT
+};
+
+/* Metrics histograms */
+enum {
+    LATENCY_PARSE,
+    LATENCY_LOCK_WAIT,
+    LATENCY_LOCK_HOLD,
+    LATENCY_CALLBACK_DELAY,
+    LATENCY_COUNT
+};
+
+/* Published device list, immutable once built */
+struct DeviceSnapshot {
+    atomic_int refcount;
+    uint64_t version;
+    size_t count;
+    bt_addr_t* keys;               // Sorted, parallel to devices
+    BluetoothDevice* devices;
+    StringArena* strings;          // Names and aliases of devices, owned
+};
+
+/* Last advertisement let through for a device (bus thread only) */
+typedef struct {
+    uint64_t accepted_ms;
+    int8_t rssi;
+} DuplicateEntry;
+
+/* Events raised under a lock, queued for the callbacks once it is released */
+typedef struct {
+    DeviceEvent* events;
+    size_t count;
+    size_t capacity;
+} EventBuffer;
+
+/* One controller and its shard of the device table. Slots are only
+ * released by destroy, so pointers to an adapter and its path stay valid;
+ * an adapter that is unplugged and comes back gets its old slot. Strings
+ * in its store are only valid while the adapter is locked. */
+typedef struct {
+    char* path;                    // /org/bluez/hciN, set once
+    size_t path_len;
+    size_t index;                  // Position in manager->adapters
+    uint8_t hci;                   // N of hciN, how the cache names it across runs
+    atomic_bool present;           // Adapter1 exists in bluetoothd right now
+    bool discovering;              // Our discovery runs on it (manager->mutex)
+    pthread_mutex_t mutex;         // Guards this shard only
+    uint64_t locked_at_ns;         // When mutex was last taken (under mutex)
+    EventBuffer staged;            // Events raised under mutex
+    DeviceStore* devices;          // Compact per-device storage, keyed by bt_addr_t
+    DeviceRecords* records;        // Seqlock copies of every device for lock-free reads
+} Adapter;
+
+/* Internal device manager structure. Lock order: mutex, then an adapter's
+ * mutex, then cache_mutex; never two adapters at once. */
 struct DeviceManager {
     DeviceManagerConfig config;
-    DBusConnection* conn;
-    pthread_mutex_t mutex;
-    GHashTable* devices;           // key: MAC address, value: BluetoothDevice*
-    bool scanning;
-    bool running;
-    pthread_t thread;
-    char* adapter_path;
+    BusCore* bus;                  // Shared connection and bus thread
+    DBusConnection* conn;          // The bus core's
+    pthread_mutex_t mutex;         // Scan schedule, filter and per-adapter discovery state
+    uint64_t locked_at_ns;         // When mutex was last taken (under mutex)
+    Metrics* metrics;
+    EventQueue* callbacks;         // Runs user callbacks off the lock (NULL = none configured)
+    EventBuffer staged;            // Events raised under mutex, queued by unlock_manager()
+    Adapter adapters[MAX_ADAPTERS];
+    atomic_size_t adapter_count;   // Slots in use; only grows, on the bus thread after create
+    pthread_mutex_t cache_mutex;   // Guards cache, which every shard writes to
+    DeviceCache* cache;            // Persistent device cache, may be NULL
+    atomic_uint_fast64_t generation; // Bumped on every change to any shard
+    uint64_t published_generation; // Generation captured by the last snapshot
+    WheelTimer publish_timer;      // Coalesces changes into one snapshot rebuild
+    atomic_bool publish_pending;   // publish_timer is scheduled
+    pthread_mutex_t snapshot_mutex; // Guards the snapshot pointer swap/ref only
+    DeviceSnapshot* snapshot;      // Latest published snapshot
+    DeviceTable* duplicates;       // Sighting key -> DuplicateEntry*, owned by the bus thread
+    char* match_rules[MATCH_RULE_COUNT]; // Rules added at create, removed on destroy
+    DiscoveryFilter filter;        // Deep copy, pushed before StartDiscovery
+    bool has_filter;
+    bool scanning;                 // A discovery session is running
+    bool radio_on;                 // A scan window is open (discovery on every present adapter)
+    bool session_started;          // Session came from start_discovery, not a lone burst
+    WheelTimer scan_timer;         // Ends the current scan window or the pause after it
+    uint64_t scan_deadline_ms;     // When scan_timer is due, to ignore stale expiries
+    WheelTimer aging_timer;        // Expires devices past device_ttl_s, prunes duplicates
+    WheelTimer metrics_timer;      // Rewrites config.metrics_path
+    DBusReactor* reactor;          // The bus core's, set once the initial load is done
 };
 
-/* Convert DBus string to device type */
-static DeviceType get_device_type_from_class(uint32_t class) {
-    uint32_t major_class = (class >> 8) & 0x1F;
-    uint32_t minor_class = (class >> 2) & 0x3F;
-    
-    switch (major_class) {
-        case 0x04:  // Audio/Video
-            if (minor_class == 0x04)  // Headset
-                return DEVICE_AUDIO_SINK;
-            else if (minor_class == 0x08)  // Hands-free
-                return DEVICE_AUDIO_SINK;
-            else if (minor_class == 0x03)  // Microphone
-                return DEVICE_AUDIO_SOURCE;
-            return DEVICE_AUDIO_SINK;
-            
-        case 0x05:  // Peripheral
-            switch (minor_class) {
-                case 0x01:  // Keyboard
-                    return DEVICE_KEYBOARD;
-                case 0x02:  // Mouse
-                    return DEVICE_MOUSE;
-                case 0x03:  // Keyboard/Mouse combo
-                    return DEVICE_KEYBOARD;
-            }
-            return DEVICE_INPUT;
-            
-        case 0x02:  // Phone
-            return DEVICE_PHONE;
-            
-        case 0x01:  // Computer
-            return DEVICE_COMPUTER;
-            
-        default:
-            return DEVICE_UNKNOWN;
+/* Monotonic clock in milliseconds */
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Address tagged with the adapter that saw it; sorts by address first */
+static inline uint64_t sighting_key(bt_addr_t addr, size_t adapter) {
+    return addr << ADAPTER_BITS | adapter;
+}
+
+/* Whether a sighting at rssi beats the best so far; 0 is unknown and never wins */
+static inline bool stronger(int8_t rssi, int8_t best) {
+    return rssi != 0 && (best == 0 || rssi > best);
+}
+
+/* Adapter slots handed out so far */
+static size_t adapter_count(const DeviceManager* manager) {
+    return atomic_load_explicit(&manager->adapter_count, memory_order_acquire);
+}
+
+/* Take the events staged in buffer (its lock held) */
+static EventBuffer take_events(EventBuffer* buffer) {
+    EventBuffer taken = *buffer;
+    memset(buffer, 0, sizeof(*buffer));
+    return taken;
+}
+
+/* Hand taken events to the callback executor (no lock held) */
+static void queue_events(DeviceManager* manager, EventBuffer* events) {
+    if (events->count > 0) {
+        event_queue_push(manager->callbacks, events->events, events->count);
     }
+    free(events->events);
+}
+
+/* Take manager->mutex, recording how long we waited for it */
+static void lock_manager(DeviceManager* manager) {
+    uint64_t start = metrics_now_ns();
+    pthread_mutex_lock(&manager->mutex);
+    manager->locked_at_ns = metrics_now_ns();
+    metrics_record(manager->metrics, LATENCY_LOCK_WAIT, manager->locked_at_ns - start);
 }
 
-/* Parse DBus message for device properties */
-static BluetoothDevice* parse_device_properties(DBusMessageIter *iter) {
-    BluetoothDevice* device = calloc(1, sizeof(BluetoothDevice));
-    if (!device) return NULL;
+/* Release manager->mutex, recording how long it was held, then queue the
+ * events raised while it was held */
+static void unlock_manager(DeviceManager* manager) {
+    uint64_t held = metrics_now_ns() - manager->locked_at_ns;
+    EventBuffer staged = take_events(&manager->staged);
+    pthread_mutex_unlock(&manager->mutex);
+    metrics_record(manager->metrics, LATENCY_LOCK_HOLD, held);
     
-    DBusMessageIter dict_iter;
-    dbus_message_iter_recurse(iter, &dict_iter);
+    queue_events(manager, &staged);
+}
+
+/* Same for one adapter's shard */
+static void lock_adapter(DeviceManager* manager, Adapter* adapter) {
+    uint64_t start = metrics_now_ns();
+    pthread_mutex_lock(&adapter->mutex);
+    adapter->locked_at_ns = metrics_now_ns();
+    metrics_record(manager->metrics, LATENCY_LOCK_WAIT, adapter->locked_at_ns - start);
+}
+
+static void unlock_adapter(DeviceManager* manager, Adapter* adapter) {
+    // Store strings are only used under the lock, so this is the point
+    // where the names of removed devices can go
+    device_store_compact_strings(adapter->devices);
     
-    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
-        DBusMessageIter entry_iter, variant_iter;
-        char *key = NULL;
+    uint64_t held = metrics_now_ns() - adapter->locked_at_ns;
+    EventBuffer staged = take_events(&adapter->staged);
+    pthread_mutex_unlock(&adapter->mutex);
+    metrics_record(manager->metrics, LATENCY_LOCK_HOLD, held);
+    
+    queue_events(manager, &staged);
+}
+
+/* Remember an event for the callbacks (the buffer's lock held) */
+static void stage_event(EventBuffer* buffer, const DeviceEvent* event) {
+    if (buffer->count == buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 8;
+        DeviceEvent* grown = realloc(buffer->events, capacity * sizeof(DeviceEvent));
+        if (!grown) {
+            log_warn("Out of memory, dropping a device event..");
+            return;
+        }
+        buffer->events = grown;
+        buffer->capacity = capacity;
+    }
+    buffer->events[buffer->count++] = *event;
+}
+
+/* Whether an adapter other than this one knows addr. Lock-free, so it can
+ * be asked with a shard lock held. */
+static bool known_elsewhere(DeviceManager* manager, const Adapter* adapter, bt_addr_t addr) {
+    size_t count = adapter_count(manager);
+    BluetoothDevice device;
+    
+    for (size_t i = 0; i < count; i++) {
+        const Adapter* other = &manager->adapters[i];
+        if (other != adapter && device_records_read(other->records, addr, &device, NULL)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Report a device to on_discovered or on_lost (adapter->mutex held). Only
+ * the first adapter to find a device and the last to lose it report it. */
+static void stage_device_event(DeviceManager* manager, Adapter* adapter, DeviceEventType type,
+                               const BluetoothDevice* device, bt_addr_t addr) {
+    if (type == DEVICE_EVENT_DISCOVERED ? !manager->config.on_discovered : !manager->config.on_lost) return;
+    if (known_elsewhere(manager, adapter, addr)) return;
+    
+    DeviceEvent event = { .type = type, .device = *device };
+    strncpy(event.strings.name, device->name, DEVICE_STRING_MAX - 1);
+    strncpy(event.strings.alias, device->alias, DEVICE_STRING_MAX - 1);
+    stage_event(&adapter->staged, &event);
+}
+
+/* Callback executor: hand a batch of events to the user's callbacks */
+static void deliver_events(DeviceEvent* events, size_t count, void* data) {
+    DeviceManager* manager = data;
+    const DeviceManagerConfig* config = &manager->config;
+    uint64_t now = metrics_now_ns();
+    
+    for (size_t i = 0; i < count; i++) {
+        DeviceEvent* event = &events[i];
+        metrics_record(manager->metrics, LATENCY_CALLBACK_DELAY, now - event->queued_ns);
+        event->device.name = event->strings.name;
+        event->device.alias = event->strings.alias;
         
-        dbus_message_iter_recurse(&dict_iter, &entry_iter);
-        dbus_message_iter_get_basic(&entry_iter, &key);
+        switch (event->type) {
+            case DEVICE_EVENT_DISCOVERED:
+                config->on_discovered(&event->device, config->user_data);
+                break;
+            case DEVICE_EVENT_LOST:
+                config->on_lost(&event->device, config->user_data);
+                break;
+            case DEVICE_EVENT_SCAN_STATUS:
+                config->on_scan_status(event->active, config->user_data);
+                break;
+            case DEVICE_EVENT_ADAPTER:
+                config->on_adapter(event->adapter, event->active, config->user_data);
+                break;
+        }
+    }
+}
+
+/* Duplicate filter, runs on the bus thread before the shard lock is
+ * taken. An RSSI-only update is dropped if it arrives within the window
+ * of the last one let through from the same adapter and RSSI moved no more
+ * than the threshold; anything carrying another property always passes. */
+static bool is_duplicate(DeviceManager* manager, const Adapter* adapter, bt_addr_t addr,
+                         const BluetoothDevice* device, uint32_t changed) {
+    if (!manager->config.filter_duplicates || !(changed & DEVICE_PROP_BIT(DEVICE_PROP_RSSI))) {
+        return false;
+    }
+    metrics_add(manager->metrics, COUNT_UPDATES_RECEIVED, 1);
+    
+    uint64_t now = now_ms();
+    uint64_t key = sighting_key(addr, adapter->index);
+    DuplicateEntry* entry = device_table_lookup(manager->duplicates, key);
+    
+    if (entry && changed == DEVICE_PROP_BIT(DEVICE_PROP_RSSI)) {
+        int window = manager->config.duplicate_window_ms > 0 ?
+                     manager->config.duplicate_window_ms : DEFAULT_DUPLICATE_WINDOW_MS;
+        int threshold = manager->config.rssi_threshold_db > 0 ?
+                        manager->config.rssi_threshold_db : DEFAULT_RSSI_THRESHOLD_DB;
+        int delta = abs(device->rssi - entry->rssi);
         
-        dbus_message_iter_next(&entry_iter);
-        dbus_message_iter_recurse(&entry_iter, &variant_iter);
-        
-        if (strcmp(key, "Address") == 0) {
-            char *address;
-            dbus_message_iter_get_basic(&variant_iter, &address);
-            strncpy(device->address, address, sizeof(device->address) - 1);
-        } else if (strcmp(key, "Name") == 0) {
-            char *name;
-            dbus_message_iter_get_basic(&variant_iter, &name);
-            strncpy(device->name, name, sizeof(device->name) - 1);
-        } else if (strcmp(key, "Alias") == 0) {
-            char *alias;
-            dbus_message_iter_get_basic(&variant_iter, &alias);
-            strncpy(device->alias, alias, sizeof(device->alias) - 1);
-        } else if (strcmp(key, "Class") == 0) {
-            uint32_t class;
-            dbus_message_iter_get_basic(&variant_iter, &class);
-            device->class = class;
-            device->type = get_device_type_from_class(class);
-        } else if (strcmp(key, "Paired") == 0) {
-            dbus_bool_t paired;
-            dbus_message_iter_get_basic(&variant_iter, &paired);
-            device->paired = paired;
-        } else if (strcmp(key, "Trusted") == 0) {
-            dbus_bool_t trusted;
-            dbus_message_iter_get_basic(&variant_iter, &trusted);
-            device->trusted = trusted;
-        } else if (strcmp(key, "Blocked") == 0) {
-            dbus_bool_t blocked;
-            dbus_message_iter_get_basic(&variant_iter, &blocked);
-            device->blocked = blocked;
-        } else if (strcmp(key, "RSSI") == 0) {
-            int16_t rssi;
-            dbus_message_iter_get_basic(&variant_iter, &rssi);
-            device->rssi = (int8_t)rssi;
-        }
-        
-        dbus_message_iter_next(&dict_iter);
+        if (now - entry->accepted_ms < (uint64_t)window && delta <= threshold) {
+            metrics_add(manager->metrics, COUNT_UPDATES_SUPPRESSED, 1);
+            return true;
+        }
+    }
+    
+    if (!entry) {
+        entry = malloc(sizeof(DuplicateEntry));
+        if (!entry) return false;
+        if (!device_table_insert(manager->duplicates, key, entry, NULL)) {
+            free(entry);
+            return false;
+        }
     }
+    entry->accepted_ms = now;
+    entry->rssi = device->rssi;
+    return false;
+}
+
+/* Decode Device1 properties and fill in the alias the way BlueZ would.
+ * name/alias point into the message and are only valid until it is
+ * released. Returns the DEVICE_PROP_BIT mask of decoded properties. */
+static uint32_t parse_device_properties(DBusMessageIter *iter, BluetoothDevice* device) {
+    uint32_t decoded = device_properties_decode(iter, device);
     
     // If alias is empty, copy name to alias
-    if (strlen(device->alias) == 0 && strlen(device->name) > 0) {
-        strncpy(device->alias, device->name, sizeof(device->alias) - 1);
+    if ((!device->alias || !device->alias[0]) && device->name && device->name[0]) {
+        device->alias = device->name;
     }
     
     // If both are empty, use address as alias
-    if (strlen(device->alias) == 0 && strlen(device->address) > 0) {
-        strncpy(device->alias, device->address, sizeof(device->alias) - 1);
+    if ((!device->alias || !device->alias[0]) && device->address[0]) {
+        device->alias = device->address;
+    }
+    
+    return decoded;
+}
+
+static void forget_device(DeviceManager* manager, Adapter* adapter, DeviceSlot slot, bool lost);
+
+/* Copy a parsed device into a new slot of an adapter's store, seen at
+ * seen_ms. Evicts the adapter's least recently seen unpaired device if that
+ * takes it past max_devices (adapter->mutex held). */
+static DeviceSlot store_device(DeviceManager* manager, Adapter* adapter, bt_addr_t key,
+                               const BluetoothDevice* device, uint64_t seen_ms) {
+    DeviceStore* store = adapter->devices;
+    DeviceSlot slot = device_store_add(store, key);
+    if (slot == DEVICE_SLOT_NONE) return slot;
+    
+    if (!device_store_set_name(store, slot, device->name) ||
+        !device_store_set_alias(store, slot, device->alias)) {
+        device_store_remove(store, slot);
+        return DEVICE_SLOT_NONE;
+    }
+    device_store_set_rssi(store, slot, device->rssi);
+    device_store_set_state(store, slot, device->state);
+    device_store_set_type(store, slot, device->type);
+    device_store_set_class(store, slot, device->class);
+    device_store_set_flag(store, slot, DEVICE_FLAG_PAIRED, device->paired);
+    device_store_set_flag(store, slot, DEVICE_FLAG_TRUSTED, device->trusted);
+    device_store_set_flag(store, slot, DEVICE_FLAG_BLOCKED, device->blocked);
+    
+    // Paired devices never age out
+    device_store_touch(store, slot, seen_ms);
+    device_store_set_aging(store, slot, !device->paired);
+    
+    size_t max = manager->config.max_devices > 0 ? (size_t)manager->config.max_devices : 0;
+    while (max > 0 && device_store_count(store) > max) {
+        DeviceSlot oldest = device_store_oldest(store);
+        if (oldest == DEVICE_SLOT_NONE || oldest == slot) break;
+        forget_device(manager, adapter, oldest, true);
+    }
+    
+    return slot;
+}
+
+/* Apply the decoded properties in changed to an existing device (adapter->mutex held) */
+static bool update_device(Adapter* adapter, DeviceSlot slot, const BluetoothDevice* device,
+                          uint32_t changed) {
+    DeviceStore* store = adapter->devices;
+    bool updated = false;
+    
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_RSSI)) {
+        device_store_set_rssi(store, slot, device->rssi);
+        updated = true;
+    }
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_NAME)) {
+        updated |= device_store_set_name(store, slot, device->name);
+    }
+    if ((changed & DEVICE_PROP_BIT(DEVICE_PROP_ALIAS)) &&
+        !(device_store_flags(store, slot) & DEVICE_FLAG_USER_ALIAS)) {
+        updated |= device_store_set_alias(store, slot, device->alias);
+    }
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_CLASS)) {
+        device_store_set_class(store, slot, device->class);
+        device_store_set_type(store, slot, device->type);
+        updated = true;
+    }
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_CONNECTED)) {
+        device_store_set_state(store, slot, device->state);
+        updated = true;
+    }
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_PAIRED)) {
+        device_store_set_flag(store, slot, DEVICE_FLAG_PAIRED, device->paired);
+        device_store_set_aging(store, slot, !device->paired);
+        updated = true;
+    }
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_TRUSTED)) {
+        device_store_set_flag(store, slot, DEVICE_FLAG_TRUSTED, device->trusted);
+        updated = true;
+    }
+    if (changed & DEVICE_PROP_BIT(DEVICE_PROP_BLOCKED)) {
+        device_store_set_flag(store, slot, DEVICE_FLAG_BLOCKED, device->blocked);
+        updated = true;
+    }
+    
+    return updated;
+}
+
+/* Copy a device into one allocation with its name and alias, for callers
+ * to keep and free() */
+static BluetoothDevice* copy_device(const BluetoothDevice* device) {
+    size_t name_size = strlen(device->name) + 1;
+    size_t alias_size = strlen(device->alias) + 1;
+    BluetoothDevice* copy = malloc(sizeof(BluetoothDevice) + name_size + alias_size);
+    if (!copy) return NULL;
+    
+    char* strings = (char*)(copy + 1);
+    *copy = *device;
+    copy->name = memcpy(strings, device->name, name_size);
+    copy->alias = memcpy(strings + name_size, device->alias, alias_size);
+    return copy;
+}
+
+/* Snapshots */
+
+static DeviceSnapshot* snapshot_new(size_t count, uint64_t version) {
+    DeviceSnapshot* snapshot = calloc(1, sizeof(DeviceSnapshot));
+    if (!snapshot) return NULL;
+    
+    snapshot->strings = string_arena_create();
+    if (!snapshot->strings) {
+        free(snapshot);
+        return NULL;
+    }
+    
+    if (count > 0) {
+        snapshot->keys = malloc(count * sizeof(bt_addr_t));
+        snapshot->devices = malloc(count * sizeof(BluetoothDevice));
+        if (!snapshot->keys || !snapshot->devices) {
+            free(snapshot->keys);
+            free(snapshot->devices);
+            string_arena_destroy(snapshot->strings);
+            free(snapshot);
+            return NULL;
+        }
+    }
+    
+    atomic_init(&snapshot->refcount, 1);
+    snapshot->version = version;
+    return snapshot;
+}
+
+/* Make room for count entries in a snapshot being built */
+static bool snapshot_reserve(DeviceSnapshot* snapshot, size_t* capacity, size_t count) {
+    if (count <= *capacity) return true;
+    
+    bt_addr_t* keys = realloc(snapshot->keys, count * sizeof(bt_addr_t));
+    if (!keys) return false;
+    snapshot->keys = keys;
+    
+    BluetoothDevice* devices = realloc(snapshot->devices, count * sizeof(BluetoothDevice));
+    if (!devices) return false;
+    snapshot->devices = devices;
+    
+    *capacity = count;
+    return true;
+}
+
+/* Sort keys and devices together (heap sort - no scratch space, no recursion) */
+static void snapshot_sift_down(DeviceSnapshot* snapshot, size_t root, size_t end) {
+    bt_addr_t* keys = snapshot->keys;
+    BluetoothDevice* devices = snapshot->devices;
+    
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= end) break;
+        if (child + 1 < end && keys[child + 1] > keys[child]) child++;
+        if (keys[root] >= keys[child]) break;
+        
+        bt_addr_t key = keys[root];
+        keys[root] = keys[child];
+        keys[child] = key;
+        
+        BluetoothDevice device = devices[root];
+        devices[root] = devices[child];
+        devices[child] = device;
+        
+        root = child;
+    }
+}
+
+static void snapshot_sort(DeviceSnapshot* snapshot) {
+    size_t n = snapshot->count;
+    if (n < 2) return;
+    
+    for (size_t i = n / 2; i-- > 0; ) {
+        snapshot_sift_down(snapshot, i, n);
+    }
+    for (size_t end = n - 1; end > 0; end--) {
+        bt_addr_t key = snapshot->keys[0];
+        snapshot->keys[0] = snapshot->keys[end];
+        snapshot->keys[end] = key;
+        
+        BluetoothDevice device = snapshot->devices[0];
+        snapshot->devices[0] = snapshot->devices[end];
+        snapshot->devices[end] = device;
+        
+        snapshot_sift_down(snapshot, 0, end);
+    }
+}
+
+/* Sorted by sighting key, fuse each address into the copy of the adapter
+ * hearing it best (the first adapter's if none has an RSSI) */
+static void snapshot_merge(DeviceSnapshot* snapshot) {
+    size_t merged = 0;
+    
+    for (size_t i = 0; i < snapshot->count; i++) {
+        bt_addr_t addr = snapshot->keys[i] >> ADAPTER_BITS;
+        if (merged > 0 && snapshot->keys[merged - 1] == addr) {
+            if (stronger(snapshot->devices[i].rssi, snapshot->devices[merged - 1].rssi)) {
+                snapshot->devices[merged - 1] = snapshot->devices[i];
+            }
+            continue;
+        }
+        
+        snapshot->keys[merged] = addr;
+        snapshot->devices[merged] = snapshot->devices[i];
+        merged++;
+    }
+    snapshot->count = merged;
+}
+
+/* Rebuild and publish the merged snapshot, one shard at a time - runs on
+ * the bus thread */
+static void publish_snapshot(void* data) {
+    DeviceManager* manager = data;
+    
+    atomic_store(&manager->publish_pending, false);
+    uint64_t generation = atomic_load(&manager->generation);
+    if (generation == manager->published_generation) return;
+    
+    DeviceSnapshot* snapshot = snapshot_new(0, generation);
+    size_t capacity = 0;
+    size_t count = adapter_count(manager);
+    if (!snapshot) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        
+        lock_adapter(manager, adapter);
+        if (!snapshot_reserve(snapshot, &capacity, snapshot->count + device_store_count(adapter->devices))) {
+            unlock_adapter(manager, adapter);
+            device_snapshot_unref(snapshot);
+            return;
+        }
+        
+        DeviceSlot cursor = 0;
+        DeviceSlot slot;
+        while ((slot = device_store_next(adapter->devices, &cursor)) != DEVICE_SLOT_NONE) {
+            BluetoothDevice* device = &snapshot->devices[snapshot->count];
+            snapshot->keys[snapshot->count] = sighting_key(device_store_addr(adapter->devices, slot), i);
+            device_store_load(adapter->devices, slot, device);
+            
+            // The store's strings may move once the shard is unlocked
+            const char* name = string_arena_intern(snapshot->strings, device->name);
+            const char* alias = string_arena_intern(snapshot->strings, device->alias);
+            device->name = name ? name : "";
+            device->alias = alias ? alias : "";
+            snapshot->count++;
+        }
+        unlock_adapter(manager, adapter);
     }
+    manager->published_generation = generation;
+    metrics_add(manager->metrics, COUNT_SNAPSHOTS, 1);
     
-    return device;
+    snapshot_sort(snapshot);
+    snapshot_merge(snapshot);
+    
+    pthread_mutex_lock(&manager->snapshot_mutex);
+    DeviceSnapshot* old = manager->snapshot;
+    manager->snapshot = snapshot;
+    pthread_mutex_unlock(&manager->snapshot_mutex);
+    
+    device_snapshot_unref(old);
+}
+
+/* Refresh the lock-free copy of one device (adapter->mutex held) */
+static void publish_record(Adapter* adapter, DeviceSlot slot) {
+    BluetoothDevice device;
+    device_store_load(adapter->devices, slot, &device);
+    device_records_publish(adapter->records, slot, device_store_addr(adapter->devices, slot), &device);
+}
+
+/* Append a device to the on-disk cache if what we keep about it changed,
+ * or its last-seen time is getting stale (adapter->mutex held) */
+static void cache_device(DeviceManager* manager, Adapter* adapter, DeviceSlot slot) {
+    DeviceStore* store = adapter->devices;
+    bt_addr_t addr = device_store_addr(store, slot);
+    const char* alias = device_store_alias(store, slot);
+    uint8_t flags = (device_store_flags(store, slot) & DEVICE_FLAG_USER_ALIAS) ? DEVICE_CACHE_USER_ALIAS : 0;
+    int64_t now = (int64_t)time(NULL);
+    
+    pthread_mutex_lock(&manager->cache_mutex);
+    
+    // Not the adapter: one two adapters see would be rewritten every time
+    const DeviceCacheRecord* cached = device_cache_find(manager->cache, addr);
+    if (cached && cached->type == device_store_type(store, slot) &&
+        cached->class == device_store_class(store, slot) && cached->flags == flags &&
+        strncmp(cached->alias, alias, DEVICE_CACHE_ALIAS_MAX - 1) == 0 &&
+        now - cached->last_seen < CACHE_REFRESH_S) {
+        pthread_mutex_unlock(&manager->cache_mutex);
+        return;
+    }
+    
+    DeviceCacheRecord record = {
+        .addr = addr,
+        .last_seen = now,
+        .class = device_store_class(store, slot),
+        .type = (uint8_t)device_store_type(store, slot),
+        .rssi = device_store_rssi(store, slot),
+        .flags = flags,
+        .adapter = adapter->hci
+    };
+    strncpy(record.alias, alias, DEVICE_CACHE_ALIAS_MAX - 1);
+    device_cache_put(manager->cache, &record);
+    
+    pthread_mutex_unlock(&manager->cache_mutex);
+}
+
+/* Schedule a snapshot rebuild for a change to any shard. Before the
+ * reactor exists, the caller publishes directly. */
+static void mark_devices_changed(DeviceManager* manager) {
+    atomic_fetch_add(&manager->generation, 1);
+    
+    if (manager->reactor && !atomic_exchange(&manager->publish_pending, true)) {
+        int interval = manager->config.snapshot_interval_ms > 0 ?
+                       manager->config.snapshot_interval_ms : DEFAULT_SNAPSHOT_INTERVAL_MS;
+        dbus_reactor_schedule(manager->reactor, &manager->publish_timer, (uint64_t)interval);
+    }
+}
+
+/* Record a change to one device (adapter->mutex held) */
+static void mark_device_changed(DeviceManager* manager, Adapter* adapter, DeviceSlot slot) {
+    publish_record(adapter, slot);
+    if (manager->cache) {
+        cache_device(manager, adapter, slot);
+    }
+    mark_devices_changed(manager);
+}
+
+/* Drop a device from every view of an adapter's shard (adapter->mutex
+ * held). It leaves the cache once no adapter knows it any more; with lost
+ * set, on_lost is then queued. Its strings go with the next compaction. */
+static void forget_device(DeviceManager* manager, Adapter* adapter, DeviceSlot slot, bool lost) {
+    DeviceStore* store = adapter->devices;
+    bt_addr_t addr = device_store_addr(store, slot);
+    BluetoothDevice device;
+    device_store_load(store, slot, &device);
+    
+    device_records_remove(adapter->records, addr);
+    if (manager->cache && !known_elsewhere(manager, adapter, addr)) {
+        pthread_mutex_lock(&manager->cache_mutex);
+        device_cache_remove(manager->cache, addr);
+        pthread_mutex_unlock(&manager->cache_mutex);
+    }
+    device_store_remove(store, slot);
+    mark_devices_changed(manager);
+    
+    if (lost) {
+        metrics_add(manager->metrics, COUNT_DEVICES_LOST, 1);
+        stage_device_event(manager, adapter, DEVICE_EVENT_LOST, &device, addr);
+    }
+}
+
+/* Empty the shard of an adapter that went away (adapter->mutex held). The
+ * cache keeps its devices, they come back with the adapter. */
+static void clear_adapter(DeviceManager* manager, Adapter* adapter) {
+    DeviceStore* store = adapter->devices;
+    DeviceSlot cursor = 0;
+    DeviceSlot slot;
+    
+    while ((slot = device_store_next(store, &cursor)) != DEVICE_SLOT_NONE) {
+        bt_addr_t addr = device_store_addr(store, slot);
+        BluetoothDevice device;
+        device_store_load(store, slot, &device);
+        
+        device_records_remove(adapter->records, addr);
+        device_store_remove(store, slot);
+        
+        metrics_add(manager->metrics, COUNT_DEVICES_LOST, 1);
+        stage_device_event(manager, adapter, DEVICE_EVENT_LOST, &device, addr);
+    }
+    mark_devices_changed(manager);
+}
+
+/* Forget duplicate filter entries whose window has passed (bus thread) */
+static void prune_duplicates(DeviceManager* manager, uint64_t now) {
+    int window = manager->config.duplicate_window_ms > 0 ?
+                 manager->config.duplicate_window_ms : DEFAULT_DUPLICATE_WINDOW_MS;
+    size_t count = device_table_count(manager->duplicates);
+    if (count == 0) return;
+    
+    bt_addr_t* stale = malloc(count * sizeof(bt_addr_t));
+    if (!stale) return;
+    
+    size_t cursor = 0, found = 0;
+    bt_addr_t addr;
+    void* value;
+    while (device_table_next(manager->duplicates, &cursor, &addr, &value)) {
+        const DuplicateEntry* entry = value;
+        if (now - entry->accepted_ms >= (uint64_t)window) {
+            stale[found++] = addr;
+        }
+    }
+    
+    for (size_t i = 0; i < found; i++) {
+        free(device_table_remove(manager->duplicates, stale[i]));
+    }
+    free(stale);
+}
+
+/* Expire unpaired devices not seen within device_ttl_s on each adapter,
+ * then re-arm for the next one due (at most AGING_INTERVAL_MS away).
+ * Runs on the bus thread. */
+static void aging_timer_fired(void* data) {
+    DeviceManager* manager = data;
+    uint64_t now = now_ms();
+    uint64_t ttl_ms = manager->config.device_ttl_s > 0 ? (uint64_t)manager->config.device_ttl_s * 1000 : 0;
+    uint64_t delay = AGING_INTERVAL_MS;
+    size_t count = adapter_count(manager);
+    
+    for (size_t i = 0; ttl_ms > 0 && i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        DeviceStore* store = adapter->devices;
+        DeviceSlot oldest;
+        
+        lock_adapter(manager, adapter);
+        while ((oldest = device_store_oldest(store)) != DEVICE_SLOT_NONE &&
+               device_store_last_seen(store, oldest) + ttl_ms <= now) {
+            forget_device(manager, adapter, oldest, true);
+        }
+        if (oldest != DEVICE_SLOT_NONE) {
+            uint64_t due = device_store_last_seen(store, oldest) + ttl_ms - now;
+            if (due < delay) delay = due;
+        }
+        unlock_adapter(manager, adapter);
+    }
+    dbus_reactor_schedule(manager->reactor, &manager->aging_timer, delay);
+    
+    if (manager->config.filter_duplicates) {
+        prune_duplicates(manager, now);
+    }
 }
 
 /* DBus error handler */
@@ -137,11 +778,228 @@ static void handle_dbus_error(DBusError *error, DeviceManager *manager) {
     dbus_error_free(error);
 }
 
-/* Get default Bluetooth adapter */
-static char* get_default_adapter(DeviceManager* manager) {
+/* Adapters */
+
+/* Slot of an adapter path, present or not, or NULL */
+static Adapter* find_adapter(DeviceManager* manager, const char* path) {
+    size_t count = adapter_count(manager);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(manager->adapters[i].path, path) == 0) {
+            return &manager->adapters[i];
+        }
+    }
+    return NULL;
+}
+
+/* Present adapter owning an object path (/org/bluez/hciN/...), or NULL */
+static Adapter* adapter_for_path(DeviceManager* manager, const char* path) {
+    size_t count = adapter_count(manager);
+    
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        if (strncmp(path, adapter->path, adapter->path_len) == 0 && path[adapter->path_len] == '/' &&
+            atomic_load(&adapter->present)) {
+            return adapter;
+        }
+    }
+    return NULL;
+}
+
+/* Give an adapter path a slot and an empty shard (create, or the bus thread) */
+static Adapter* new_adapter(DeviceManager* manager, const char* path) {
+    size_t index = adapter_count(manager);
+    if (index == MAX_ADAPTERS) {
+        log_warn("Ignoring adapter %s, already tracking %d..", path, MAX_ADAPTERS);
+        return NULL;
+    }
+    
+    Adapter* adapter = &manager->adapters[index];
+    adapter->path = strdup(path);
+    adapter->devices = device_store_create(0);
+    adapter->records = device_records_create();
+    
+    if (!adapter->path || !adapter->devices || !adapter->records ||
+        pthread_mutex_init(&adapter->mutex, NULL) != 0) {
+        free(adapter->path);
+        device_store_destroy(adapter->devices);
+        device_records_destroy(adapter->records);
+        memset(adapter, 0, sizeof(*adapter));
+        return NULL;
+    }
+    adapter->path_len = strlen(path);
+    adapter->index = index;
+    const char* name = strrchr(path, '/');
+    if (name && strncmp(name + 1, "hci", 3) == 0) {
+        adapter->hci = (uint8_t)strtoul(name + 4, NULL, 10);
+    }
+    atomic_init(&adapter->present, false);
+    
+    // Readers only look at slots below adapter_count
+    atomic_store_explicit(&manager->adapter_count, index + 1, memory_order_release);
+    return adapter;
+}
+
+static void destroy_adapters(DeviceManager* manager) {
+    size_t count = adapter_count(manager);
+    
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        device_store_destroy(adapter->devices);
+        device_records_destroy(adapter->records);
+        pthread_mutex_destroy(&adapter->mutex);
+        free(adapter->staged.events);
+        free(adapter->path);
+    }
+}
+
+/* Load the Device1 objects of every known adapter from a GetManagedObjects
+ * reply. Runs before our signal handlers are registered. */
+static void load_known_devices(DeviceManager* manager, DBusMessage* reply) {
+    DBusMessageIter iter, array_iter;
+    size_t loaded = 0;
+    
+    dbus_message_iter_init(reply, &iter);
+    dbus_message_iter_recurse(&iter, &array_iter);
+    
+    while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_DICT_ENTRY) {
+        DBusMessageIter entry_iter, value_iter;
+        char *object_path = NULL;
+        
+        dbus_message_iter_recurse(&array_iter, &entry_iter);
+        dbus_message_iter_get_basic(&entry_iter, &object_path);
+        dbus_message_iter_next(&entry_iter);
+        dbus_message_iter_recurse(&entry_iter, &value_iter);
+        
+        // Only objects below one of our adapters
+        Adapter* adapter = adapter_for_path(manager, object_path);
+        
+        while (adapter && dbus_message_iter_get_arg_type(&value_iter) == DBUS_TYPE_DICT_ENTRY) {
+            DBusMessageIter interface_iter;
+            char *interface_name = NULL;
+            
+            dbus_message_iter_recurse(&value_iter, &interface_iter);
+            dbus_message_iter_get_basic(&interface_iter, &interface_name);
+            
+            if (strcmp(interface_name, DEVICE_INTERFACE) == 0) {
+                dbus_message_iter_next(&interface_iter);
+                
+                BluetoothDevice device = {0};
+                bt_addr_t addr;
+                uint32_t decoded = parse_device_properties(&interface_iter, &device);
+                
+                if (bt_addr_parse(device.address, &addr)) {
+                    lock_adapter(manager, adapter);
+                    
+                    // BlueZ's view beats what the cache remembered
+                    DeviceSlot slot = device_store_find(adapter->devices, addr);
+                    if (slot != DEVICE_SLOT_NONE) {
+                        update_device(adapter, slot, &device, decoded);
+                        device_store_touch(adapter->devices, slot, now_ms());
+                    } else {
+                        slot = store_device(manager, adapter, addr, &device, now_ms());
+                    }
+                    
+                    if (slot != DEVICE_SLOT_NONE) {
+                        publish_record(adapter, slot);
+                        loaded++;
+                    }
+                    
+                    unlock_adapter(manager, adapter);
+                }
+                break;
+            }
+            
+            dbus_message_iter_next(&value_iter);
+        }
+        
+        dbus_message_iter_next(&array_iter);
+    }
+    
+    if (loaded > 0) {
+        atomic_fetch_add(&manager->generation, 1);
+    }
+    log_info("Loaded %zu known devices", loaded);
+}
+
+/* Oldest cache record first */
+static int compare_last_seen(const void* a, const void* b) {
+    int64_t x = (*(const DeviceCacheRecord* const*)a)->last_seen;
+    int64_t y = (*(const DeviceCacheRecord* const*)b)->last_seen;
+    return (x > y) - (x < y);
+}
+
+/* Seed an adapter's shard from the on-disk cache with the devices it saw
+ * last time, before BlueZ is asked about devices. Records are loaded
+ * oldest first with their last-seen time carried over, so aging picks up
+ * where the last run left off; with max_devices set only the most recent
+ * ones are loaded. */
+static void load_cached_devices(DeviceManager* manager, Adapter* adapter) {
+    size_t count = device_cache_count(manager->cache);
+    if (count == 0) return;
+    
+    const DeviceCacheRecord** records = malloc(count * sizeof(*records));
+    if (!records) return;
+    
+    size_t cursor = 0;
+    size_t loaded = 0;
+    const DeviceCacheRecord* record;
+    
+    count = 0;
+    while ((record = device_cache_next(manager->cache, &cursor))) {
+        if (record->adapter == adapter->hci) {
+            records[count++] = record;
+        }
+    }
+    qsort(records, count, sizeof(*records), compare_last_seen);
+    
+    size_t first = 0;
+    if (manager->config.max_devices > 0 && count > (size_t)manager->config.max_devices) {
+        first = count - (size_t)manager->config.max_devices;
+    }
+    
+    // Wall-clock last-seen times become monotonic ones, clamped to our start
+    uint64_t mono = now_ms();
+    int64_t wall = (int64_t)time(NULL);
+    
+    lock_adapter(manager, adapter);
+    
+    for (size_t i = first; i < count; i++) {
+        record = records[i];
+        uint64_t age_ms = record->last_seen < wall ? (uint64_t)(wall - record->last_seen) * 1000 : 0;
+        uint64_t seen_ms = age_ms < mono ? mono - age_ms : 0;
+        
+        BluetoothDevice device = {0};
+        bt_addr_format(record->addr, device.address);
+        device.alias = record->alias[0] ? record->alias : device.address;
+        device.type = (DeviceType)record->type;
+        device.class = record->class;
+        device.rssi = record->rssi;
+        
+        DeviceSlot slot = store_device(manager, adapter, record->addr, &device, seen_ms);
+        if (slot == DEVICE_SLOT_NONE) break;
+        
+        device_store_set_flag(adapter->devices, slot, DEVICE_FLAG_USER_ALIAS,
+                              record->flags & DEVICE_CACHE_USER_ALIAS);
+        publish_record(adapter, slot);
+        loaded++;
+    }
+    
+    unlock_adapter(manager, adapter);
+    free(records);
+    
+    if (loaded > 0) {
+        atomic_fetch_add(&manager->generation, 1);
+    }
+    log_info("Loaded %zu cached devices on %s", loaded, adapter->path);
+}
+
+/* Find every Bluetooth adapter and load the devices BlueZ already knows
+ * from the same GetManagedObjects reply, after seeding each adapter with
+ * the devices the cache last saw on it. Returns the number of adapters. */
+static size_t load_managed_objects(DeviceManager* manager) {
     DBusError error;
     DBusMessage *msg, *reply;
-    char *adapter_path = NULL;
     
     dbus_error_init(&error);
     
@@ -152,272 +1010,424 @@ static char* get_default_adapter(DeviceManager* manager) {
     
     if (!msg) {
         if (manager->config.on_error) {
-            manager->config.on_error(ERR_DBUS, "Failed to create DBus message..", 
+            manager->config.on_error(ERR_DBUS, "Failed to create DBus message..",
                                    manager->config.user_data);
         }
-        return NULL;
+        return 0;
     }
     
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 1000, &error);
+    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, CALL_TIMEOUT_MS, &error);
     dbus_message_unref(msg);
     
     if (!reply) {
         handle_dbus_error(&error, manager);
-        return NULL;
+        return 0;
     }
     
     DBusMessageIter iter, array_iter;
     dbus_message_iter_init(reply, &iter);
     
-    if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_ARRAY) {
-        dbus_message_iter_recurse(&iter, &array_iter);
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) {
+        dbus_message_unref(reply);
+        return 0;
+    }
+    dbus_message_iter_recurse(&iter, &array_iter);
+    
+    // Adapters first, devices may come before their adapter in the reply
+    while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_DICT_ENTRY) {
+        DBusMessageIter entry_iter, value_iter;
+        char *object_path = NULL;
         
-        while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_DICT_ENTRY) {
-            DBusMessageIter entry_iter, value_iter;
-            char *object_path = NULL;
-            
-            dbus_message_iter_recurse(&array_iter, &entry_iter);
-            dbus_message_iter_get_basic(&entry_iter, &object_path);
+        dbus_message_iter_recurse(&array_iter, &entry_iter);
+        dbus_message_iter_get_basic(&entry_iter, &object_path);
+        
+        // Check if this object has the Adapter1 interface
+        dbus_message_iter_next(&entry_iter);
+        dbus_message_iter_recurse(&entry_iter, &value_iter);
+        
+        while (dbus_message_iter_get_arg_type(&value_iter) == DBUS_TYPE_DICT_ENTRY) {
+            DBusMessageIter interface_iter;
+            char *interface_name = NULL;
             
-            // Check if this object has the Adapter1 interface
-            dbus_message_iter_next(&entry_iter);
-            dbus_message_iter_recurse(&entry_iter, &value_iter);
+            dbus_message_iter_recurse(&value_iter, &interface_iter);
+            dbus_message_iter_get_basic(&interface_iter, &interface_name);
             
-            while (dbus_message_iter_get_arg_type(&value_iter) == DBUS_TYPE_DICT_ENTRY) {
-                DBusMessageIter interface_iter;
-                char *interface_name = NULL;
-                
-                dbus_message_iter_recurse(&value_iter, &interface_iter);
-                dbus_message_iter_get_basic(&interface_iter, &interface_name);
-                
-                if (strcmp(interface_name, ADAPTER_INTERFACE) == 0) {
-                    adapter_path = strdup(object_path);
-                    dbus_message_unref(reply);
-                    return adapter_path;
+            if (strcmp(interface_name, ADAPTER_INTERFACE) == 0) {
+                Adapter* adapter = new_adapter(manager, object_path);
+                if (adapter) {
+                    atomic_store(&adapter->present, true);
+                    log_info("Found Bluetooth adapter: %s", object_path);
                 }
-                
-                dbus_message_iter_next(&value_iter);
+                break;
             }
             
-            dbus_message_iter_next(&array_iter);
+            dbus_message_iter_next(&value_iter);
         }
+        
+        dbus_message_iter_next(&array_iter);
+    }
+    
+    size_t count = adapter_count(manager);
+    if (count > 0) {
+        for (size_t i = 0; manager->cache && i < count; i++) {
+            load_cached_devices(manager, &manager->adapters[i]);
+        }
+        load_known_devices(manager, reply);
     }
     
     dbus_message_unref(reply);
-    return NULL;
+    publish_snapshot(manager);
+    return count;
 }
 
-/* Call BlueZ StartDiscovery method */
-static ErrorCode bluez_start_discovery(DeviceManager* manager) {
-    DBusError error;
-    DBusMessage *msg, *reply;
+/* Append a {sv} entry with a basic value to a property dictionary */
+static void append_dict_entry(DBusMessageIter* dict, const char* key, int type, const void* value) {
+    DBusMessageIter entry, variant;
+    char signature[2] = { (char)type, '\0' };
+    
+    dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+    dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, signature, &variant);
+    dbus_message_iter_append_basic(&variant, type, value);
+    dbus_message_iter_close_container(&entry, &variant);
+    dbus_message_iter_close_container(dict, &entry);
+}
+
+/* Build a SetDiscoveryFilter call with the current filter (an empty one
+ * clears it) for one adapter (manager->mutex held) */
+static DBusMessage* new_filter_call(DeviceManager* manager, const char* adapter_path) {
+    static const char* transports[] = { "auto", "le", "bredr" };
+    DBusMessage *msg;
+    DBusMessageIter iter, dict;
     
-    if (!manager->adapter_path) {
-        if (manager->config.on_error) {
-            manager->config.on_error(ERR_BLUEZ, "No Bluetooth adapter found..", 
-                                   manager->config.user_data);
+    msg = dbus_message_new_method_call(BLUEZ_SERVICE,
+                                       adapter_path,
+                                       ADAPTER_INTERFACE,
+                                       "SetDiscoveryFilter");
+    if (!msg) return NULL;
+    
+    dbus_message_iter_init_append(msg, &iter);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sv}", &dict);
+    
+    if (manager->has_filter) {
+        const DiscoveryFilter* filter = &manager->filter;
+        
+        if (filter->uuid_count > 0) {
+            DBusMessageIter entry, variant, array;
+            const char* key = "UUIDs";
+            
+            dbus_message_iter_open_container(&dict, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+            dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+            dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT, "as", &variant);
+            dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY, "s", &array);
+            for (size_t i = 0; i < filter->uuid_count; i++) {
+                dbus_message_iter_append_basic(&array, DBUS_TYPE_STRING, &filter->uuids[i]);
+            }
+            dbus_message_iter_close_container(&variant, &array);
+            dbus_message_iter_close_container(&entry, &variant);
+            dbus_message_iter_close_container(&dict, &entry);
         }
-        return ERR_BLUEZ;
+        if (filter->rssi != 0) {
+            append_dict_entry(&dict, "RSSI", DBUS_TYPE_INT16, &filter->rssi);
+        }
+        if (filter->pathloss != 0) {
+            append_dict_entry(&dict, "Pathloss", DBUS_TYPE_UINT16, &filter->pathloss);
+        }
+        
+        const char* transport = transports[filter->transport];
+        dbus_bool_t duplicate_data = filter->duplicate_data;
+        append_dict_entry(&dict, "Transport", DBUS_TYPE_STRING, &transport);
+        append_dict_entry(&dict, "DuplicateData", DBUS_TYPE_BOOLEAN, &duplicate_data);
     }
     
-    dbus_error_init(&error);
-    
-    msg = dbus_message_new_method_call(BLUEZ_SERVICE,
-                                       manager->adapter_path,
-                                       ADAPTER_INTERFACE,
-                                       "StartDiscovery");
+    dbus_message_iter_close_container(&iter, &dict);
+    return msg;
+}
+
+/* Send a method call without waiting for the reply. Takes msg. NULL if it
+ * could not be sent. */
+static DBusPendingCall* send_call(DeviceManager* manager, DBusMessage* msg) {
+    DBusPendingCall* pending = NULL;
     
     if (!msg) {
         if (manager->config.on_error) {
-            manager->config.on_error(ERR_DBUS, "Failed to create DBus message..", 
+            manager->config.on_error(ERR_DBUS, "Failed to create DBus message..",
                                    manager->config.user_data);
         }
-        return ERR_DBUS;
+        return NULL;
     }
     
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 1000, &error);
+    if (!dbus_connection_send_with_reply(manager->conn, msg, &pending, CALL_TIMEOUT_MS)) {
+        pending = NULL;
+    }
     dbus_message_unref(msg);
+    return pending;
+}
+
+/* Wait for the reply to a send_call(). Errors go to on_error. */
+static bool finish_call(DeviceManager* manager, DBusPendingCall* pending) {
+    if (!pending) return false;
     
-    if (!reply) {
+    dbus_pending_call_block(pending);
+    DBusMessage* reply = dbus_pending_call_steal_reply(pending);
+    dbus_pending_call_unref(pending);
+    if (!reply) return false;
+    
+    DBusError error;
+    dbus_error_init(&error);
+    bool ok = !dbus_set_error_from_message(&error, reply);
+    if (!ok) {
         handle_dbus_error(&error, manager);
-        return ERR_BLUEZ;
     }
     
     dbus_message_unref(reply);
-    return SUCCESS;
+    return ok;
 }
 
-/* Call BlueZ StopDiscovery method */
-static ErrorCode bluez_stop_discovery(DeviceManager* manager) {
-    DBusError error;
-    DBusMessage *msg, *reply;
-    
-    if (!manager->adapter_path) {
-        return ERR_BLUEZ;
+/* Call BlueZ StartDiscovery or StopDiscovery on several adapters at once:
+ * every call is sent before any reply is awaited, so the controllers
+ * switch in parallel. Starting re-sends the filter first so every scan
+ * window runs with the current one. Returns the number of adapters
+ * switched (manager->mutex held). */
+static size_t switch_discovery(DeviceManager* manager, Adapter** targets, size_t count, bool on) {
+    DBusPendingCall* filters[MAX_ADAPTERS] = {0};
+    DBusPendingCall* calls[MAX_ADAPTERS] = {0};
+    bool send_filter = on && manager->has_filter;
+    size_t switched = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        if (send_filter) {
+            filters[i] = send_call(manager, new_filter_call(manager, targets[i]->path));
+            if (!filters[i]) continue;
+        }
+        calls[i] = send_call(manager, dbus_message_new_method_call(BLUEZ_SERVICE,
+                                                                   targets[i]->path,
+                                                                   ADAPTER_INTERFACE,
+                                                                   on ? "StartDiscovery" : "StopDiscovery"));
     }
     
-    dbus_error_init(&error);
-    
-    msg = dbus_message_new_method_call(BLUEZ_SERVICE,
-                                       manager->adapter_path,
-                                       ADAPTER_INTERFACE,
-                                       "StopDiscovery");
+    for (size_t i = 0; i < count; i++) {
+        bool filtered = !send_filter || finish_call(manager, filters[i]);
+        if (finish_call(manager, calls[i]) && filtered) {
+            targets[i]->discovering = on;
+            switched++;
+        }
+    }
+    return switched;
+}
+
+/* Drop the stored filter (manager->mutex held) */
+static void clear_filter(DeviceManager* manager) {
+    for (size_t i = 0; i < manager->filter.uuid_count; i++) {
+        free((char*)manager->filter.uuids[i]);
+    }
+    free(manager->filter.uuids);
+    memset(&manager->filter, 0, sizeof(manager->filter));
+    manager->has_filter = false;
+}
+
+/* Open or close a scan window on every present adapter and report it
+ * (manager->mutex held). Opening succeeds if any adapter started; closing
+ * only once every adapter has stopped. */
+static ErrorCode set_radio(DeviceManager* manager, bool on) {
+    if (manager->radio_on == on) return SUCCESS;
+    
+    Adapter* targets[MAX_ADAPTERS];
+    size_t count = 0;
+    size_t total = adapter_count(manager);
+    
+    for (size_t i = 0; i < total; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        if (atomic_load(&adapter->present) && adapter->discovering != on) {
+            targets[count++] = adapter;
+        }
+    }
     
-    if (!msg) {
+    if (on && count == 0) {
         if (manager->config.on_error) {
-            manager->config.on_error(ERR_DBUS, "Failed to create DBus message..", 
+            manager->config.on_error(ERR_BLUEZ, "No Bluetooth adapter found..",
                                    manager->config.user_data);
         }
-        return ERR_DBUS;
+        return ERR_BLUEZ;
     }
     
-    reply = dbus_connection_send_with_reply_and_block(manager->conn, msg, 1000, &error);
-    dbus_message_unref(msg);
+    size_t switched = switch_discovery(manager, targets, count, on);
+    if (on ? switched == 0 : switched < count) return ERR_BLUEZ;
     
-    if (!reply) {
-        handle_dbus_error(&error, manager);
-        return ERR_BLUEZ;
+    manager->radio_on = on;
+    if (manager->config.on_scan_status) {
+        DeviceEvent event = { .type = DEVICE_EVENT_SCAN_STATUS, .active = on };
+        stage_event(&manager->staged, &event);
     }
-    
-    dbus_message_unref(reply);
     return SUCCESS;
 }
 
-/* Handle PropertiesChanged signal for existing devices */
-static void handle_properties_changed(DeviceManager* manager, DBusMessage* message) {
-    const char* path = dbus_message_get_path(message);
-    if (!path) return;
+/* Arm scan_timer (manager->mutex held) */
+static void schedule_scan_timer(DeviceManager* manager, uint64_t delay_ms) {
+    manager->scan_deadline_ms = now_ms() + delay_ms;
+    dbus_reactor_schedule(manager->reactor, &manager->scan_timer, delay_ms);
+}
+
+/* End of a scan window or of the pause between two - runs on the bus thread */
+static void scan_timer_fired(void* data) {
+    DeviceManager* manager = (DeviceManager*)data;
     
-    // Check if this is a device path
-    if (strncmp(path, "/org/bluez/hci", 14) != 0) return;
-    if (strstr(path, "/dev_") == NULL) return;
+    lock_manager(manager);
     
-    DBusMessageIter iter, dict_iter;
-    char *interface_name = NULL;
+    // Stopped, or re-armed after this expiry was already on its way
+    if (!manager->scanning || now_ms() < manager->scan_deadline_ms) {
+        unlock_manager(manager);
+        return;
+    }
     
-    dbus_message_iter_init(message, &iter);
-    dbus_message_iter_get_basic(&iter, &interface_name);
+    uint64_t window_ms = (uint64_t)manager->config.scan_duration * 1000;
+    uint64_t period_ms = (uint64_t)manager->config.scan_interval * 1000;
     
-    // Only process Device1 interface changes
-    if (strcmp(interface_name, DEVICE_INTERFACE) != 0) return;
+    if (!manager->radio_on) {
+        // Pause over, open the next window
+        if (set_radio(manager, true) == SUCCESS) {
+            schedule_scan_timer(manager, window_ms);
+        } else {
+            schedule_scan_timer(manager, period_ms);
+        }
+    } else if (!manager->session_started) {
+        // Lone burst over
+        set_radio(manager, false);
+        manager->scanning = false;
+    } else if (period_ms > window_ms) {
+        set_radio(manager, false);
+        schedule_scan_timer(manager, period_ms - window_ms);
+    } else if (period_ms > 0) {
+        // No room for a pause - the duty cycle is 100%
+        schedule_scan_timer(manager, window_ms);
+    } else {
+        // Fixed-length scan complete
+        set_radio(manager, false);
+        manager->scanning = false;
+    }
     
-    dbus_message_iter_next(&iter);
+    unlock_manager(manager);
+}
+
+/* An adapter appeared in bluetoothd: give it a shard and, if a scan window
+ * is open, start discovering on it too (bus thread) */
+static void adapter_added(DeviceManager* manager, const char* path) {
+    Adapter* adapter = find_adapter(manager, path);
+    if (adapter && atomic_load(&adapter->present)) return;
+    if (!adapter && !(adapter = new_adapter(manager, path))) return;
+    
+    log_info("Bluetooth adapter added: %s", path);
+    
+    lock_manager(manager);
+    atomic_store(&adapter->present, true);
+    adapter->discovering = false;
+    if (manager->radio_on) {
+        switch_discovery(manager, &adapter, 1, true);
+    }
+    if (manager->config.on_adapter) {
+        DeviceEvent event = { .type = DEVICE_EVENT_ADAPTER, .active = true, .adapter = adapter->path };
+        stage_event(&manager->staged, &event);
+    }
+    unlock_manager(manager);
+}
+
+/* An adapter went away: drop its shard, its devices are lost unless another
+ * adapter sees them (bus thread) */
+static void adapter_removed(DeviceManager* manager, Adapter* adapter) {
+    log_info("Bluetooth adapter removed: %s", adapter->path);
+    
+    lock_manager(manager);
+    atomic_store(&adapter->present, false);
+    adapter->discovering = false;
+    if (manager->config.on_adapter) {
+        DeviceEvent event = { .type = DEVICE_EVENT_ADAPTER, .active = false, .adapter = adapter->path };
+        stage_event(&manager->staged, &event);
+    }
+    unlock_manager(manager);
     
-    // Get the changed properties
-    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) return;
+    lock_adapter(manager, adapter);
+    clear_adapter(manager, adapter);
+    unlock_adapter(manager, adapter);
+}
+
+/* Handle PropertiesChanged signal for devices. Returns false if the
+ * signal is not about a device of one of our adapters and was ignored. */
+static bool handle_properties_changed(DeviceManager* manager, DBusMessage* message) {
+    const char* path = dbus_message_get_path(message);
+    if (!path) return false;
     
-    dbus_message_iter_recurse(&iter, &dict_iter);
+    // Check if this is a device path and pull the address out of it
+    // (e.g., /org/bluez/hci0/dev_XX_XX_XX_XX_XX_XX)
+    Adapter* adapter = adapter_for_path(manager, path);
+    if (!adapter) return false;
     
-    // Extract MAC address from path (e.g., /org/bluez/hci0/dev_XX_XX_XX_XX_XX_XX)
-    const char* dev_prefix = strstr(path, "/dev_");
-    if (!dev_prefix) return;
+    bt_addr_t addr;
+    if (!bt_addr_from_path(path, &addr)) return false;
     
-    char address[18];
-    const char* addr_part = dev_prefix + 5; // Skip "/dev_"
+    DBusMessageIter iter;
+    char *interface_name = NULL;
     
-    // Convert XX_XX_XX_XX_XX_XX to XX:XX:XX:XX:XX:XX
-    int i, j;
-    for (i = 0, j = 0; addr_part[i] && j < 17; i++) {
-        if (addr_part[i] == '_') {
-            address[j++] = ':';
-        } else {
-            address[j++] = addr_part[i];
-        }
-    }
-    address[j] = '\0';
+    if (!dbus_message_iter_init(message, &iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING) return false;
+    dbus_message_iter_get_basic(&iter, &interface_name);
     
-    pthread_mutex_lock(&manager->mutex);
+    // Only process Device1 interface changes
+    if (strcmp(interface_name, DEVICE_INTERFACE) != 0) return false;
     
-    // Check if we already have this device
-    BluetoothDevice* device = g_hash_table_lookup(manager->devices, address);
+    dbus_message_iter_next(&iter);
     
-    if (!device) {
-        // New device discovered via PropertiesChanged
-        // We need to fetch all its properties
-        device = calloc(1, sizeof(BluetoothDevice));
-        if (device) {
-            strncpy(device->address, address, sizeof(device->address) - 1);
-            
-            // Parse the changed properties
-            while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
-                DBusMessageIter entry_iter, variant_iter;
-                char *key = NULL;
-                
-                dbus_message_iter_recurse(&dict_iter, &entry_iter);
-                dbus_message_iter_get_basic(&entry_iter, &key);
-                
-                dbus_message_iter_next(&entry_iter);
-                dbus_message_iter_recurse(&entry_iter, &variant_iter);
-                
-                if (strcmp(key, "Name") == 0) {
-                    char *name;
-                    dbus_message_iter_get_basic(&variant_iter, &name);
-                    strncpy(device->name, name, sizeof(device->name) - 1);
-                } else if (strcmp(key, "Alias") == 0) {
-                    char *alias;
-                    dbus_message_iter_get_basic(&variant_iter, &alias);
-                    strncpy(device->alias, alias, sizeof(device->alias) - 1);
-                } else if (strcmp(key, "RSSI") == 0) {
-                    int16_t rssi;
-                    dbus_message_iter_get_basic(&variant_iter, &rssi);
-                    device->rssi = (int8_t)rssi;
-                } else if (strcmp(key, "Class") == 0) {
-                    uint32_t class;
-                    dbus_message_iter_get_basic(&variant_iter, &class);
-                    device->class = class;
-                    device->type = get_device_type_from_class(class);
-                }
-                
-                dbus_message_iter_next(&dict_iter);
-            }
-            
-            // Set alias if empty
-            if (strlen(device->alias) == 0 && strlen(device->name) > 0) {
-                strncpy(device->alias, device->name, sizeof(device->alias) - 1);
-            }
-            if (strlen(device->alias) == 0) {
-                strncpy(device->alias, device->address, sizeof(device->alias) - 1);
-            }
-            
-            g_hash_table_insert(manager->devices, strdup(address), device);
-            
-            printf("Debug: New device found via PropertiesChanged: %s (%s)\n ..", 
-                   device->alias, device->address);
-            
-            if (manager->config.on_discovered) {
-                manager->config.on_discovered(device, manager->config.user_data);
-            }
+    // Decode the changed properties before taking the lock
+    BluetoothDevice parsed = {0};
+    BluetoothDevice* device = &parsed;
+    bt_addr_format(addr, device->address);
+    uint64_t parse_start = metrics_now_ns();
+    uint32_t changed = parse_device_properties(&iter, device);
+    metrics_record(manager->metrics, LATENCY_PARSE, metrics_now_ns() - parse_start);
+    if (!changed || is_duplicate(manager, adapter, addr, device, changed)) return true;
+    
+    lock_adapter(manager, adapter);
+    
+    // Check if we already have this device
+    DeviceSlot slot = device_store_find(adapter->devices, addr);
+    
+    if (slot == DEVICE_SLOT_NONE) {
+        // New device discovered via PropertiesChanged
+        slot = store_device(manager, adapter, addr, device, now_ms());
+        if (slot == DEVICE_SLOT_NONE) {
+            unlock_adapter(manager, adapter);
+            return true;
         }
+        
+        // Events copy the stored strings, not the message's
+        device_store_load(adapter->devices, slot, device);
+        mark_device_changed(manager, adapter, slot);
+        
+        log_debug("New device found via PropertiesChanged: %s (%s)",
+                  device->alias, device->address);
+        
+        stage_device_event(manager, adapter, DEVICE_EVENT_DISCOVERED, device, addr);
     } else {
         // Update existing device properties
-        while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
-            DBusMessageIter entry_iter, variant_iter;
-            char *key = NULL;
-            
-            dbus_message_iter_recurse(&dict_iter, &entry_iter);
-            dbus_message_iter_get_basic(&entry_iter, &key);
-            
-            dbus_message_iter_next(&entry_iter);
-            dbus_message_iter_recurse(&entry_iter, &variant_iter);
-            
-            if (strcmp(key, "RSSI") == 0) {
-                int16_t rssi;
-                dbus_message_iter_get_basic(&variant_iter, &rssi);
-                device->rssi = (int8_t)rssi;
-            }
-            
-            dbus_message_iter_next(&dict_iter);
+        device_store_touch(adapter->devices, slot, now_ms());
+        if (update_device(adapter, slot, device, changed)) {
+            mark_device_changed(manager, adapter, slot);
         }
     }
     
-    pthread_mutex_unlock(&manager->mutex);
+    unlock_adapter(manager, adapter);
+    return true;
 }
-static void handle_interfaces_added(DeviceManager* manager, DBusMessage* message) {
+
+/* Handle InterfacesAdded for adapters and devices. Returns false if neither
+ * an Adapter1 nor a Device1 of one of our adapters was added. */
+static bool handle_interfaces_added(DeviceManager* manager, DBusMessage* message) {
     DBusMessageIter iter, dict_iter;
     char *object_path;
     
-    dbus_message_iter_init(message, &iter);
+    if (!dbus_message_iter_init(message, &iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_OBJECT_PATH) return false;
     dbus_message_iter_get_basic(&iter, &object_path);
+    if (strncmp(object_path, BLUEZ_ROOT "/", strlen(BLUEZ_ROOT) + 1) != 0) return false;
     
     dbus_message_iter_next(&iter);
     
@@ -431,93 +1441,247 @@ static void handle_interfaces_added(DeviceManager* manager, DBusMessage* message
             dbus_message_iter_recurse(&dict_iter, &entry_iter);
             dbus_message_iter_get_basic(&entry_iter, &interface);
             
+            if (strcmp(interface, ADAPTER_INTERFACE) == 0) {
+                adapter_added(manager, object_path);
+                return true;
+            }
+            
             if (strcmp(interface, DEVICE_INTERFACE) == 0) {
+                Adapter* adapter = adapter_for_path(manager, object_path);
+                if (!adapter) return false;
+                
                 dbus_message_iter_next(&entry_iter);
                 
-                DBusMessageIter properties_iter;
-                dbus_message_iter_recurse(&entry_iter, &properties_iter);
+                BluetoothDevice parsed = {0};
+                BluetoothDevice* device = &parsed;
+                uint64_t parse_start = metrics_now_ns();
+                parse_device_properties(&entry_iter, device);
+                metrics_record(manager->metrics, LATENCY_PARSE, metrics_now_ns() - parse_start);
                 
-                BluetoothDevice* device = parse_device_properties(&properties_iter);
-                if (device) {
-                    // Validate device has at least an address
-                    if (strlen(device->address) == 0) {
-                        fprintf(stderr, "Debug: Skipping device with no address..\n");
-                        free(device);
-                        break;
-                    }
-                    
-                    pthread_mutex_lock(&manager->mutex);
-                    
-                    // Check if device already exists
-                    BluetoothDevice* existing = g_hash_table_lookup(manager->devices, device->address);
-                    if (existing) {
-                        // Device already exists, just free the new one
-                        free(device);
-                    } else {
-                        // Add new device
-                        g_hash_table_insert(manager->devices, strdup(device->address), device);
-                        
-                        // Notify callback
-                        if (manager->config.on_discovered) {
-                            manager->config.on_discovered(device, manager->config.user_data);
-                        }
-                    }
+                // Validate device has a usable address
+                bt_addr_t addr;
+                if (!bt_addr_parse(device->address, &addr)) {
+                    log_debug("Skipping device with no address..");
+                    return false;
+                }
+                
+                lock_adapter(manager, adapter);
+                
+                // Check if device already exists
+                DeviceSlot slot = DEVICE_SLOT_NONE;
+                if (device_store_find(adapter->devices, addr) == DEVICE_SLOT_NONE) {
+                    slot = store_device(manager, adapter, addr, device, now_ms());
+                }
+                
+                if (slot != DEVICE_SLOT_NONE) {
+                    // Added new device
+                    device_store_load(adapter->devices, slot, device);
+                    mark_device_changed(manager, adapter, slot);
                     
-                    pthread_mutex_unlock(&manager->mutex);
+                    // Notify callback
+                    stage_device_event(manager, adapter, DEVICE_EVENT_DISCOVERED, device, addr);
                 }
-                break;
+                
+                unlock_adapter(manager, adapter);
+                return true;
             }
             
             dbus_message_iter_next(&dict_iter);
         }
     }
+    
+    return false;
 }
 
-/* Main DBus monitoring thread */
-static void* dbus_monitor_thread(void* arg) {
-    DeviceManager* manager = (DeviceManager*)arg;
+/* Handle InterfacesRemoved. Only an adapter going away matters; devices
+ * bluetoothd drops are left to our own aging. Returns false if the object
+ * is not ours. */
+static bool handle_interfaces_removed(DeviceManager* manager, DBusMessage* message) {
+    DBusMessageIter iter, array_iter;
+    char *object_path;
+    
+    if (!dbus_message_iter_init(message, &iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_OBJECT_PATH) return false;
+    dbus_message_iter_get_basic(&iter, &object_path);
     
-    printf("Debug: DBus monitoring thread started..\n");
+    Adapter* adapter = find_adapter(manager, object_path);
+    if (!adapter) return adapter_for_path(manager, object_path) != NULL;
     
-    while (manager->running) {
-        // Process DBus events with short timeout
-        dbus_connection_read_write(manager->conn, 100);
+    dbus_message_iter_next(&iter);
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) return false;
+    dbus_message_iter_recurse(&iter, &array_iter);
+    
+    while (dbus_message_iter_get_arg_type(&array_iter) == DBUS_TYPE_STRING) {
+        char *interface = NULL;
+        dbus_message_iter_get_basic(&array_iter, &interface);
         
-        DBusMessage* msg;
-        while ((msg = dbus_connection_pop_message(manager->conn)) != NULL) {
-            const char* interface = dbus_message_get_interface(msg);
-            const char* member = dbus_message_get_member(msg);
-            
-            if (interface && member) {
-                printf("Debug: Received signal - Interface: %s, Member: %s ..\n", interface, member);
-            }
-            
-            // Check for InterfacesAdded signal
-            if (dbus_message_is_signal(msg, "org.freedesktop.DBus.ObjectManager", 
-                                      "InterfacesAdded")) {
-                printf("Debug: Processing InterfacesAdded signal..\n");
-                handle_interfaces_added(manager, msg);
-            }
-            
-            // Check for PropertiesChanged signal on devices
-            else if (dbus_message_is_signal(msg, "org.freedesktop.DBus.Properties", 
-                                          "PropertiesChanged")) {
-                printf("Debug: Processing PropertiesChanged signal..\n");
-                handle_properties_changed(manager, msg);
+        if (strcmp(interface, ADAPTER_INTERFACE) == 0) {
+            if (atomic_load(&adapter->present)) {
+                adapter_removed(manager, adapter);
             }
-            
-            dbus_message_unref(msg);
+            return true;
         }
         
-        // Small sleep to prevent busy waiting
-        struct timespec ts;
-        ts.tv_sec = 0;
-        ts.tv_nsec = 10000000L;  // 10ms in nanoseconds
-        nanosleep(&ts, NULL);
+        dbus_message_iter_next(&array_iter);
     }
     
-    printf("Debug: DBus monitoring thread exiting..\n");
-    return NULL;
+    return true;
+}
+
+/* Add match rules scoped to bluetoothd's object tree, which covers every
+ * adapter including ones plugged in later */
+static void add_match_rules(DeviceManager* manager) {
+    char rules[MATCH_RULE_COUNT][MATCH_RULE_MAX];
+    DBusError error;
+    
+    // InterfacesAdded/Removed come from the object manager at '/', so scope
+    // them by the object's path instead
+    snprintf(rules[0], MATCH_RULE_MAX,
+             "type='signal',sender='" BLUEZ_SERVICE "',path='/',"
+             "interface='" OBJECT_MANAGER_INTERFACE "',member='InterfacesAdded',"
+             "arg0path='" BLUEZ_ROOT "/'");
+    snprintf(rules[1], MATCH_RULE_MAX,
+             "type='signal',sender='" BLUEZ_SERVICE "',path='/',"
+             "interface='" OBJECT_MANAGER_INTERFACE "',member='InterfacesRemoved',"
+             "arg0path='" BLUEZ_ROOT "/'");
+    snprintf(rules[2], MATCH_RULE_MAX,
+             "type='signal',sender='" BLUEZ_SERVICE "',path_namespace='" BLUEZ_ROOT "',"
+             "interface='org.freedesktop.DBus.Properties',member='PropertiesChanged',"
+             "arg0='" DEVICE_INTERFACE "'");
+    
+    for (size_t i = 0; i < MATCH_RULE_COUNT; i++) {
+        dbus_error_init(&error);
+        dbus_bus_add_match(manager->conn, rules[i], &error);
+        if (dbus_error_is_set(&error)) {
+            handle_dbus_error(&error, manager);
+        } else {
+            manager->match_rules[i] = strdup(rules[i]);
+        }
+    }
+}
+
+/* Remove the rules added by add_match_rules() */
+static void remove_match_rules(DeviceManager* manager) {
+    for (size_t i = 0; i < MATCH_RULE_COUNT; i++) {
+        if (manager->match_rules[i]) {
+            dbus_bus_remove_match(manager->conn, manager->match_rules[i], NULL);
+            free(manager->match_rules[i]);
+            manager->match_rules[i] = NULL;
+        }
+    }
+}
+
+/* Count a routed signal; woken up for nothing should be rare with our match rules */
+static void count_signal(DeviceManager* manager, bool accepted) {
+    metrics_add(manager->metrics, COUNT_SIGNALS_RECEIVED, 1);
+    if (!accepted) {
+        metrics_add(manager->metrics, COUNT_SIGNALS_REJECTED, 1);
+    }
+}
+
+/* Signal handlers, routed by the bus core - run on the bus thread */
+
+static void on_interfaces_added(DBusMessage* msg, void* data) {
+    DeviceManager* manager = data;
+    
+    log_debug("Processing InterfacesAdded signal..");
+    metrics_add(manager->metrics, COUNT_INTERFACES_ADDED, 1);
+    count_signal(manager, handle_interfaces_added(manager, msg));
+}
+
+static void on_interfaces_removed(DBusMessage* msg, void* data) {
+    DeviceManager* manager = data;
+    
+    log_debug("Processing InterfacesRemoved signal..");
+    count_signal(manager, handle_interfaces_removed(manager, msg));
+}
+
+static void on_properties_changed(DBusMessage* msg, void* data) {
+    DeviceManager* manager = data;
+    
+    log_debug("Processing PropertiesChanged signal..");
+    metrics_add(manager->metrics, COUNT_PROPERTIES_CHANGED, 1);
+    count_signal(manager, handle_properties_changed(manager, msg));
+}
+
+/* Register our signal handlers with the bus core */
+static bool add_signal_handlers(DeviceManager* manager) {
+    return bus_core_add_handler(manager->bus, OBJECT_MANAGER_INTERFACE, "InterfacesAdded",
+                                on_interfaces_added, manager) &&
+           bus_core_add_handler(manager->bus, OBJECT_MANAGER_INTERFACE, "InterfacesRemoved",
+                                on_interfaces_removed, manager) &&
+           bus_core_add_handler(manager->bus, "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                                on_properties_changed, manager);
+}
+
+/* Stop every handler and timer of ours for good - runs on the bus thread
+ * through bus_core_run(), so none of them is running meanwhile */
+static void detach_from_bus(void* data) {
+    DeviceManager* manager = data;
+    
+    bus_core_remove_handlers(manager->bus, manager);
+    
+    lock_manager(manager);
+    manager->scanning = false;
+    dbus_reactor_cancel(manager->reactor, &manager->scan_timer);
+    dbus_reactor_cancel(manager->reactor, &manager->aging_timer);
+    dbus_reactor_cancel(manager->reactor, &manager->metrics_timer);
+    dbus_reactor_cancel(manager->reactor, &manager->publish_timer);
+    unlock_manager(manager);
+}
+
+/* Render every metric in Prometheus text format into a malloc'd buffer */
+static bool format_metrics(DeviceManager* manager, char** text, size_t* length) {
+    DeviceManagerStats stats;
+    device_manager_get_stats(manager, &stats);
+    
+    FILE* out = open_memstream(text, length);
+    if (!out) return false;
+    
+    metrics_print_counter(out, "blueteeth_dm_signals_total", "Signals delivered to the device manager",
+                          stats.signals_received);
+    metrics_print_counter(out, "blueteeth_dm_interfaces_added_total", "InterfacesAdded signals",
+                          stats.signals_interfaces_added);
+    metrics_print_counter(out, "blueteeth_dm_properties_changed_total", "PropertiesChanged signals",
+                          stats.signals_properties_changed);
+    metrics_print_counter(out, "blueteeth_dm_signals_rejected_total", "Signals not about our devices",
+                          stats.signals_rejected);
+    metrics_print_counter(out, "blueteeth_dm_updates_suppressed_total", "Updates dropped as duplicates",
+                          stats.updates_suppressed);
+    metrics_print_gauge(out, "blueteeth_dm_adapters", "Adapters present", stats.adapters);
+    metrics_print_gauge(out, "blueteeth_dm_devices", "Devices in the table", stats.devices);
+    metrics_print_counter(out, "blueteeth_dm_devices_lost_total", "Devices evicted or expired",
+                          stats.devices_lost);
+    metrics_print_counter(out, "blueteeth_dm_snapshots_total", "Snapshots published",
+                          stats.snapshots_published);
+    metrics_print_latency(out, "blueteeth_dm_parse_seconds", "Time to decode one signal", &stats.parse);
+    metrics_print_latency(out, "blueteeth_dm_lock_wait_seconds", "Time waiting for the manager lock",
+                          &stats.lock_wait);
+    metrics_print_latency(out, "blueteeth_dm_lock_hold_seconds", "Time holding the manager lock",
+                          &stats.lock_hold);
+    metrics_print_counter(out, "blueteeth_dm_callbacks_dropped_total", "Callback events dropped by a full queue",
+                          stats.callbacks_dropped);
+    metrics_print_latency(out, "blueteeth_dm_callback_delay_seconds", "Time from event to callback",
+                          &stats.callback_delay);
+    
+    return fclose(out) == 0;
+}
+
+/* Rewrite config.metrics_path and re-arm - runs on the bus thread */
+static void metrics_timer_fired(void* data) {
+    DeviceManager* manager = data;
+    char* text = NULL;
+    size_t length = 0;
+    
+    if (format_metrics(manager, &text, &length) &&
+        !metrics_write_file(manager->config.metrics_path, text, length)) {
+        log_warn("Could not write metrics to %s", manager->config.metrics_path);
+    }
+    free(text);
+    
+    int interval = manager->config.metrics_interval_ms > 0 ?
+                   manager->config.metrics_interval_ms : DEFAULT_METRICS_INTERVAL_MS;
+    dbus_reactor_schedule(manager->reactor, &manager->metrics_timer, (uint64_t)interval);
 }
 
 /* Public API Implementation */
@@ -528,190 +1692,614 @@ DeviceManager* device_manager_create(const DeviceManagerConfig* config) {
     
     // Copy config
     manager->config = *config;
+    manager->metrics = metrics_create(COUNTER_COUNT, LATENCY_COUNT);
+    if (!manager->metrics) {
+        free(manager);
+        return NULL;
+    }
+    
+    // Callbacks get their own executor so they never run under a lock
+    if (config->on_discovered || config->on_lost || config->on_scan_status || config->on_adapter) {
+        EventQueueConfig queue_config = {
+            .executor = config->callback_executor,
+            .context = config->callback_context,
+            .threads = config->callback_threads,
+            .capacity = config->callback_queue_size,
+            .overflow = config->callback_overflow
+        };
+        manager->callbacks = event_queue_create(&queue_config, deliver_events, manager);
+        if (!manager->callbacks) {
+            metrics_destroy(manager->metrics);
+            free(manager);
+            return NULL;
+        }
+    }
     
-    // Initialize mutex
+    // Initialize mutexes
     if (pthread_mutex_init(&manager->mutex, NULL) != 0) {
+        event_queue_destroy(manager->callbacks);
+        metrics_destroy(manager->metrics);
+        free(manager);
+        return NULL;
+    }
+    if (pthread_mutex_init(&manager->cache_mutex, NULL) != 0) {
+        pthread_mutex_destroy(&manager->mutex);
+        event_queue_destroy(manager->callbacks);
+        metrics_destroy(manager->metrics);
         free(manager);
         return NULL;
     }
     
-    // Initialize DBus connection
-    DBusError error;
-    dbus_error_init(&error);
-    
-    manager->conn = dbus_bus_get(DBUS_BUS_SYSTEM, &error);
-    if (!manager->conn) {
-        handle_dbus_error(&error, manager);
+    // Shared with every other manager in the process
+    manager->bus = bus_core_get();
+    if (!manager->bus) {
+        if (manager->config.on_error) {
+            manager->config.on_error(ERR_DBUS, "Could not connect to the system bus", manager->config.user_data);
+        }
+        pthread_mutex_destroy(&manager->cache_mutex);
         pthread_mutex_destroy(&manager->mutex);
+        event_queue_destroy(manager->callbacks);
+        metrics_destroy(manager->metrics);
         free(manager);
         return NULL;
     }
+    manager->conn = bus_core_connection(manager->bus);
     
     // Request name on DBus (optional - not critical for scanning)
+    DBusError error;
     dbus_error_init(&error);
-    int ret = dbus_bus_request_name(manager->conn, "com.blueteeth.btmanager", 
+    int ret = dbus_bus_request_name(manager->conn, "com.blueteeth.btmanager",
                                    DBUS_NAME_FLAG_REPLACE_EXISTING, &error);
     if (ret != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER) {
         // Not critical - just log a warning and continue
-        fprintf(stderr, "Warning: Could not request D-Bus name: %s\n", error.message);
-        fprintf(stderr, "Continuing without exclusive service name...\n");
+        log_warn("Could not request D-Bus name: %s", error.message);
+        log_warn("Continuing without exclusive service name...");
         dbus_error_free(&error);
     }
     
-    // Add match for signals
-    dbus_bus_add_match(manager->conn,
-                      "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
-                      "member='InterfacesAdded'",
-                      &error);
-    
-    dbus_bus_add_match(manager->conn,
-                      "type='signal',interface='org.freedesktop.DBus.Properties',"
-                      "member='PropertiesChanged',arg0='org.bluez.Device1'",
-                      &error);
+    // Start from an empty snapshot; each adapter gets its own shard as it is found
+    atomic_init(&manager->adapter_count, 0);
+    atomic_init(&manager->generation, 0);
+    atomic_init(&manager->publish_pending, false);
+    manager->duplicates = device_table_create(0);
+    manager->snapshot = snapshot_new(0, 0);
+    wheel_timer_init(&manager->publish_timer, publish_snapshot, manager);
+    wheel_timer_init(&manager->scan_timer, scan_timer_fired, manager);
+    wheel_timer_init(&manager->aging_timer, aging_timer_fired, manager);
+    wheel_timer_init(&manager->metrics_timer, metrics_timer_fired, manager);
+    if (!manager->duplicates || !manager->snapshot ||
+        pthread_mutex_init(&manager->snapshot_mutex, NULL) != 0) {
+        device_table_destroy(manager->duplicates, free);
+        device_snapshot_unref(manager->snapshot);
+        bus_core_unref(manager->bus);
+        pthread_mutex_destroy(&manager->cache_mutex);
+        pthread_mutex_destroy(&manager->mutex);
+        event_queue_destroy(manager->callbacks);
+        metrics_destroy(manager->metrics);
+        free(manager);
+        return NULL;
+    }
     
-    // Create hash table for devices
-    manager->devices = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+    // Known devices from the last run first - no round trip needed
+    if (manager->config.cache_path) {
+        manager->cache = device_cache_open(manager->config.cache_path);
+        if (!manager->cache && manager->config.on_error) {
+            manager->config.on_error(ERR_IPC, "Could not open device cache..", manager->config.user_data);
+        }
+    }
     
-    // Get default adapter
-    manager->adapter_path = get_default_adapter(manager);
-    if (!manager->adapter_path) {
-        fprintf(stderr, "Error: No Bluetooth adapter found!!..\n");
-        fprintf(stderr, "Make sure Bluetooth is enabled and bluetoothd is running..\n");
-    } else {
-        printf("Found Bluetooth adapter: %s\n", manager->adapter_path);
+    // Every adapter, with the devices bluetoothd knows on each
+    if (load_managed_objects(manager) == 0) {
+        log_error("No Bluetooth adapter found!!..");
+        log_error("Make sure Bluetooth is enabled and bluetoothd is running..");
     }
     
-    // Start monitoring thread
-    manager->running = true;
-    if (pthread_create(&manager->thread, NULL, dbus_monitor_thread, manager) != 0) {
-        g_hash_table_destroy(manager->devices);
-        dbus_connection_unref(manager->conn);
+    // From here on changes are handled on the bus thread
+    manager->reactor = bus_core_reactor(manager->bus);
+    if (!add_signal_handlers(manager)) {
+        bus_core_run(manager->bus, detach_from_bus, manager);
+        destroy_adapters(manager);
+        device_table_destroy(manager->duplicates, free);
+        device_snapshot_unref(manager->snapshot);
+        pthread_mutex_destroy(&manager->snapshot_mutex);
+        device_cache_close(manager->cache);
+        bus_core_unref(manager->bus);
+        pthread_mutex_destroy(&manager->cache_mutex);
         pthread_mutex_destroy(&manager->mutex);
+        event_queue_destroy(manager->callbacks);
+        metrics_destroy(manager->metrics);
         free(manager);
         return NULL;
     }
     
+    // Only BlueZ signals about its adapters and their objects reach us
+    add_match_rules(manager);
+    
+    // Aging only has work with a TTL or the duplicate filter's entries to prune
+    if (manager->config.device_ttl_s > 0 || manager->config.filter_duplicates) {
+        dbus_reactor_schedule(manager->reactor, &manager->aging_timer, 0);
+    }
+    if (manager->config.metrics_path) {
+        dbus_reactor_schedule(manager->reactor, &manager->metrics_timer, 0);
+    }
+    
     return manager;
 }
 
 ErrorCode device_manager_start_discovery(DeviceManager* manager) {
     if (!manager) return ERR_INVALID_ARG;
     
-    pthread_mutex_lock(&manager->mutex);
+    lock_manager(manager);
     
-    if (manager->scanning) {
-        pthread_mutex_unlock(&manager->mutex);
+    if (manager->scanning && manager->session_started) {
+        unlock_manager(manager);
         return SUCCESS;
     }
     
-    ErrorCode err = bluez_start_discovery(manager);
+    // Takes over a running burst, whose timer then follows this schedule
+    ErrorCode err = set_radio(manager, true);
     if (err == SUCCESS) {
         manager->scanning = true;
+        manager->session_started = true;
         
-        if (manager->config.on_scan_status) {
-            manager->config.on_scan_status(true, manager->config.user_data);
+        if (manager->config.scan_duration > 0) {
+            schedule_scan_timer(manager, (uint64_t)manager->config.scan_duration * 1000);
+        } else {
+            dbus_reactor_cancel(manager->reactor, &manager->scan_timer);
         }
     }
     
-    pthread_mutex_unlock(&manager->mutex);
+    unlock_manager(manager);
+    return err;
+}
+
+ErrorCode device_manager_set_discovery_filter(DeviceManager* manager, const DiscoveryFilter* filter) {
+    if (!manager) return ERR_INVALID_ARG;
+    if (filter && ((filter->rssi != 0 && filter->pathloss != 0) ||
+                   (unsigned)filter->transport > DISCOVERY_TRANSPORT_BREDR ||
+                   (filter->uuid_count > 0 && !filter->uuids))) {
+        return ERR_INVALID_ARG;
+    }
+    
+    // Copy the UUIDs before touching the current filter
+    const char** uuids = NULL;
+    size_t uuid_count = filter ? filter->uuid_count : 0;
+    if (uuid_count > 0) {
+        uuids = calloc(uuid_count, sizeof(char*));
+        if (!uuids) return ERR_MEMORY;
+        
+        for (size_t i = 0; i < uuid_count; i++) {
+            uuids[i] = filter->uuids[i] ? strdup(filter->uuids[i]) : NULL;
+            if (!uuids[i]) {
+                for (size_t j = 0; j < i; j++) free((char*)uuids[j]);
+                free(uuids);
+                return filter->uuids[i] ? ERR_MEMORY : ERR_INVALID_ARG;
+            }
+        }
+    }
+    
+    lock_manager(manager);
+    
+    clear_filter(manager);
+    if (filter) {
+        manager->filter = *filter;
+        manager->filter.uuids = uuids;
+        manager->has_filter = true;
+    }
+    
+    // bluetoothd keeps it for our next scan and applies it to a running one;
+    // every adapter gets it at once
+    DBusPendingCall* calls[MAX_ADAPTERS] = {0};
+    size_t count = adapter_count(manager);
+    ErrorCode err = SUCCESS;
+    
+    for (size_t i = 0; i < count; i++) {
+        if (atomic_load(&manager->adapters[i].present)) {
+            calls[i] = send_call(manager, new_filter_call(manager, manager->adapters[i].path));
+            if (!calls[i]) err = ERR_BLUEZ;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (calls[i] && !finish_call(manager, calls[i])) err = ERR_BLUEZ;
+    }
+    
+    unlock_manager(manager);
+    return err;
+}
+
+ErrorCode device_manager_scan_burst(DeviceManager* manager, int duration_ms) {
+    if (!manager || duration_ms <= 0) return ERR_INVALID_ARG;
+    
+    lock_manager(manager);
+    
+    // A continuous scan already has the radio on
+    if (manager->scanning && manager->session_started && manager->config.scan_duration <= 0) {
+        unlock_manager(manager);
+        return SUCCESS;
+    }
+    
+    ErrorCode err = set_radio(manager, true);
+    if (err == SUCCESS) {
+        if (!manager->scanning) {
+            manager->scanning = true;
+            manager->session_started = false;
+        }
+        schedule_scan_timer(manager, (uint64_t)duration_ms);
+    }
+    
+    unlock_manager(manager);
     return err;
 }
 
 ErrorCode device_manager_stop_discovery(DeviceManager* manager) {
     if (!manager) return ERR_INVALID_ARG;
     
-    pthread_mutex_lock(&manager->mutex);
+    lock_manager(manager);
     
     if (!manager->scanning) {
-        pthread_mutex_unlock(&manager->mutex);
+        unlock_manager(manager);
         return SUCCESS;
     }
     
-    ErrorCode err = bluez_stop_discovery(manager);
+    ErrorCode err = set_radio(manager, false);
     if (err == SUCCESS) {
         manager->scanning = false;
-        
-        if (manager->config.on_scan_status) {
-            manager->config.on_scan_status(false, manager->config.user_data);
-        }
+        dbus_reactor_cancel(manager->reactor, &manager->scan_timer);
     }
     
-    pthread_mutex_unlock(&manager->mutex);
+    unlock_manager(manager);
     return err;
 }
 
+size_t device_manager_get_adapters(DeviceManager* manager, AdapterInfo* adapters, size_t max) {
+    if (!manager) return 0;
+    
+    size_t count = adapter_count(manager);
+    
+    for (size_t i = 0; i < count && i < max; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        AdapterInfo* info = &adapters[i];
+        
+        info->path = adapter->path;
+        info->present = atomic_load(&adapter->present);
+        
+        pthread_mutex_lock(&manager->mutex);
+        info->discovering = adapter->discovering;
+        pthread_mutex_unlock(&manager->mutex);
+        
+        pthread_mutex_lock(&adapter->mutex);
+        info->devices = device_store_count(adapter->devices);
+        pthread_mutex_unlock(&adapter->mutex);
+    }
+    
+    return count;
+}
+
 GList* device_manager_get_devices(DeviceManager* manager) {
     if (!manager) return NULL;
     
-    pthread_mutex_lock(&manager->mutex);
-    GHashTableIter iter;
-    gpointer key, value;
+    // Address -> list node of the strongest sighting so far
+    DeviceTable* listed = device_table_create(0);
+    if (!listed) return NULL;
+    
+    size_t count = adapter_count(manager);
     GList* list = NULL;
     
-    g_hash_table_iter_init(&iter, manager->devices);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        list = g_list_append(list, value);
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        DeviceSlot cursor = 0;
+        DeviceSlot slot;
+        
+        lock_adapter(manager, adapter);
+        while ((slot = device_store_next(adapter->devices, &cursor)) != DEVICE_SLOT_NONE) {
+            bt_addr_t addr = device_store_addr(adapter->devices, slot);
+            GList* node = device_table_lookup(listed, addr);
+            if (node && !stronger(device_store_rssi(adapter->devices, slot), ((BluetoothDevice*)node->data)->rssi)) {
+                continue;
+            }
+            
+            BluetoothDevice device;
+            device_store_load(adapter->devices, slot, &device);
+            BluetoothDevice* copy = copy_device(&device);
+            if (!copy) continue;
+            if (node) {
+                free(node->data);
+                node->data = copy;
+            } else {
+                list = g_list_prepend(list, copy);
+                if (!device_table_insert(listed, addr, list, NULL)) {
+                    list = g_list_delete_link(list, list);
+                    free(copy);
+                }
+            }
+        }
+        unlock_adapter(manager, adapter);
     }
     
-    pthread_mutex_unlock(&manager->mutex);
+    device_table_destroy(listed, NULL);
     return list;
 }
 
 BluetoothDevice* device_manager_get_device(DeviceManager* manager, const char* address) {
-    if (!manager || !address) return NULL;
+    BluetoothDevice device;
+    if (!device_manager_read_device(manager, address, &device)) return NULL;
     
-    pthread_mutex_lock(&manager->mutex);
-    BluetoothDevice* device = g_hash_table_lookup(manager->devices, address);
-    pthread_mutex_unlock(&manager->mutex);
+    return copy_device(&device);
+}
+
+bool device_manager_read_device(DeviceManager* manager, const char* address, BluetoothDevice* out) {
+    // out's strings live here until this thread reads again
+    static _Thread_local DeviceStrings strings[2];
+    static _Thread_local int current;
+    
+    bt_addr_t key;
+    if (!manager || !address || !out || !bt_addr_parse(address, &key)) return false;
+    
+    size_t count = adapter_count(manager);
+    bool found = false;
+    int spare = current ^ 1;
+    
+    for (size_t i = 0; i < count; i++) {
+        BluetoothDevice device;
+        if (!device_records_read(manager->adapters[i].records, key, &device, &strings[spare])) continue;
+        
+        if (!found || stronger(device.rssi, out->rssi)) {
+            *out = device;
+            found = true;
+            current = spare;
+            spare ^= 1;
+        }
+    }
+    return found;
+}
+
+size_t device_manager_get_sightings(DeviceManager* manager, const char* address,
+                                    DeviceSighting* sightings, size_t max) {
+    bt_addr_t key;
+    if (!manager || !address || !bt_addr_parse(address, &key)) return 0;
+    
+    size_t count = adapter_count(manager);
+    size_t found = 0;
+    uint64_t now = now_ms();
+    
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        
+        lock_adapter(manager, adapter);
+        DeviceSlot slot = device_store_find(adapter->devices, key);
+        if (slot != DEVICE_SLOT_NONE) {
+            if (found < max) {
+                uint64_t last_seen = device_store_last_seen(adapter->devices, slot);
+                sightings[found] = (DeviceSighting){
+                    .adapter = adapter->path,
+                    .rssi = device_store_rssi(adapter->devices, slot),
+                    .age_ms = last_seen && last_seen <= now ? now - last_seen : UINT64_MAX
+                };
+            }
+            found++;
+        }
+        unlock_adapter(manager, adapter);
+    }
+    
+    return found;
+}
+
+ErrorCode device_manager_get_filter_stats(DeviceManager* manager, DuplicateFilterStats* stats) {
+    if (!manager || !stats) return ERR_INVALID_ARG;
+    
+    stats->received = metrics_count(manager->metrics, COUNT_UPDATES_RECEIVED);
+    stats->suppressed = metrics_count(manager->metrics, COUNT_UPDATES_SUPPRESSED);
+    return SUCCESS;
+}
+
+ErrorCode device_manager_get_bus_stats(DeviceManager* manager, BusFilterStats* stats) {
+    if (!manager || !stats) return ERR_INVALID_ARG;
+    
+    stats->signals_received = metrics_count(manager->metrics, COUNT_SIGNALS_RECEIVED);
+    stats->signals_rejected = metrics_count(manager->metrics, COUNT_SIGNALS_REJECTED);
+    return SUCCESS;
+}
+
+ErrorCode device_manager_get_stats(DeviceManager* manager, DeviceManagerStats* stats) {
+    if (!manager || !stats) return ERR_INVALID_ARG;
+    
+    // Read without lock_adapter() so asking doesn't show up in the lock figures
+    size_t count = adapter_count(manager);
+    stats->adapters = 0;
+    stats->devices = 0;
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        
+        stats->adapters += atomic_load(&adapter->present);
+        pthread_mutex_lock(&adapter->mutex);
+        stats->devices += device_store_count(adapter->devices);
+        pthread_mutex_unlock(&adapter->mutex);
+    }
+    
+    stats->signals_received = metrics_count(manager->metrics, COUNT_SIGNALS_RECEIVED);
+    stats->signals_interfaces_added = metrics_count(manager->metrics, COUNT_INTERFACES_ADDED);
+    stats->signals_properties_changed = metrics_count(manager->metrics, COUNT_PROPERTIES_CHANGED);
+    stats->signals_rejected = metrics_count(manager->metrics, COUNT_SIGNALS_REJECTED);
+    stats->updates_suppressed = metrics_count(manager->metrics, COUNT_UPDATES_SUPPRESSED);
+    stats->devices_lost = metrics_count(manager->metrics, COUNT_DEVICES_LOST);
+    stats->snapshots_published = metrics_count(manager->metrics, COUNT_SNAPSHOTS);
+    metrics_latency(manager->metrics, LATENCY_PARSE, &stats->parse);
+    metrics_latency(manager->metrics, LATENCY_LOCK_WAIT, &stats->lock_wait);
+    metrics_latency(manager->metrics, LATENCY_LOCK_HOLD, &stats->lock_hold);
+    stats->callbacks_dropped = event_queue_dropped(manager->callbacks);
+    metrics_latency(manager->metrics, LATENCY_CALLBACK_DELAY, &stats->callback_delay);
+    return SUCCESS;
+}
+
+ErrorCode device_manager_write_metrics(DeviceManager* manager, int fd) {
+    if (!manager || fd < 0) return ERR_INVALID_ARG;
+    
+    char* text = NULL;
+    size_t length = 0;
+    if (!format_metrics(manager, &text, &length)) return ERR_MEMORY;
     
-    return device;
+    bool ok = metrics_write_fd(fd, text, length);
+    free(text);
+    return ok ? SUCCESS : ERR_IPC;
 }
 
 ErrorCode device_manager_set_alias(DeviceManager* manager, const char* address, const char* alias) {
     if (!manager || !address || !alias) return ERR_INVALID_ARG;
     
-    pthread_mutex_lock(&manager->mutex);
+    bt_addr_t key;
+    if (!bt_addr_parse(address, &key)) return ERR_INVALID_ARG;
     
-    BluetoothDevice* device = g_hash_table_lookup(manager->devices, address);
-    if (!device) {
-        pthread_mutex_unlock(&manager->mutex);
-        return ERR_NO_DEVICE;
+    size_t count = adapter_count(manager);
+    ErrorCode err = ERR_NO_DEVICE;
+    
+    for (size_t i = 0; i < count && err != ERR_MEMORY; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        
+        lock_adapter(manager, adapter);
+        
+        DeviceSlot slot = device_store_find(adapter->devices, key);
+        if (slot == DEVICE_SLOT_NONE) {
+            unlock_adapter(manager, adapter);
+            continue;
+        }
+        
+        if (!device_store_set_alias(adapter->devices, slot, alias)) {
+            err = ERR_MEMORY;
+        } else {
+            // Kept over BlueZ's alias and saved in the device cache, if configured
+            device_store_set_flag(adapter->devices, slot, DEVICE_FLAG_USER_ALIAS, true);
+            mark_device_changed(manager, adapter, slot);
+            err = SUCCESS;
+        }
+        
+        unlock_adapter(manager, adapter);
     }
     
-    strncpy(device->alias, alias, sizeof(device->alias) - 1);
+    return err;
+}
+
+ErrorCode device_manager_remove_device(DeviceManager* manager, const char* address) {
+    if (!manager || !address) return ERR_INVALID_ARG;
+    
+    bt_addr_t key;
+    if (!bt_addr_parse(address, &key)) return ERR_INVALID_ARG;
     
-    // TODO: Save alias to configuration file/database
+    size_t count = adapter_count(manager);
+    ErrorCode err = ERR_NO_DEVICE;
     
-    pthread_mutex_unlock(&manager->mutex);
-    return SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        Adapter* adapter = &manager->adapters[i];
+        
+        lock_adapter(manager, adapter);
+        DeviceSlot slot = device_store_find(adapter->devices, key);
+        if (slot != DEVICE_SLOT_NONE) {
+            forget_device(manager, adapter, slot, false);
+            err = SUCCESS;
+        }
+        unlock_adapter(manager, adapter);
+    }
+    
+    return err;
+}
+
+DeviceSnapshot* device_manager_snapshot(DeviceManager* manager) {
+    if (!manager) return NULL;
+    
+    pthread_mutex_lock(&manager->snapshot_mutex);
+    DeviceSnapshot* snapshot = device_snapshot_ref(manager->snapshot);
+    pthread_mutex_unlock(&manager->snapshot_mutex);
+    
+    return snapshot;
+}
+
+size_t device_snapshot_count(const DeviceSnapshot* snapshot) {
+    return snapshot ? snapshot->count : 0;
+}
+
+const BluetoothDevice* device_snapshot_get(const DeviceSnapshot* snapshot, size_t index) {
+    if (!snapshot || index >= snapshot->count) return NULL;
+    return &snapshot->devices[index];
+}
+
+const BluetoothDevice* device_snapshot_find(const DeviceSnapshot* snapshot, const char* address) {
+    bt_addr_t key;
+    if (!snapshot || !bt_addr_parse(address, &key)) return NULL;
+    
+    size_t low = 0, high = snapshot->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (snapshot->keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low < snapshot->count && snapshot->keys[low] == key ? &snapshot->devices[low] : NULL;
+}
+
+uint64_t device_snapshot_version(const DeviceSnapshot* snapshot) {
+    return snapshot ? snapshot->version : 0;
+}
+
+DeviceSnapshot* device_snapshot_ref(DeviceSnapshot* snapshot) {
+    if (snapshot) {
+        atomic_fetch_add(&snapshot->refcount, 1);
+    }
+    return snapshot;
+}
+
+void device_snapshot_unref(DeviceSnapshot* snapshot) {
+    if (!snapshot) return;
+    
+    if (atomic_fetch_sub(&snapshot->refcount, 1) == 1) {
+        free(snapshot->keys);
+        free(snapshot->devices);
+        string_arena_destroy(snapshot->strings);
+        free(snapshot);
+    }
 }
 
 void device_manager_destroy(DeviceManager* manager) {
     if (!manager) return;
     
-    // Stop scanning if active
-    pthread_mutex_lock(&manager->mutex);
-    if (manager->scanning) {
-        pthread_mutex_unlock(&manager->mutex);
-        bluez_stop_discovery(manager);
-        pthread_mutex_lock(&manager->mutex);
-        manager->scanning = false;
+    // Stop scanning, every timer and signal delivery; the bus thread itself
+    // keeps running for other managers
+    remove_match_rules(manager);
+    bus_core_run(manager->bus, detach_from_bus, manager);
+    
+    // No hotplug can race us now; the calls do their own I/O
+    lock_manager(manager);
+    if (manager->radio_on) {
+        Adapter* targets[MAX_ADAPTERS];
+        size_t count = 0;
+        for (size_t i = 0; i < adapter_count(manager); i++) {
+            if (manager->adapters[i].discovering) {
+                targets[count++] = &manager->adapters[i];
+            }
+        }
+        switch_discovery(manager, targets, count, false);
+        manager->radio_on = false;
     }
-    pthread_mutex_unlock(&manager->mutex);
-    
-    // Stop monitoring thread
-    manager->running = false;
+    unlock_manager(manager);
     
-    // Wait for thread to finish
-    pthread_join(manager->thread, NULL);
+    // Nothing raises events any more; deliver what is queued before the
+    // adapters go away
+    event_queue_destroy(manager->callbacks);
     
     // Cleanup
-    g_hash_table_destroy(manager->devices);
+    destroy_adapters(manager);
+    device_table_destroy(manager->duplicates, free);
+    device_snapshot_unref(manager->snapshot);
+    pthread_mutex_destroy(&manager->snapshot_mutex);
+    clear_filter(manager);
+    device_cache_close(manager->cache);
     
-    // Don't close shared connection, just unreference it
-    dbus_connection_unref(manager->conn);
+    // The last manager out closes the connection
+    bus_core_unref(manager->bus);
     
+    pthread_mutex_destroy(&manager->cache_mutex);
     pthread_mutex_destroy(&manager->mutex);
-    free(manager->adapter_path);
+    metrics_destroy(manager->metrics);
     free(manager);
 }
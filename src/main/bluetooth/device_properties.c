@@ -0,0 +1,169 @@
+#include "bluetooth/device_properties.h"
+#include <string.h>
+
+#define PROPERTY_HASH_SIZE 16
+
+/* Typed setter, value already checked against the entry's D-Bus type */
+typedef void (*PropertySetter)(BluetoothDevice* device, DBusBasicValue* value);
+
+typedef struct {
+    const char* name;
+    size_t length;
+    DeviceProperty property;
+    int dbus_type;
+    PropertySetter set;
+} PropertyEntry;
+
+static void set_address(BluetoothDevice* device, DBusBasicValue* value) {
+    strncpy(device->address, value->str, sizeof(device->address) - 1);
+    device->address[sizeof(device->address) - 1] = '\0';
+}
+
+static void set_name(BluetoothDevice* device, DBusBasicValue* value) {
+    device->name = value->str;
+}
+
+static void set_alias(BluetoothDevice* device, DBusBasicValue* value) {
+    device->alias = value->str;
+}
+
+static void set_class(BluetoothDevice* device, DBusBasicValue* value) {
+    device->class = value->u32;
+    device->type = device_type_from_class(value->u32);
+}
+
+static void set_paired(BluetoothDevice* device, DBusBasicValue* value) {
+    device->paired = value->bool_val;
+}
+
+static void set_trusted(BluetoothDevice* device, DBusBasicValue* value) {
+    device->trusted = value->bool_val;
+}
+
+static void set_blocked(BluetoothDevice* device, DBusBasicValue* value) {
+    device->blocked = value->bool_val;
+}
+
+static void set_rssi(BluetoothDevice* device, DBusBasicValue* value) {
+    device->rssi = (int8_t)value->i16;
+}
+
+static void set_connected(BluetoothDevice* device, DBusBasicValue* value) {
+    device->state = value->bool_val ? STATE_CONNECTED : STATE_DISCONNECTED;
+}
+
+/* Indexed by (2 * length + first character) % 16, which has no collisions
+ * for these names - recheck it when adding one */
+#define PROPERTY(key, prop, type, setter) \
+    { key, sizeof(key) - 1, prop, type, setter }
+
+static const PropertyEntry property_table[PROPERTY_HASH_SIZE] = {
+    [0]  = PROPERTY("Blocked",          DEVICE_PROP_BLOCKED,           DBUS_TYPE_BOOLEAN, set_blocked),
+    [2]  = PROPERTY("Trusted",          DEVICE_PROP_TRUSTED,           DBUS_TYPE_BOOLEAN, set_trusted),
+    [3]  = PROPERTY("ServicesResolved", DEVICE_PROP_SERVICES_RESOLVED, DBUS_TYPE_BOOLEAN, NULL),
+    [5]  = PROPERTY("Connected",        DEVICE_PROP_CONNECTED,         DBUS_TYPE_BOOLEAN, set_connected),
+    [6]  = PROPERTY("Name",             DEVICE_PROP_NAME,              DBUS_TYPE_STRING,  set_name),
+    [10] = PROPERTY("RSSI",             DEVICE_PROP_RSSI,              DBUS_TYPE_INT16,   set_rssi),
+    [11] = PROPERTY("Alias",            DEVICE_PROP_ALIAS,             DBUS_TYPE_STRING,  set_alias),
+    [12] = PROPERTY("Paired",           DEVICE_PROP_PAIRED,            DBUS_TYPE_BOOLEAN, set_paired),
+    [13] = PROPERTY("Class",            DEVICE_PROP_CLASS,             DBUS_TYPE_UINT32,  set_class),
+    [15] = PROPERTY("Address",          DEVICE_PROP_ADDRESS,           DBUS_TYPE_STRING,  set_address),
+};
+
+static const PropertyEntry* find_entry(const char* key) {
+    size_t length = strlen(key);
+    const PropertyEntry* entry =
+        &property_table[(2 * length + (unsigned char)key[0]) & (PROPERTY_HASH_SIZE - 1)];
+        
+    if (entry->length != length || memcmp(entry->name, key, length) != 0) return NULL;
+    return entry;
+}
+
+DeviceProperty device_property_lookup(const char* key) {
+    const PropertyEntry* entry = key ? find_entry(key) : NULL;
+    return entry ? entry->property : DEVICE_PROP_UNKNOWN;
+}
+
+uint32_t device_properties_decode(DBusMessageIter* iter, BluetoothDevice* device) {
+    return device_properties_decode_bools(iter, device, NULL);
+}
+
+uint32_t device_properties_decode_bools(DBusMessageIter* iter, BluetoothDevice* device,
+                                        uint32_t* true_mask) {
+    DBusMessageIter dict_iter;
+    uint32_t mask = 0;
+    uint32_t truths = 0;
+    
+    if (dbus_message_iter_get_arg_type(iter) != DBUS_TYPE_ARRAY) return 0;
+    dbus_message_iter_recurse(iter, &dict_iter);
+    
+    while (dbus_message_iter_get_arg_type(&dict_iter) == DBUS_TYPE_DICT_ENTRY) {
+        DBusMessageIter entry_iter, variant_iter;
+        char *key = NULL;
+        
+        dbus_message_iter_recurse(&dict_iter, &entry_iter);
+        dbus_message_iter_get_basic(&entry_iter, &key);
+        
+        const PropertyEntry* entry = find_entry(key);
+        if (entry) {
+            dbus_message_iter_next(&entry_iter);
+            dbus_message_iter_recurse(&entry_iter, &variant_iter);
+            
+            if (dbus_message_iter_get_arg_type(&variant_iter) == entry->dbus_type) {
+                DBusBasicValue value;
+                dbus_message_iter_get_basic(&variant_iter, &value);
+                if (entry->set) {
+                    entry->set(device, &value);
+                }
+                if (entry->dbus_type == DBUS_TYPE_BOOLEAN && value.bool_val) {
+                    truths |= DEVICE_PROP_BIT(entry->property);
+                }
+                mask |= DEVICE_PROP_BIT(entry->property);
+            }
+        }
+        
+        dbus_message_iter_next(&dict_iter);
+    }
+    
+    if (true_mask) {
+        *true_mask = truths;
+    }
+    return mask;
+}
+
+/* Convert DBus string to device type */
+DeviceType device_type_from_class(uint32_t class) {
+    uint32_t major_class = (class >> 8) & 0x1F;
+    uint32_t minor_class = (class >> 2) & 0x3F;
+    
+    switch (major_class) {
+        case 0x04:  // Audio/Video
+            if (minor_class == 0x04)  // Headset
+                return DEVICE_AUDIO_SINK;
+            else if (minor_class == 0x08)  // Hands-free
+                return DEVICE_AUDIO_SINK;
+            else if (minor_class == 0x03)  // Microphone
+                return DEVICE_AUDIO_SOURCE;
+            return DEVICE_AUDIO_SINK;
+            
+        case 0x05:  // Peripheral
+            switch (minor_class) {
+                case 0x01:  // Keyboard
+                    return DEVICE_KEYBOARD;
+                case 0x02:  // Mouse
+                    return DEVICE_MOUSE;
+                case 0x03:  // Keyboard/Mouse combo
+                    return DEVICE_KEYBOARD;
+            }
+            return DEVICE_INPUT;
+            
+        case 0x02:  // Phone
+            return DEVICE_PHONE;
+            
+        case 0x01:  // Computer
+            return DEVICE_COMPUTER;
+            
+        default:
+            return DEVICE_UNKNOWN;
+    }
+}
@@ -0,0 +1,418 @@
+#include "bluetooth/device_records.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_SHIFT 10
+#define CHUNK_RECORDS (1u << CHUNK_SHIFT)        // Records per chunk
+#define MAX_CHUNKS 4096                          // Up to 4M devices
+#define MIN_INDEX_CAPACITY 64
+#define INDEX_TOMBSTONE (BT_ADDR_NONE - 1)       // Removed entry, probing continues
+#define GOLDEN_RATIO_64 0x9E3779B97F4A7C15ULL
+
+#define RECORD_WORDS ((sizeof(BluetoothDevice) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+#define STRING_WORDS ((sizeof(DeviceStrings) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+
+/* One device, copied in and out word by word under its sequence counter.
+ * The image's name/alias pointers are not used; the strings themselves
+ * are kept here, as the store's may move once the record is read. */
+typedef struct {
+    atomic_uint seq;                            // Odd while a write is in progress
+    atomic_uint_least64_t addr;                 // Owner of the slot, BT_ADDR_NONE if free
+    atomic_uint_least64_t words[RECORD_WORDS];  // BluetoothDevice image
+    atomic_uint_least64_t strings[STRING_WORDS]; // DeviceStrings image, NUL padded
+} DeviceRecord;
+
+/* Address -> slot, open addressing; entries only go EMPTY -> key -> TOMBSTONE
+ * (or a tombstone is reused) so readers can probe without locks */
+typedef struct RecordIndex {
+    size_t capacity;                            // Power of two
+    int shift;
+    atomic_uint_least64_t* keys;                // BT_ADDR_NONE = empty
+    atomic_uint* slots;
+    atomic_uint seq;                            // Odd while tombstones are compacted
+    struct RecordIndex* retired_next;           // Writer-only: outgrown generations
+} RecordIndex;
+
+/* Live index entry, saved while compacting */
+typedef struct {
+    bt_addr_t key;
+    unsigned slot;
+} IndexEntry;
+
+/* Internal directory structure */
+struct DeviceRecords {
+    _Atomic(DeviceRecord*) chunks[MAX_CHUNKS];
+    _Atomic(RecordIndex*) index;
+    size_t live;                                // Writer-only counters
+    size_t used;                                // live + tombstones
+};
+
+/* Same Fibonacci hashing as DeviceTable */
+static inline size_t home_slot(const RecordIndex* index, bt_addr_t key) {
+    return (size_t)((key * GOLDEN_RATIO_64) >> index->shift);
+}
+
+static RecordIndex* index_new(size_t capacity) {
+    RecordIndex* index = calloc(1, sizeof(RecordIndex));
+    if (!index) return NULL;
+    
+    index->keys = malloc(capacity * sizeof(*index->keys));
+    index->slots = malloc(capacity * sizeof(*index->slots));
+    if (!index->keys || !index->slots) {
+        free(index->keys);
+        free(index->slots);
+        free(index);
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&index->keys[i], BT_ADDR_NONE);
+        atomic_init(&index->slots[i], 0);
+    }
+    atomic_init(&index->seq, 0);
+    
+    int bits = 0;
+    while (((size_t)1 << bits) < capacity) bits++;
+    index->capacity = capacity;
+    index->shift = 64 - bits;
+    return index;
+}
+
+static void index_free_all(RecordIndex* index) {
+    while (index) {
+        RecordIndex* next = index->retired_next;
+        free(index->keys);
+        free(index->slots);
+        free(index);
+        index = next;
+    }
+}
+
+/* Insert into an index that is not yet visible to readers */
+static void index_place(RecordIndex* index, bt_addr_t key, unsigned slot) {
+    size_t mask = index->capacity - 1;
+    size_t i = home_slot(index, key);
+    
+    while (atomic_load_explicit(&index->keys[i], memory_order_relaxed) != BT_ADDR_NONE) {
+        i = (i + 1) & mask;
+    }
+    atomic_store_explicit(&index->slots[i], slot, memory_order_relaxed);
+    atomic_store_explicit(&index->keys[i], key, memory_order_relaxed);
+}
+
+/* Index capacity for a number of live entries */
+static size_t index_capacity_for(size_t live) {
+    size_t capacity = MIN_INDEX_CAPACITY;
+    while (capacity / 2 < live) capacity *= 2;
+    return capacity;
+}
+
+/* Rehash the live entries of the current index in place, dropping its
+ * tombstones. Readers that probe meanwhile see seq change and retry, so
+ * nothing has to be retired. */
+static bool index_compact(DeviceRecords* records, RecordIndex* index) {
+    IndexEntry* entries = malloc((records->live + 1) * sizeof(IndexEntry));
+    if (!entries) return false;
+    
+    size_t count = 0;
+    for (size_t i = 0; i < index->capacity; i++) {
+        bt_addr_t key = atomic_load_explicit(&index->keys[i], memory_order_relaxed);
+        if (key != BT_ADDR_NONE && key != INDEX_TOMBSTONE) {
+            entries[count].key = key;
+            entries[count].slot = atomic_load_explicit(&index->slots[i], memory_order_relaxed);
+            count++;
+        }
+    }
+    
+    unsigned seq = atomic_load_explicit(&index->seq, memory_order_relaxed);
+    atomic_store_explicit(&index->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    for (size_t i = 0; i < index->capacity; i++) {
+        atomic_store_explicit(&index->keys[i], BT_ADDR_NONE, memory_order_relaxed);
+    }
+    for (size_t i = 0; i < count; i++) {
+        index_place(index, entries[i].key, entries[i].slot);
+    }
+    
+    atomic_store_explicit(&index->seq, seq + 2, memory_order_release);
+    records->used = records->live;
+    free(entries);
+    return true;
+}
+
+/* Make room for min_live entries: compact in place if the index is big
+ * enough, otherwise publish a bigger one */
+static bool index_rebuild(DeviceRecords* records, size_t min_live) {
+    RecordIndex* old = atomic_load_explicit(&records->index, memory_order_relaxed);
+    
+    size_t capacity = index_capacity_for(min_live);
+    if (capacity <= old->capacity) {
+        return index_compact(records, old);
+    }
+    
+    RecordIndex* index = index_new(capacity);
+    if (!index) return false;
+    
+    for (size_t i = 0; i < old->capacity; i++) {
+        bt_addr_t key = atomic_load_explicit(&old->keys[i], memory_order_relaxed);
+        if (key != BT_ADDR_NONE && key != INDEX_TOMBSTONE) {
+            index_place(index, key, atomic_load_explicit(&old->slots[i], memory_order_relaxed));
+        }
+    }
+    
+    // Readers may still be probing the old generation - keep it until destroy.
+    // Capacity doubles each time, so all of them add up to less than the last.
+    index->retired_next = old;
+    atomic_store_explicit(&records->index, index, memory_order_release);
+    records->used = records->live;
+    return true;
+}
+
+/* Seqlock write of one record. Names rarely change, so only string words
+ * that differ are stored. */
+static void record_write(DeviceRecord* record, bt_addr_t addr, const BluetoothDevice* device) {
+    uint64_t image[RECORD_WORDS] = {0};
+    memcpy(image, device, sizeof(BluetoothDevice));
+    
+    DeviceStrings text = {0};
+    strncpy(text.name, device->name, DEVICE_STRING_MAX - 1);
+    strncpy(text.alias, device->alias, DEVICE_STRING_MAX - 1);
+    uint64_t strings[STRING_WORDS] = {0};
+    memcpy(strings, &text, sizeof(text));
+    
+    unsigned seq = atomic_load_explicit(&record->seq, memory_order_relaxed);
+    atomic_store_explicit(&record->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    atomic_store_explicit(&record->addr, addr, memory_order_relaxed);
+    for (size_t i = 0; i < RECORD_WORDS; i++) {
+        atomic_store_explicit(&record->words[i], image[i], memory_order_relaxed);
+    }
+    for (size_t i = 0; i < STRING_WORDS; i++) {
+        if (atomic_load_explicit(&record->strings[i], memory_order_relaxed) != strings[i]) {
+            atomic_store_explicit(&record->strings[i], strings[i], memory_order_relaxed);
+        }
+    }
+    
+    atomic_store_explicit(&record->seq, seq + 2, memory_order_release);
+}
+
+static DeviceRecord* record_for_slot(const DeviceRecords* records, DeviceSlot slot) {
+    if (slot >= (DeviceSlot)MAX_CHUNKS * CHUNK_RECORDS) return NULL;
+    
+    DeviceRecord* chunk = atomic_load_explicit(&records->chunks[slot >> CHUNK_SHIFT],
+                                               memory_order_acquire);
+    return chunk ? &chunk[slot & (CHUNK_RECORDS - 1)] : NULL;
+}
+
+DeviceRecords* device_records_create(void) {
+    DeviceRecords* records = calloc(1, sizeof(DeviceRecords));
+    if (!records) return NULL;
+    
+    for (size_t i = 0; i < MAX_CHUNKS; i++) {
+        atomic_init(&records->chunks[i], NULL);
+    }
+    
+    RecordIndex* index = index_new(MIN_INDEX_CAPACITY);
+    if (!index) {
+        free(records);
+        return NULL;
+    }
+    atomic_init(&records->index, index);
+    return records;
+}
+
+bool device_records_publish(DeviceRecords* records, DeviceSlot slot, bt_addr_t addr,
+                            const BluetoothDevice* device) {
+    if (!records || !device || addr == BT_ADDR_NONE || addr == INDEX_TOMBSTONE ||
+        slot >= (DeviceSlot)MAX_CHUNKS * CHUNK_RECORDS) {
+        return false;
+    }
+    
+    // Records never move: allocate the chunk once and publish it
+    size_t chunk_index = slot >> CHUNK_SHIFT;
+    DeviceRecord* chunk = atomic_load_explicit(&records->chunks[chunk_index], memory_order_relaxed);
+    if (!chunk) {
+        chunk = malloc(CHUNK_RECORDS * sizeof(DeviceRecord));
+        if (!chunk) return false;
+        
+        for (size_t i = 0; i < CHUNK_RECORDS; i++) {
+            atomic_init(&chunk[i].seq, 0);
+            atomic_init(&chunk[i].addr, BT_ADDR_NONE);
+            for (size_t w = 0; w < RECORD_WORDS; w++) {
+                atomic_init(&chunk[i].words[w], 0);
+            }
+            for (size_t w = 0; w < STRING_WORDS; w++) {
+                atomic_init(&chunk[i].strings[w], 0);
+            }
+        }
+        atomic_store_explicit(&records->chunks[chunk_index], chunk, memory_order_release);
+    }
+    
+    record_write(&chunk[slot & (CHUNK_RECORDS - 1)], addr, device);
+    
+    // Index the address unless it already points at this slot
+    RecordIndex* index = atomic_load_explicit(&records->index, memory_order_relaxed);
+    size_t mask = index->capacity - 1;
+    size_t i = home_slot(index, addr);
+    size_t reuse = index->capacity;
+    
+    for (;;) {
+        bt_addr_t key = atomic_load_explicit(&index->keys[i], memory_order_relaxed);
+        if (key == addr) {
+            if (atomic_load_explicit(&index->slots[i], memory_order_relaxed) != slot) {
+                atomic_store_explicit(&index->slots[i], slot, memory_order_release);
+            }
+            return true;
+        }
+        if (key == BT_ADDR_NONE) break;
+        if (key == INDEX_TOMBSTONE && reuse == index->capacity) reuse = i;
+        i = (i + 1) & mask;
+    }
+    
+    if (reuse == index->capacity) {
+        // Claiming an empty entry - keep the table at most 3/4 used
+        if ((records->used + 1) * 4 > index->capacity * 3) {
+            if (!index_rebuild(records, records->live + 1)) return false;
+            index = atomic_load_explicit(&records->index, memory_order_relaxed);
+            mask = index->capacity - 1;
+            i = home_slot(index, addr);
+            while (atomic_load_explicit(&index->keys[i], memory_order_relaxed) != BT_ADDR_NONE) {
+                i = (i + 1) & mask;
+            }
+        }
+        reuse = i;
+        records->used++;
+    }
+    
+    // Slot first, then the key with release so a reader that sees the key sees the slot
+    atomic_store_explicit(&index->slots[reuse], slot, memory_order_relaxed);
+    atomic_store_explicit(&index->keys[reuse], addr, memory_order_release);
+    records->live++;
+    return true;
+}
+
+void device_records_remove(DeviceRecords* records, bt_addr_t addr) {
+    if (!records || addr == BT_ADDR_NONE || addr == INDEX_TOMBSTONE) return;
+    
+    RecordIndex* index = atomic_load_explicit(&records->index, memory_order_relaxed);
+    size_t mask = index->capacity - 1;
+    size_t i = home_slot(index, addr);
+    
+    for (;;) {
+        bt_addr_t key = atomic_load_explicit(&index->keys[i], memory_order_relaxed);
+        if (key == BT_ADDR_NONE) return;
+        if (key == addr) break;
+        i = (i + 1) & mask;
+    }
+    
+    atomic_store_explicit(&index->keys[i], INDEX_TOMBSTONE, memory_order_release);
+    records->live--;
+    
+    // Mark the record free so a reader holding the stale slot sees a mismatch
+    DeviceRecord* record = record_for_slot(records,
+                                           atomic_load_explicit(&index->slots[i], memory_order_relaxed));
+    if (record && atomic_load_explicit(&record->addr, memory_order_relaxed) == addr) {
+        unsigned seq = atomic_load_explicit(&record->seq, memory_order_relaxed);
+        atomic_store_explicit(&record->seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&record->addr, BT_ADDR_NONE, memory_order_relaxed);
+        atomic_store_explicit(&record->seq, seq + 2, memory_order_release);
+    }
+    
+    // Too many tombstones make misses probe long runs - compact
+    if (records->used - records->live > index->capacity / 4) {
+        index_compact(records, index);
+    }
+}
+
+/* Look addr up in one index generation and copy its record; false on a
+ * miss or if the slot no longer belongs to addr */
+static bool record_read(const DeviceRecords* records, const RecordIndex* index,
+                        bt_addr_t addr, BluetoothDevice* out, DeviceStrings* text) {
+    size_t mask = index->capacity - 1;
+    size_t i = home_slot(index, addr);
+    unsigned slot;
+    
+    for (size_t probes = 0; ; probes++) {
+        if (probes > mask) return false;
+        
+        bt_addr_t key = atomic_load_explicit(&index->keys[i], memory_order_acquire);
+        if (key == addr) {
+            slot = atomic_load_explicit(&index->slots[i], memory_order_acquire);
+            break;
+        }
+        if (key == BT_ADDR_NONE) return false;
+        i = (i + 1) & mask;
+    }
+    
+    DeviceRecord* record = record_for_slot(records, slot);
+    if (!record) return false;
+    
+    uint64_t image[RECORD_WORDS];
+    uint64_t strings[STRING_WORDS];
+    unsigned seq_before, seq_after;
+    bt_addr_t owner;
+    
+    do {
+        seq_before = atomic_load_explicit(&record->seq, memory_order_acquire);
+        if (seq_before & 1) continue;  // Write in progress
+        
+        owner = atomic_load_explicit(&record->addr, memory_order_relaxed);
+        for (size_t w = 0; w < RECORD_WORDS; w++) {
+            image[w] = atomic_load_explicit(&record->words[w], memory_order_relaxed);
+        }
+        for (size_t w = 0; text && w < STRING_WORDS; w++) {
+            strings[w] = atomic_load_explicit(&record->strings[w], memory_order_relaxed);
+        }
+        
+        atomic_thread_fence(memory_order_acquire);
+        seq_after = atomic_load_explicit(&record->seq, memory_order_relaxed);
+    } while ((seq_before & 1) || seq_before != seq_after);
+    
+    // The slot was freed or handed to another device after we looked it up
+    if (owner != addr) return false;
+    
+    memcpy(out, image, sizeof(BluetoothDevice));
+    if (text) {
+        memcpy(text, strings, sizeof(*text));
+        out->name = text->name;
+        out->alias = text->alias;
+    } else {
+        out->name = "";
+        out->alias = "";
+    }
+    return true;
+}
+
+bool device_records_read(const DeviceRecords* records, bt_addr_t addr, BluetoothDevice* out,
+                         DeviceStrings* text) {
+    if (!records || !out || addr == BT_ADDR_NONE || addr == INDEX_TOMBSTONE) return false;
+    
+    for (;;) {
+        RecordIndex* index = atomic_load_explicit(&((DeviceRecords*)records)->index, memory_order_acquire);
+        unsigned seq = atomic_load_explicit(&index->seq, memory_order_acquire);
+        if (seq & 1) continue;  // Compaction in progress
+        
+        if (record_read(records, index, addr, out, text)) return true;
+        
+        // A miss only counts if the index was neither compacted nor replaced underneath it
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&index->seq, memory_order_relaxed) == seq &&
+            atomic_load_explicit(&((DeviceRecords*)records)->index, memory_order_relaxed) == index) {
+            return false;
+        }
+    }
+}
+
+void device_records_destroy(DeviceRecords* records) {
+    if (!records) return;
+    
+    for (size_t i = 0; i < MAX_CHUNKS; i++) {
+        free(atomic_load_explicit(&records->chunks[i], memory_order_relaxed));
+    }
+    index_free_all(atomic_load_explicit(&records->index, memory_order_relaxed));
+    free(records);
+}
@@ -0,0 +1,396 @@
+#include "bluetooth/device_store.h"
+#include "bluetooth/device_table.h"
+#include "bluetooth/string_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_CAPACITY 64
+#define MIN_STRING_BYTES (128 * 1024)   // Arena size not worth compacting below
+
+/* The address index stores slot + 1 so that slot 0 is not a NULL value */
+#define SLOT_TO_VALUE(slot) ((void*)(uintptr_t)((slot) + 1))
+#define VALUE_TO_SLOT(value) ((DeviceSlot)((uintptr_t)(value) - 1))
+
+/* Internal store structure */
+struct DeviceStore {
+    size_t capacity;
+    size_t count;
+    
+    // Hot: read or written on every advertisement
+    bt_addr_t* addr;          // BT_ADDR_NONE marks a free slot
+    int8_t* rssi;
+    uint8_t* state;           // ConnectionState
+    uint8_t* type;            // DeviceType
+    uint8_t* flags;           // DEVICE_FLAG_*
+    uint64_t* last_seen;      // Monotonic ms
+    DeviceSlot* age_prev;     // Age list links, DEVICE_SLOT_NONE at the ends
+    DeviceSlot* age_next;
+    
+    // Cold: set at discovery, read when a caller asks
+    uint32_t* class;
+    const char** name;
+    const char** alias;
+    void** user_data;
+    
+    DeviceSlot* free_slots;   // Stack of released slots
+    size_t free_count;
+    size_t used;              // Slots handed out at least once
+    
+    DeviceSlot age_head;      // Aging devices, least recently seen first
+    DeviceSlot age_tail;
+    
+    DeviceTable* index;       // bt_addr_t -> slot
+    StringArena* strings;
+    const char* empty;        // Interned ""
+    size_t strings_floor;     // Arena size after the last compaction
+};
+
+/* realloc() one parallel array to the new capacity */
+#define GROW_ARRAY(store, field, capacity) do { \
+        void* grown = realloc((store)->field, (capacity) * sizeof(*(store)->field)); \
+        if (!grown) return false; \
+        (store)->field = grown; \
+    } while (0)
+
+static bool grow(DeviceStore* store, size_t capacity) {
+    GROW_ARRAY(store, addr, capacity);
+    GROW_ARRAY(store, rssi, capacity);
+    GROW_ARRAY(store, state, capacity);
+    GROW_ARRAY(store, type, capacity);
+    GROW_ARRAY(store, flags, capacity);
+    GROW_ARRAY(store, last_seen, capacity);
+    GROW_ARRAY(store, age_prev, capacity);
+    GROW_ARRAY(store, age_next, capacity);
+    GROW_ARRAY(store, class, capacity);
+    GROW_ARRAY(store, name, capacity);
+    GROW_ARRAY(store, alias, capacity);
+    GROW_ARRAY(store, user_data, capacity);
+    GROW_ARRAY(store, free_slots, capacity);
+    
+    store->capacity = capacity;
+    return true;
+}
+
+DeviceStore* device_store_create(size_t capacity_hint) {
+    DeviceStore* store = calloc(1, sizeof(DeviceStore));
+    if (!store) return NULL;
+    
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < capacity_hint) capacity *= 2;
+    
+    store->age_head = DEVICE_SLOT_NONE;
+    store->age_tail = DEVICE_SLOT_NONE;
+    store->index = device_table_create(capacity);
+    store->strings = string_arena_create();
+    store->empty = string_arena_intern(store->strings, "");
+    
+    if (!store->index || !store->empty || !grow(store, capacity)) {
+        device_store_destroy(store);
+        return NULL;
+    }
+    return store;
+}
+
+DeviceSlot device_store_find(const DeviceStore* store, bt_addr_t addr) {
+    if (!store) return DEVICE_SLOT_NONE;
+    
+    void* value = device_table_lookup(store->index, addr);
+    return value ? VALUE_TO_SLOT(value) : DEVICE_SLOT_NONE;
+}
+
+DeviceSlot device_store_add(DeviceStore* store, bt_addr_t addr) {
+    if (!store || addr == BT_ADDR_NONE) return DEVICE_SLOT_NONE;
+    
+    DeviceSlot slot = device_store_find(store, addr);
+    if (slot != DEVICE_SLOT_NONE) return slot;
+    
+    if (store->free_count > 0) {
+        slot = store->free_slots[--store->free_count];
+    } else {
+        if (store->used == store->capacity && !grow(store, store->capacity * 2)) {
+            return DEVICE_SLOT_NONE;
+        }
+        slot = (DeviceSlot)store->used++;
+    }
+    
+    if (!device_table_insert(store->index, addr, SLOT_TO_VALUE(slot), NULL)) {
+        if (slot == store->used - 1) {
+            store->used--;
+        } else {
+            store->free_slots[store->free_count++] = slot;
+        }
+        return DEVICE_SLOT_NONE;
+    }
+    
+    store->addr[slot] = addr;
+    store->rssi[slot] = 0;
+    store->state[slot] = STATE_DISCONNECTED;
+    store->type[slot] = DEVICE_UNKNOWN;
+    store->flags[slot] = 0;
+    store->last_seen[slot] = 0;
+    store->age_prev[slot] = DEVICE_SLOT_NONE;
+    store->age_next[slot] = DEVICE_SLOT_NONE;
+    store->class[slot] = 0;
+    store->name[slot] = store->empty;
+    store->alias[slot] = store->empty;
+    store->user_data[slot] = NULL;
+    store->count++;
+    return slot;
+}
+
+static bool age_listed(const DeviceStore* store, DeviceSlot slot) {
+    return store->age_prev[slot] != DEVICE_SLOT_NONE || store->age_head == slot;
+}
+
+static void age_unlink(DeviceStore* store, DeviceSlot slot) {
+    DeviceSlot prev = store->age_prev[slot];
+    DeviceSlot next = store->age_next[slot];
+    
+    if (prev != DEVICE_SLOT_NONE) store->age_next[prev] = next; else store->age_head = next;
+    if (next != DEVICE_SLOT_NONE) store->age_prev[next] = prev; else store->age_tail = prev;
+    
+    store->age_prev[slot] = DEVICE_SLOT_NONE;
+    store->age_next[slot] = DEVICE_SLOT_NONE;
+}
+
+/* Link after prev (DEVICE_SLOT_NONE = at the head) */
+static void age_link_after(DeviceStore* store, DeviceSlot slot, DeviceSlot prev) {
+    DeviceSlot next = prev != DEVICE_SLOT_NONE ? store->age_next[prev] : store->age_head;
+    
+    store->age_prev[slot] = prev;
+    store->age_next[slot] = next;
+    if (prev != DEVICE_SLOT_NONE) store->age_next[prev] = slot; else store->age_head = slot;
+    if (next != DEVICE_SLOT_NONE) store->age_prev[next] = slot; else store->age_tail = slot;
+}
+
+void device_store_remove(DeviceStore* store, DeviceSlot slot) {
+    if (!store || slot >= store->used || store->addr[slot] == BT_ADDR_NONE) return;
+    
+    if (age_listed(store, slot)) {
+        age_unlink(store, slot);
+    }
+    device_table_remove(store->index, store->addr[slot]);
+    store->addr[slot] = BT_ADDR_NONE;
+    store->free_slots[store->free_count++] = slot;
+    store->count--;
+}
+
+size_t device_store_count(const DeviceStore* store) {
+    return store ? store->count : 0;
+}
+
+DeviceSlot device_store_next(const DeviceStore* store, DeviceSlot* cursor) {
+    if (!store || !cursor) return DEVICE_SLOT_NONE;
+    
+    for (size_t i = *cursor; i < store->used; i++) {
+        if (store->addr[i] != BT_ADDR_NONE) {
+            *cursor = (DeviceSlot)(i + 1);
+            return (DeviceSlot)i;
+        }
+    }
+    
+    *cursor = (DeviceSlot)store->used;
+    return DEVICE_SLOT_NONE;
+}
+
+bt_addr_t device_store_addr(const DeviceStore* store, DeviceSlot slot) {
+    return store->addr[slot];
+}
+
+int8_t device_store_rssi(const DeviceStore* store, DeviceSlot slot) {
+    return store->rssi[slot];
+}
+
+void device_store_set_rssi(DeviceStore* store, DeviceSlot slot, int8_t rssi) {
+    store->rssi[slot] = rssi;
+}
+
+ConnectionState device_store_state(const DeviceStore* store, DeviceSlot slot) {
+    return (ConnectionState)store->state[slot];
+}
+
+void device_store_set_state(DeviceStore* store, DeviceSlot slot, ConnectionState state) {
+    store->state[slot] = (uint8_t)state;
+}
+
+DeviceType device_store_type(const DeviceStore* store, DeviceSlot slot) {
+    return (DeviceType)store->type[slot];
+}
+
+void device_store_set_type(DeviceStore* store, DeviceSlot slot, DeviceType type) {
+    store->type[slot] = (uint8_t)type;
+}
+
+uint8_t device_store_flags(const DeviceStore* store, DeviceSlot slot) {
+    return store->flags[slot];
+}
+
+void device_store_set_flag(DeviceStore* store, DeviceSlot slot, uint8_t flag, bool on) {
+    if (on) {
+        store->flags[slot] |= flag;
+    } else {
+        store->flags[slot] &= (uint8_t)~flag;
+    }
+}
+
+uint64_t device_store_last_seen(const DeviceStore* store, DeviceSlot slot) {
+    return store->last_seen[slot];
+}
+
+void device_store_touch(DeviceStore* store, DeviceSlot slot, uint64_t now_ms) {
+    store->last_seen[slot] = now_ms;
+    
+    if (age_listed(store, slot) && store->age_tail != slot) {
+        age_unlink(store, slot);
+        age_link_after(store, slot, store->age_tail);
+    }
+}
+
+void device_store_set_aging(DeviceStore* store, DeviceSlot slot, bool aging) {
+    if (aging == age_listed(store, slot)) return;
+    
+    if (!aging) {
+        age_unlink(store, slot);
+        return;
+    }
+    
+    // Usually the newest; walk back from the tail otherwise
+    DeviceSlot prev = store->age_tail;
+    while (prev != DEVICE_SLOT_NONE && store->last_seen[prev] > store->last_seen[slot]) {
+        prev = store->age_prev[prev];
+    }
+    age_link_after(store, slot, prev);
+}
+
+DeviceSlot device_store_oldest(const DeviceStore* store) {
+    return store ? store->age_head : DEVICE_SLOT_NONE;
+}
+
+uint32_t device_store_class(const DeviceStore* store, DeviceSlot slot) {
+    return store->class[slot];
+}
+
+void device_store_set_class(DeviceStore* store, DeviceSlot slot, uint32_t class) {
+    store->class[slot] = class;
+}
+
+const char* device_store_name(const DeviceStore* store, DeviceSlot slot) {
+    return store->name[slot];
+}
+
+bool device_store_set_name(DeviceStore* store, DeviceSlot slot, const char* name) {
+    const char* interned = string_arena_intern(store->strings, name);
+    if (!interned) return false;
+    
+    store->name[slot] = interned;
+    return true;
+}
+
+const char* device_store_alias(const DeviceStore* store, DeviceSlot slot) {
+    return store->alias[slot];
+}
+
+bool device_store_set_alias(DeviceStore* store, DeviceSlot slot, const char* alias) {
+    const char* interned = string_arena_intern(store->strings, alias);
+    if (!interned) return false;
+    
+    store->alias[slot] = interned;
+    return true;
+}
+
+void* device_store_user_data(const DeviceStore* store, DeviceSlot slot) {
+    return store->user_data[slot];
+}
+
+void device_store_set_user_data(DeviceStore* store, DeviceSlot slot, void* user_data) {
+    store->user_data[slot] = user_data;
+}
+
+void device_store_load(const DeviceStore* store, DeviceSlot slot, BluetoothDevice* out) {
+    uint8_t flags = store->flags[slot];
+    
+    bt_addr_format(store->addr[slot], out->address);
+    out->name = store->name[slot];
+    out->alias = store->alias[slot];
+    out->type = (DeviceType)store->type[slot];
+    out->state = (ConnectionState)store->state[slot];
+    out->rssi = store->rssi[slot];
+    out->paired = (flags & DEVICE_FLAG_PAIRED) != 0;
+    out->trusted = (flags & DEVICE_FLAG_TRUSTED) != 0;
+    out->blocked = (flags & DEVICE_FLAG_BLOCKED) != 0;
+    out->class = store->class[slot];
+    out->user_data = store->user_data[slot];
+}
+
+bool device_store_compact_strings(DeviceStore* store) {
+    if (!store) return false;
+    
+    size_t bytes = string_arena_bytes(store->strings);
+    size_t floor = store->strings_floor > MIN_STRING_BYTES ? store->strings_floor : MIN_STRING_BYTES;
+    if (bytes <= 2 * floor) return false;
+    
+    // Re-intern what live slots use; the rest is dropped with the old arena
+    StringArena* strings = string_arena_create();
+    const char* empty = string_arena_intern(strings, "");
+    bool ok = empty != NULL;
+    
+    for (size_t slot = 0; ok && slot < store->used; slot++) {
+        if (store->addr[slot] == BT_ADDR_NONE) continue;
+        ok = string_arena_intern(strings, store->name[slot]) &&
+             string_arena_intern(strings, store->alias[slot]);
+    }
+    if (!ok) {
+        // Out of memory: keep the old arena and wait for it to double again
+        string_arena_destroy(strings);
+        store->strings_floor = bytes;
+        return false;
+    }
+    
+    for (size_t slot = 0; slot < store->used; slot++) {
+        if (store->addr[slot] == BT_ADDR_NONE) continue;
+        store->name[slot] = string_arena_intern(strings, store->name[slot]);
+        store->alias[slot] = string_arena_intern(strings, store->alias[slot]);
+    }
+    
+    string_arena_destroy(store->strings);
+    store->strings = strings;
+    store->empty = empty;
+    store->strings_floor = string_arena_bytes(strings);
+    return true;
+}
+
+size_t device_store_hot_bytes(const DeviceStore* store) {
+    if (!store) return 0;
+    return store->capacity * (sizeof(*store->addr) + sizeof(*store->rssi) + sizeof(*store->state) +
+                              sizeof(*store->type) + sizeof(*store->flags) +
+                              sizeof(*store->last_seen) + sizeof(*store->age_prev) +
+                              sizeof(*store->age_next));
+}
+
+size_t device_store_cold_bytes(const DeviceStore* store) {
+    if (!store) return 0;
+    return store->capacity * (sizeof(*store->class) + sizeof(*store->name) + sizeof(*store->alias) +
+                              sizeof(*store->user_data) + sizeof(*store->free_slots)) +
+           device_table_bytes(store->index) + string_arena_bytes(store->strings);
+}
+
+void device_store_destroy(DeviceStore* store) {
+    if (!store) return;
+    
+    free(store->addr);
+    free(store->rssi);
+    free(store->state);
+    free(store->type);
+    free(store->flags);
+    free(store->last_seen);
+    free(store->age_prev);
+    free(store->age_next);
+    free(store->class);
+    free(store->name);
+    free(store->alias);
+    free(store->user_data);
+    free(store->free_slots);
+    device_table_destroy(store->index, NULL);
+    string_arena_destroy(store->strings);
+    free(store);
+}
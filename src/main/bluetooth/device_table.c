@@ -0,0 +1,205 @@
+#include "bluetooth/device_table.h"
+#include <stdlib.h>
+
+#define MIN_CAPACITY 16
+#define GOLDEN_RATIO_64 0x9E3779B97F4A7C15ULL
+
+/* Internal table structure */
+struct DeviceTable {
+    bt_addr_t* keys;          // BT_ADDR_NONE marks an empty slot
+    void** values;
+    size_t capacity;          // Power of two
+    size_t count;
+    int shift;                // 64 - log2(capacity)
+};
+
+/* Fibonacci hashing: the top bits of key * 2^64/phi spread sequential
+ * OUIs and serials evenly across the table */
+static inline size_t home_slot(const DeviceTable* table, bt_addr_t key) {
+    return (size_t)((key * GOLDEN_RATIO_64) >> table->shift);
+}
+
+static bool allocate_slots(DeviceTable* table, size_t capacity) {
+    bt_addr_t* keys = malloc(capacity * sizeof(bt_addr_t));
+    void** values = malloc(capacity * sizeof(void*));
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return false;
+    }
+    
+    for (size_t i = 0; i < capacity; i++) {
+        keys[i] = BT_ADDR_NONE;
+    }
+    
+    int bits = 0;
+    while (((size_t)1 << bits) < capacity) bits++;
+    
+    table->keys = keys;
+    table->values = values;
+    table->capacity = capacity;
+    table->shift = 64 - bits;
+    return true;
+}
+
+/* Place a key known to be absent */
+static void place(DeviceTable* table, bt_addr_t key, void* value) {
+    size_t mask = table->capacity - 1;
+    size_t i = home_slot(table, key);
+    
+    while (table->keys[i] != BT_ADDR_NONE) {
+        i = (i + 1) & mask;
+    }
+    table->keys[i] = key;
+    table->values[i] = value;
+}
+
+static bool grow(DeviceTable* table) {
+    bt_addr_t* old_keys = table->keys;
+    void** old_values = table->values;
+    size_t old_capacity = table->capacity;
+    
+    if (!allocate_slots(table, old_capacity * 2)) return false;
+    
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_keys[i] != BT_ADDR_NONE) {
+            place(table, old_keys[i], old_values[i]);
+        }
+    }
+    
+    free(old_keys);
+    free(old_values);
+    return true;
+}
+
+/* Slot holding key, or capacity if absent */
+static size_t find_slot(const DeviceTable* table, bt_addr_t key) {
+    size_t mask = table->capacity - 1;
+    size_t i = home_slot(table, key);
+    
+    // The table is never full, so an empty slot always ends the probe
+    for (;;) {
+        bt_addr_t k = table->keys[i];
+        if (k == key) return i;
+        if (k == BT_ADDR_NONE) return table->capacity;
+        i = (i + 1) & mask;
+    }
+}
+
+DeviceTable* device_table_create(size_t capacity_hint) {
+    DeviceTable* table = calloc(1, sizeof(DeviceTable));
+    if (!table) return NULL;
+    
+    // Keep the load factor at or below 3/4
+    size_t capacity = MIN_CAPACITY;
+    while (capacity - capacity / 4 < capacity_hint) capacity *= 2;
+    
+    if (!allocate_slots(table, capacity)) {
+        free(table);
+        return NULL;
+    }
+    return table;
+}
+
+void* device_table_lookup(const DeviceTable* table, bt_addr_t key) {
+    if (!table || key == BT_ADDR_NONE) return NULL;
+    
+    size_t i = find_slot(table, key);
+    return i < table->capacity ? table->values[i] : NULL;
+}
+
+bool device_table_insert(DeviceTable* table, bt_addr_t key, void* value, void** replaced) {
+    if (!table || key == BT_ADDR_NONE) return false;
+    
+    size_t i = find_slot(table, key);
+    if (i < table->capacity) {
+        if (replaced) *replaced = table->values[i];
+        table->values[i] = value;
+        return true;
+    }
+    
+    if (table->count + 1 > table->capacity - table->capacity / 4 && !grow(table)) {
+        return false;
+    }
+    
+    place(table, key, value);
+    table->count++;
+    if (replaced) *replaced = NULL;
+    return true;
+}
+
+void* device_table_remove(DeviceTable* table, bt_addr_t key) {
+    if (!table || key == BT_ADDR_NONE) return NULL;
+    
+    size_t i = find_slot(table, key);
+    if (i == table->capacity) return NULL;
+    
+    void* value = table->values[i];
+    size_t mask = table->capacity - 1;
+    
+    // Backward-shift: pull later entries of the run into the hole when the
+    // hole lies between their home slot and where they currently sit
+    size_t hole = i;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        bt_addr_t k = table->keys[j];
+        if (k == BT_ADDR_NONE) break;
+        
+        size_t home = home_slot(table, k);
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            table->keys[hole] = k;
+            table->values[hole] = table->values[j];
+            hole = j;
+        }
+    }
+    
+    table->keys[hole] = BT_ADDR_NONE;
+    table->count--;
+    return value;
+}
+
+size_t device_table_count(const DeviceTable* table) {
+    return table ? table->count : 0;
+}
+
+size_t device_table_bytes(const DeviceTable* table) {
+    return table ? table->capacity * (sizeof(bt_addr_t) + sizeof(void*)) : 0;
+}
+
+bool device_table_next(const DeviceTable* table, size_t* cursor, bt_addr_t* key, void** value) {
+    if (!table || !cursor) return false;
+    
+    for (size_t i = *cursor; i < table->capacity; i++) {
+        if (table->keys[i] != BT_ADDR_NONE) {
+            if (key) *key = table->keys[i];
+            if (value) *value = table->values[i];
+            *cursor = i + 1;
+            return true;
+        }
+    }
+    
+    *cursor = table->capacity;
+    return false;
+}
+
+void device_table_clear(DeviceTable* table, DeviceTableFreeFunc free_value) {
+    if (!table) return;
+    
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->keys[i] != BT_ADDR_NONE) {
+            if (free_value) free_value(table->values[i]);
+            table->keys[i] = BT_ADDR_NONE;
+        }
+    }
+    table->count = 0;
+}
+
+void device_table_destroy(DeviceTable* table, DeviceTableFreeFunc free_value) {
+    if (!table) return;
+    
+    device_table_clear(table, free_value);
+    free(table->keys);
+    free(table->values);
+    free(table);
+}
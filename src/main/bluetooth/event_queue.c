@@ -0,0 +1,260 @@
+#include "bluetooth/event_queue.h"
+#include "bluetooth/metrics.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define DEFAULT_CAPACITY 1024
+#define DEFAULT_POOL_THREADS 4
+#define BATCH_MAX 64                      // Events handed to the handler at once
+
+/* Internal queue structure */
+struct EventQueue {
+    EventQueueConfig config;
+    DeviceEventHandler handler;
+    void* user_data;
+    atomic_int refcount;                  // Owner + a scheduled main context dispatch
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;             // Consumer threads wait here
+    pthread_cond_t not_full;              // CALLBACK_OVERFLOW_BLOCK producers wait here
+    pthread_cond_t idle;                  // destroy waits here for running batches
+    DeviceEvent* events;                  // Ring of capacity events
+    size_t capacity;
+    size_t head;
+    size_t count;
+    int busy;                             // Batches being handled right now
+    bool closing;
+    bool dispatch_scheduled;              // A main context dispatch is pending
+    uint64_t dropped;
+    pthread_t* threads;
+    int thread_count;
+};
+
+/* Queue whose handler the current thread is running, if any */
+static _Thread_local const EventQueue* delivering;
+
+static void queue_unref(EventQueue* queue) {
+    if (atomic_fetch_sub(&queue->refcount, 1) != 1) return;
+    
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->idle);
+    pthread_mutex_destroy(&queue->mutex);
+    if (queue->config.context) {
+        g_main_context_unref(queue->config.context);
+    }
+    free(queue->threads);
+    free(queue->events);
+    free(queue);
+}
+
+/* Move up to BATCH_MAX events out of the ring (mutex held) */
+static size_t take_batch(EventQueue* queue, DeviceEvent* batch) {
+    size_t n = queue->count < BATCH_MAX ? queue->count : BATCH_MAX;
+    
+    for (size_t i = 0; i < n; i++) {
+        batch[i] = queue->events[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+    }
+    queue->count -= n;
+    queue->busy++;
+    
+    if (n > 0 && queue->config.overflow == CALLBACK_OVERFLOW_BLOCK) {
+        pthread_cond_broadcast(&queue->not_full);
+    }
+    return n;
+}
+
+/* Run the handler on a batch without the mutex */
+static void deliver(EventQueue* queue, DeviceEvent* batch, size_t n) {
+    pthread_mutex_unlock(&queue->mutex);
+    
+    delivering = queue;
+    queue->handler(batch, n, queue->user_data);
+    delivering = NULL;
+    
+    pthread_mutex_lock(&queue->mutex);
+    if (--queue->busy == 0) {
+        pthread_cond_broadcast(&queue->idle);
+    }
+}
+
+/* Thread and pool executors: handle batches until closed and drained */
+static void* consumer_thread(void* arg) {
+    EventQueue* queue = arg;
+    DeviceEvent batch[BATCH_MAX];
+    
+    pthread_mutex_lock(&queue->mutex);
+    for (;;) {
+        while (queue->count == 0 && !queue->closing) {
+            pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        }
+        if (queue->count == 0) break;
+        
+        size_t n = take_batch(queue, batch);
+        deliver(queue, batch, n);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return NULL;
+}
+
+/* Main context executor: one batch per call, rescheduled while more is queued */
+static gboolean dispatch_batch(gpointer data) {
+    EventQueue* queue = data;
+    DeviceEvent batch[BATCH_MAX];
+    
+    pthread_mutex_lock(&queue->mutex);
+    if (!queue->closing && queue->count > 0) {
+        size_t n = take_batch(queue, batch);
+        deliver(queue, batch, n);
+    }
+    
+    bool more = !queue->closing && queue->count > 0;
+    if (!more) {
+        queue->dispatch_scheduled = false;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return more;
+}
+
+static void dispatch_done(gpointer data) {
+    queue_unref(data);
+}
+
+EventQueue* event_queue_create(const EventQueueConfig* config, DeviceEventHandler handler, void* user_data) {
+    if (!config || !handler) return NULL;
+    
+    EventQueue* queue = calloc(1, sizeof(EventQueue));
+    if (!queue) return NULL;
+    
+    queue->config = *config;
+    queue->handler = handler;
+    queue->user_data = user_data;
+    queue->capacity = config->capacity > 0 ? (size_t)config->capacity : DEFAULT_CAPACITY;
+    queue->events = malloc(queue->capacity * sizeof(DeviceEvent));
+    atomic_init(&queue->refcount, 1);
+    
+    if (!queue->events) {
+        free(queue);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    pthread_cond_init(&queue->idle, NULL);
+    
+    if (config->executor == CALLBACK_EXECUTOR_MAIN_CONTEXT) {
+        queue->config.context = g_main_context_ref(config->context ? config->context : g_main_context_default());
+        return queue;
+    }
+    
+    int threads = 1;
+    if (config->executor == CALLBACK_EXECUTOR_POOL) {
+        threads = config->threads > 0 ? config->threads : DEFAULT_POOL_THREADS;
+    }
+    
+    queue->threads = calloc((size_t)threads, sizeof(pthread_t));
+    if (!queue->threads) {
+        queue_unref(queue);
+        return NULL;
+    }
+    for (; queue->thread_count < threads; queue->thread_count++) {
+        if (pthread_create(&queue->threads[queue->thread_count], NULL, consumer_thread, queue) != 0) {
+            event_queue_destroy(queue);
+            return NULL;
+        }
+    }
+    
+    return queue;
+}
+
+void event_queue_push(EventQueue* queue, const DeviceEvent* events, size_t count) {
+    if (!queue || count == 0) return;
+    
+    uint64_t now = metrics_now_ns();
+    bool schedule = false;
+    
+    pthread_mutex_lock(&queue->mutex);
+    
+    for (size_t i = 0; i < count && !queue->closing; i++) {
+        if (queue->count == queue->capacity && queue->config.overflow == CALLBACK_OVERFLOW_BLOCK &&
+            delivering != queue) {
+            while (queue->count == queue->capacity && !queue->closing) {
+                pthread_cond_wait(&queue->not_full, &queue->mutex);
+            }
+            if (queue->closing) break;
+        }
+        
+        if (queue->count == queue->capacity) {
+            queue->dropped++;
+            if (queue->config.overflow == CALLBACK_OVERFLOW_DROP_NEWEST) continue;
+            
+            queue->head = (queue->head + 1) % queue->capacity;
+            queue->count--;
+        }
+        
+        DeviceEvent* slot = &queue->events[(queue->head + queue->count) % queue->capacity];
+        *slot = events[i];
+        slot->queued_ns = now;
+        queue->count++;
+    }
+    
+    if (queue->count > 0) {
+        if (queue->threads) {
+            pthread_cond_broadcast(&queue->not_empty);
+        } else if (!queue->dispatch_scheduled && !queue->closing) {
+            queue->dispatch_scheduled = true;
+            atomic_fetch_add(&queue->refcount, 1);
+            schedule = true;
+        }
+    }
+    
+    pthread_mutex_unlock(&queue->mutex);
+    
+    // Always go through an idle source: invoking directly would run
+    // dispatch_batch on this thread whenever it can acquire the context
+    if (schedule) {
+        GSource* source = g_idle_source_new();
+        g_source_set_priority(source, G_PRIORITY_DEFAULT);
+        g_source_set_callback(source, dispatch_batch, queue, dispatch_done);
+        g_source_attach(source, queue->config.context);
+        g_source_unref(source);
+    }
+}
+
+uint64_t event_queue_dropped(EventQueue* queue) {
+    if (!queue) return 0;
+    
+    pthread_mutex_lock(&queue->mutex);
+    uint64_t dropped = queue->dropped;
+    pthread_mutex_unlock(&queue->mutex);
+    
+    return dropped;
+}
+
+void event_queue_destroy(EventQueue* queue) {
+    if (!queue) return;
+    
+    pthread_mutex_lock(&queue->mutex);
+    queue->closing = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+    
+    // Consumer threads drain the queue before they exit
+    for (int i = 0; i < queue->thread_count; i++) {
+        pthread_join(queue->threads[i], NULL);
+    }
+    
+    // A main context batch may still be running
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->busy > 0) {
+        pthread_cond_wait(&queue->idle, &queue->mutex);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    
+    queue_unref(queue);
+}
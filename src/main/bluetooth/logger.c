@@ -0,0 +1,217 @@
+#include "bluetooth/logger.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define RING_ENTRIES 256                  // Messages buffered per thread, power of two
+
+/* One formatted message */
+typedef struct {
+    int level;
+    char text[LOGGER_MESSAGE_MAX];
+} LogEntry;
+
+/* Single-producer ring owned by one thread at a time, drained by the writer.
+ * Rings are never freed; once a released ring has been written out it is
+ * reused by the next thread that logs, so memory stays bounded. */
+typedef struct LogRing {
+    struct LogRing* next;
+    atomic_bool owned;
+    atomic_size_t head;                   // Next entry to write out (consumer)
+    atomic_size_t tail;                   // Next entry to fill (owning thread)
+    atomic_size_t dropped;                // Messages lost to a full ring
+    LogEntry entries[RING_ENTRIES];
+} LogRing;
+
+static _Atomic(LogRing*) rings;           // Push-only list of every ring
+static _Thread_local LogRing* thread_ring;
+static pthread_key_t ring_key;            // Releases the ring on thread exit
+static pthread_once_t start_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER; // One consumer at a time
+static pthread_t writer;
+static atomic_bool writer_running;
+static atomic_bool stopping;
+static pthread_mutex_t wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static atomic_bool writer_idle;           // Writer is about to wait or waiting on wake
+
+static const char* const prefixes[] = { "Error: ", "Warning: ", "", "Debug: " };
+
+/* Thread exit: hand the ring back, whatever is queued still gets written */
+static void release_ring(void* data) {
+    LogRing* ring = data;
+    atomic_store_explicit(&ring->owned, false, memory_order_release);
+}
+
+/* Take over a released ring that has been written out, or add a new one */
+static LogRing* claim_ring(void) {
+    LogRing* ring = atomic_load_explicit(&rings, memory_order_acquire);
+    
+    for (; ring; ring = ring->next) {
+        bool expected = false;
+        if (atomic_load_explicit(&ring->head, memory_order_acquire) ==
+            atomic_load_explicit(&ring->tail, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&ring->owned, &expected, true,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+    
+    if (!ring) {
+        ring = calloc(1, sizeof(LogRing));
+        if (!ring) return NULL;
+        atomic_init(&ring->owned, true);
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->dropped, 0);
+        
+        ring->next = atomic_load_explicit(&rings, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&rings, &ring->next, ring,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    
+    pthread_setspecific(ring_key, ring);
+    thread_ring = ring;
+    return ring;
+}
+
+/* Write out one ring (drain_mutex held). Returns the number of messages. */
+static size_t drain_ring(LogRing* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+    size_t written = tail - head;
+    
+    for (; head != tail; head++) {
+        const LogEntry* entry = &ring->entries[head & (RING_ENTRIES - 1)];
+        FILE* out = entry->level <= LOGGER_LEVEL_WARN ? stderr : stdout;
+        fputs(prefixes[entry->level], out);
+        fputs(entry->text, out);
+        fputc('\n', out);
+    }
+    atomic_store_explicit(&ring->head, head, memory_order_release);
+    
+    if (dropped > 0) {
+        fprintf(stderr, "Warning: %zu log messages dropped\n", dropped);
+    }
+    return written;
+}
+
+/* Write out every ring */
+static size_t drain_all(void) {
+    size_t written = 0;
+    
+    pthread_mutex_lock(&drain_mutex);
+    for (LogRing* ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next) {
+        written += drain_ring(ring);
+    }
+    if (written > 0) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    pthread_mutex_unlock(&drain_mutex);
+    
+    return written;
+}
+
+/* Whether any ring holds messages not yet written out */
+static bool rings_pending(void) {
+    for (LogRing* ring = atomic_load_explicit(&rings, memory_order_acquire); ring; ring = ring->next) {
+        if (atomic_load(&ring->tail) != atomic_load_explicit(&ring->head, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Wake the writer if it is idle; producers call this after publishing */
+static void wake_writer(void) {
+    if (atomic_load(&writer_idle) && atomic_exchange(&writer_idle, false)) {
+        pthread_mutex_lock(&wake_mutex);
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&wake_mutex);
+    }
+}
+
+/* Background writer: drain until stopped, blocking while there is nothing
+ * to do. writer_idle is raised before the rings are checked a last time
+ * and a producer checks it after publishing, so either the writer sees the
+ * message or the producer sees the writer idle and wakes it. */
+static void* writer_thread(void* arg) {
+    (void)arg;
+    
+    while (!atomic_load_explicit(&stopping, memory_order_acquire)) {
+        if (drain_all() > 0) continue;
+        
+        pthread_mutex_lock(&wake_mutex);
+        atomic_store(&writer_idle, true);
+        if (!rings_pending()) {
+            while (atomic_load(&writer_idle) && !atomic_load_explicit(&stopping, memory_order_acquire)) {
+                pthread_cond_wait(&wake, &wake_mutex);
+            }
+        }
+        atomic_store(&writer_idle, false);
+        pthread_mutex_unlock(&wake_mutex);
+    }
+    return NULL;
+}
+
+/* atexit: stop the writer and write out what is left */
+static void stop_writer(void) {
+    atomic_store_explicit(&stopping, true, memory_order_release);
+    pthread_mutex_lock(&wake_mutex);
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&wake_mutex);
+    
+    if (atomic_exchange(&writer_running, false)) {
+        pthread_join(writer, NULL);
+    }
+    drain_all();
+}
+
+/* First message: start the writer thread */
+static void start_writer(void) {
+    pthread_key_create(&ring_key, release_ring);
+    atomic_store(&writer_running, pthread_create(&writer, NULL, writer_thread, NULL) == 0);
+    atexit(stop_writer);
+}
+
+void logger_write(int level, const char* format, ...) {
+    if (level < LOGGER_LEVEL_ERROR || level > LOGGER_LEVEL_DEBUG) return;
+    pthread_once(&start_once, start_writer);
+    
+    LogRing* ring = thread_ring ? thread_ring : claim_ring();
+    if (!ring) return;
+    
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == RING_ENTRIES) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+    
+    LogEntry* entry = &ring->entries[tail & (RING_ENTRIES - 1)];
+    entry->level = level;
+    
+    va_list args;
+    va_start(args, format);
+    vsnprintf(entry->text, sizeof(entry->text), format, args);
+    va_end(args);
+    
+    // Sequentially consistent against writer_idle, see writer_thread()
+    atomic_store(&ring->tail, tail + 1);
+    
+    // No writer thread: write synchronously rather than lose messages
+    if (!atomic_load_explicit(&writer_running, memory_order_relaxed)) {
+        drain_all();
+    } else {
+        wake_writer();
+    }
+}
+
+void logger_flush(void) {
+    drain_all();
+}
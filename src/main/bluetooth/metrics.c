@@ -0,0 +1,232 @@
+#include "bluetooth/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+#define STRIPES 4                         // Threads are spread over this many stripes
+#define SUB_BITS 3                        // 8 linear buckets per power of two (12.5%)
+#define SUB_BUCKETS (1u << SUB_BITS)
+#define MAX_MAGNITUDE 40                  // Samples are clamped to 2^40 ns (~18 minutes)
+#define BUCKETS ((MAX_MAGNITUDE - SUB_BITS + 1) * SUB_BUCKETS)
+#define CACHE_LINE 64
+
+/* One histogram's share of a stripe */
+typedef struct {
+    atomic_uint_fast64_t sum;
+    atomic_uint_fast64_t max;
+    atomic_uint_fast64_t buckets[BUCKETS];
+} Histogram;
+
+/* Everything one group of threads records into, on its own cache lines */
+typedef struct {
+    atomic_uint_fast64_t* counters;
+    Histogram* histograms;
+} Stripe;
+
+/* Internal metrics structure */
+struct Metrics {
+    size_t counter_count;
+    size_t histogram_count;
+    Stripe stripes[STRIPES];
+};
+
+static atomic_uint next_stripe;
+static _Thread_local int thread_stripe = -1;
+
+/* Stripe of the calling thread, handed out round-robin on first use */
+static Stripe* my_stripe(Metrics* metrics) {
+    if (thread_stripe < 0) {
+        thread_stripe = (int)(atomic_fetch_add_explicit(&next_stripe, 1, memory_order_relaxed) % STRIPES);
+    }
+    return &metrics->stripes[thread_stripe];
+}
+
+/* Log-linear bucket of a sample: exact below 8, then 8 steps per octave */
+static size_t bucket_index(uint64_t ns) {
+    if (ns >= (1ull << MAX_MAGNITUDE)) ns = (1ull << MAX_MAGNITUDE) - 1;
+    if (ns < SUB_BUCKETS) return (size_t)ns;
+    
+    unsigned magnitude = 63u - (unsigned)__builtin_clzll(ns);
+    unsigned shift = magnitude - SUB_BITS;
+    return (size_t)(magnitude - SUB_BITS + 1) * SUB_BUCKETS + (size_t)((ns >> shift) & (SUB_BUCKETS - 1));
+}
+
+/* Highest value that lands in a bucket */
+static uint64_t bucket_upper(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    
+    unsigned shift = (unsigned)(index / SUB_BUCKETS) - 1;
+    uint64_t lower = (uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + (1ull << shift) - 1;
+}
+
+Metrics* metrics_create(size_t counters, size_t histograms) {
+    Metrics* metrics = calloc(1, sizeof(Metrics));
+    if (!metrics) return NULL;
+    
+    metrics->counter_count = counters;
+    metrics->histogram_count = histograms;
+    
+    for (int s = 0; s < STRIPES; s++) {
+        Stripe* stripe = &metrics->stripes[s];
+        void* block = NULL;
+        size_t counter_bytes = (counters * sizeof(atomic_uint_fast64_t) + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+        
+        if (posix_memalign(&block, CACHE_LINE, counter_bytes + histograms * sizeof(Histogram) + CACHE_LINE) != 0) {
+            metrics_destroy(metrics);
+            return NULL;
+        }
+        stripe->counters = block;
+        stripe->histograms = (Histogram*)((char*)block + counter_bytes);
+        
+        for (size_t i = 0; i < counters; i++) {
+            atomic_init(&stripe->counters[i], 0);
+        }
+        for (size_t h = 0; h < histograms; h++) {
+            Histogram* histogram = &stripe->histograms[h];
+            atomic_init(&histogram->sum, 0);
+            atomic_init(&histogram->max, 0);
+            for (size_t b = 0; b < BUCKETS; b++) {
+                atomic_init(&histogram->buckets[b], 0);
+            }
+        }
+    }
+    
+    return metrics;
+}
+
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_add(Metrics* metrics, size_t counter, uint64_t value) {
+    if (!metrics || counter >= metrics->counter_count) return;
+    atomic_fetch_add_explicit(&my_stripe(metrics)->counters[counter], value, memory_order_relaxed);
+}
+
+void metrics_record(Metrics* metrics, size_t histogram, uint64_t ns) {
+    if (!metrics || histogram >= metrics->histogram_count) return;
+    
+    Histogram* target = &my_stripe(metrics)->histograms[histogram];
+    atomic_fetch_add_explicit(&target->buckets[bucket_index(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&target->sum, ns, memory_order_relaxed);
+    
+    uint64_t max = atomic_load_explicit(&target->max, memory_order_relaxed);
+    while (ns > max && !atomic_compare_exchange_weak_explicit(&target->max, &max, ns,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint64_t metrics_count(const Metrics* metrics, size_t counter) {
+    if (!metrics || counter >= metrics->counter_count) return 0;
+    
+    uint64_t total = 0;
+    for (int s = 0; s < STRIPES; s++) {
+        total += atomic_load_explicit(&metrics->stripes[s].counters[counter], memory_order_relaxed);
+    }
+    return total;
+}
+
+void metrics_latency(const Metrics* metrics, size_t histogram, LatencyStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!metrics || histogram >= metrics->histogram_count) return;
+    
+    uint64_t buckets[BUCKETS] = {0};
+    
+    for (int s = 0; s < STRIPES; s++) {
+        Histogram* source = &metrics->stripes[s].histograms[histogram];
+        uint64_t max = atomic_load_explicit(&source->max, memory_order_relaxed);
+        
+        stats->sum_ns += atomic_load_explicit(&source->sum, memory_order_relaxed);
+        if (max > stats->max_ns) stats->max_ns = max;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            buckets[b] += atomic_load_explicit(&source->buckets[b], memory_order_relaxed);
+        }
+    }
+    
+    // Count from the buckets so percentiles stay consistent with them
+    for (size_t b = 0; b < BUCKETS; b++) {
+        stats->count += buckets[b];
+    }
+    if (stats->count == 0) return;
+    stats->mean_ns = stats->sum_ns / stats->count;
+    
+    static const unsigned permille[] = { 500, 900, 990, 999 };
+    uint64_t* targets[] = { &stats->p50_ns, &stats->p90_ns, &stats->p99_ns, &stats->p999_ns };
+    uint64_t seen = 0;
+    size_t next = 0;
+    
+    for (size_t b = 0; b < BUCKETS && next < 4; b++) {
+        seen += buckets[b];
+        while (next < 4 && seen * 1000 >= stats->count * permille[next]) {
+            uint64_t upper = bucket_upper(b);
+            *targets[next++] = upper < stats->max_ns ? upper : stats->max_ns;
+        }
+    }
+}
+
+void metrics_destroy(Metrics* metrics) {
+    if (!metrics) return;
+    
+    for (int s = 0; s < STRIPES; s++) {
+        free(metrics->stripes[s].counters);
+    }
+    free(metrics);
+}
+
+void metrics_print_counter(FILE* out, const char* name, const char* help, uint64_t value) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+            name, help, name, name, (unsigned long long)value);
+}
+
+void metrics_print_gauge(FILE* out, const char* name, const char* help, uint64_t value) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %llu\n",
+            name, help, name, name, (unsigned long long)value);
+}
+
+void metrics_print_latency(FILE* out, const char* name, const char* help, const LatencyStats* stats) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s summary\n", name, help, name);
+    fprintf(out, "%s{quantile=\"0.5\"} %.9f\n", name, stats->p50_ns / 1e9);
+    fprintf(out, "%s{quantile=\"0.9\"} %.9f\n", name, stats->p90_ns / 1e9);
+    fprintf(out, "%s{quantile=\"0.99\"} %.9f\n", name, stats->p99_ns / 1e9);
+    fprintf(out, "%s{quantile=\"0.999\"} %.9f\n", name, stats->p999_ns / 1e9);
+    fprintf(out, "%s_sum %.9f\n", name, stats->sum_ns / 1e9);
+    fprintf(out, "%s_count %llu\n", name, (unsigned long long)stats->count);
+}
+
+bool metrics_write_fd(int fd, const char* text, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, text, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        text += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+bool metrics_write_file(const char* path, const char* text, size_t length) {
+    size_t tmp_len = strlen(path) + 5;
+    char* tmp_path = malloc(tmp_len);
+    if (!tmp_path) return false;
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && metrics_write_fd(fd, text, length);
+    if (fd >= 0 && close(fd) != 0) ok = false;
+    
+    // Scrapers never see a half-written file
+    if (ok) ok = rename(tmp_path, path) == 0;
+    if (!ok && fd >= 0) unlink(tmp_path);
+    
+    free(tmp_path);
+    return ok;
+}
@@ -0,0 +1,151 @@
+#include "bluetooth/string_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_SIZE (64 * 1024)
+#define MIN_BUCKETS 256
+
+/* Block of string data; strings never move once written */
+typedef struct Chunk {
+    struct Chunk* next;
+    size_t used;
+    size_t size;
+    char data[];
+} Chunk;
+
+/* Internal arena structure */
+struct StringArena {
+    Chunk* chunks;            // Newest first, only the head has free space
+    const char** buckets;     // Open-addressing intern index, NULL = empty
+    uint32_t* hashes;         // Cached hash per bucket to skip most strcmp()s
+    size_t capacity;          // Power of two
+    size_t count;
+    size_t data_bytes;
+};
+
+/* FNV-1a */
+static uint32_t hash_string(const char* str, size_t* length) {
+    uint32_t hash = 2166136261u;
+    const unsigned char* p = (const unsigned char*)str;
+    
+    while (*p) {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    *length = (size_t)(p - (const unsigned char*)str);
+    return hash;
+}
+
+static bool resize_index(StringArena* arena, size_t capacity) {
+    const char** buckets = calloc(capacity, sizeof(const char*));
+    uint32_t* hashes = malloc(capacity * sizeof(uint32_t));
+    if (!buckets || !hashes) {
+        free(buckets);
+        free(hashes);
+        return false;
+    }
+    
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < arena->capacity; i++) {
+        if (!arena->buckets[i]) continue;
+        
+        size_t j = arena->hashes[i] & mask;
+        while (buckets[j]) j = (j + 1) & mask;
+        buckets[j] = arena->buckets[i];
+        hashes[j] = arena->hashes[i];
+    }
+    
+    free(arena->buckets);
+    free(arena->hashes);
+    arena->buckets = buckets;
+    arena->hashes = hashes;
+    arena->capacity = capacity;
+    return true;
+}
+
+/* Copy length + 1 bytes into the arena */
+static const char* store_string(StringArena* arena, const char* str, size_t length) {
+    Chunk* chunk = arena->chunks;
+    
+    if (!chunk || chunk->size - chunk->used < length + 1) {
+        size_t size = length + 1 > CHUNK_SIZE ? length + 1 : CHUNK_SIZE;
+        chunk = malloc(sizeof(Chunk) + size);
+        if (!chunk) return NULL;
+        
+        chunk->used = 0;
+        chunk->size = size;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->data_bytes += size;
+    }
+    
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, str, length + 1);
+    chunk->used += length + 1;
+    return copy;
+}
+
+StringArena* string_arena_create(void) {
+    StringArena* arena = calloc(1, sizeof(StringArena));
+    if (!arena) return NULL;
+    
+    if (!resize_index(arena, MIN_BUCKETS)) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+const char* string_arena_intern(StringArena* arena, const char* str) {
+    if (!arena) return NULL;
+    if (!str) str = "";
+    
+    size_t length;
+    uint32_t hash = hash_string(str, &length);
+    size_t mask = arena->capacity - 1;
+    size_t i = hash & mask;
+    
+    while (arena->buckets[i]) {
+        if (arena->hashes[i] == hash && strcmp(arena->buckets[i], str) == 0) {
+            return arena->buckets[i];
+        }
+        i = (i + 1) & mask;
+    }
+    
+    // Keep the index at most half full so probes stay short
+    if ((arena->count + 1) * 2 > arena->capacity) {
+        if (!resize_index(arena, arena->capacity * 2)) return NULL;
+        
+        mask = arena->capacity - 1;
+        i = hash & mask;
+        while (arena->buckets[i]) i = (i + 1) & mask;
+    }
+    
+    const char* copy = store_string(arena, str, length);
+    if (!copy) return NULL;
+    
+    arena->buckets[i] = copy;
+    arena->hashes[i] = hash;
+    arena->count++;
+    return copy;
+}
+
+size_t string_arena_bytes(const StringArena* arena) {
+    if (!arena) return 0;
+    return arena->data_bytes + arena->capacity * (sizeof(const char*) + sizeof(uint32_t));
+}
+
+void string_arena_destroy(StringArena* arena) {
+    if (!arena) return;
+    
+    Chunk* chunk = arena->chunks;
+    while (chunk) {
+        Chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    
+    free(arena->buckets);
+    free(arena->hashes);
+    free(arena);
+}
@@ -0,0 +1,219 @@
+#include "bluetooth/timer_wheel.h"
+#include <stdlib.h>
+
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_MAX_DELTA ((1ULL << (WHEEL_LEVELS * WHEEL_BITS)) - 1)
+
+/* Internal timer wheel structure */
+struct TimerWheel {
+    WheelTimer slots[WHEEL_LEVELS][WHEEL_SIZE];  // List sentinels
+    size_t level_count[WHEEL_LEVELS];            // Timers per level, lets advance skip empty levels
+    WheelTimer expired;                          // Expired, not yet popped
+    uint64_t tick;                               // Current tick
+    uint64_t base_ms;
+    uint32_t tick_ms;
+    size_t count;                                // Armed timers (wheel + expired)
+};
+
+/* Circular doubly linked list helpers */
+
+static void list_init(WheelTimer* head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static bool list_empty(const WheelTimer* head) {
+    return head->next == head;
+}
+
+static void list_append(WheelTimer* head, WheelTimer* timer) {
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+static void list_unlink(WheelTimer* timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+static uint64_t ms_to_tick(const TimerWheel* wheel, uint64_t now_ms) {
+    return now_ms > wheel->base_ms ? (now_ms - wheel->base_ms) / wheel->tick_ms : 0;
+}
+
+/* Link a timer into the level matching its distance from the current tick */
+static void place_timer(TimerWheel* wheel, WheelTimer* timer) {
+    if (timer->expires <= wheel->tick) {
+        timer->level = -1;
+        list_append(&wheel->expired, timer);
+        return;
+    }
+    
+    // Far timers park in the top level and cascade down again later
+    uint64_t delta = timer->expires - wheel->tick;
+    uint64_t slot_tick = timer->expires;
+    if (delta > WHEEL_MAX_DELTA) {
+        delta = WHEEL_MAX_DELTA;
+        slot_tick = wheel->tick + WHEEL_MAX_DELTA;
+    }
+    
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (1ULL << (WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    
+    size_t index = (slot_tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    timer->level = level;
+    wheel->level_count[level]++;
+    list_append(&wheel->slots[level][index], timer);
+}
+
+/* Re-place every timer of a higher level slot now that it is in range */
+static void cascade(TimerWheel* wheel, int level, size_t index) {
+    WheelTimer* head = &wheel->slots[level][index];
+    
+    while (!list_empty(head)) {
+        WheelTimer* timer = head->next;
+        list_unlink(timer);
+        wheel->level_count[level]--;
+        place_timer(wheel, timer);
+    }
+}
+
+void wheel_timer_init(WheelTimer* timer, WheelTimerCallback callback, void* user_data) {
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->level = -1;
+    timer->callback = callback;
+    timer->user_data = user_data;
+    timer->armed = false;
+}
+
+TimerWheel* timer_wheel_create(uint32_t tick_ms, uint64_t now_ms) {
+    TimerWheel* wheel = calloc(1, sizeof(TimerWheel));
+    if (!wheel) return NULL;
+    
+    wheel->tick_ms = tick_ms > 0 ? tick_ms : 1;
+    wheel->base_ms = now_ms;
+    
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int i = 0; i < WHEEL_SIZE; i++) {
+            list_init(&wheel->slots[level][i]);
+        }
+    }
+    list_init(&wheel->expired);
+    
+    return wheel;
+}
+
+void timer_wheel_schedule(TimerWheel* wheel, WheelTimer* timer, uint64_t now_ms, uint64_t delay_ms) {
+    timer_wheel_cancel(wheel, timer);
+    
+    // Round up so a timer never fires early
+    uint64_t target_ms = now_ms + delay_ms;
+    uint64_t expires = target_ms > wheel->base_ms ?
+                       (target_ms - wheel->base_ms + wheel->tick_ms - 1) / wheel->tick_ms : 0;
+    if (expires <= wheel->tick) {
+        expires = wheel->tick + 1;
+    }
+    
+    timer->expires = expires;
+    timer->armed = true;
+    wheel->count++;
+    place_timer(wheel, timer);
+}
+
+void timer_wheel_cancel(TimerWheel* wheel, WheelTimer* timer) {
+    if (!timer->armed) return;
+    
+    if (timer->level >= 0) {
+        wheel->level_count[timer->level]--;
+    }
+    list_unlink(timer);
+    timer->armed = false;
+    wheel->count--;
+}
+
+void timer_wheel_advance(TimerWheel* wheel, uint64_t now_ms) {
+    uint64_t target = ms_to_tick(wheel, now_ms);
+    
+    while (wheel->tick < target) {
+        // Jump over ticks that cannot cascade or expire anything
+        int lowest = 0;
+        while (lowest < WHEEL_LEVELS && wheel->level_count[lowest] == 0) {
+            lowest++;
+        }
+        if (lowest == WHEEL_LEVELS) {
+            wheel->tick = target;
+            break;
+        }
+        if (lowest > 0) {
+            uint64_t skip_to = wheel->tick | ((1ULL << (WHEEL_BITS * lowest)) - 1);
+            wheel->tick = skip_to < target ? skip_to : target;
+            if (wheel->tick == target) break;
+        }
+        
+        wheel->tick++;
+        
+        size_t index = wheel->tick & WHEEL_MASK;
+        for (int level = 1; level < WHEEL_LEVELS && index == 0; level++) {
+            index = (wheel->tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+            cascade(wheel, level, index);
+        }
+        
+        cascade(wheel, 0, wheel->tick & WHEEL_MASK);
+    }
+}
+
+WheelTimer* timer_wheel_pop_expired(TimerWheel* wheel) {
+    if (list_empty(&wheel->expired)) return NULL;
+    
+    WheelTimer* timer = wheel->expired.next;
+    list_unlink(timer);
+    timer->armed = false;
+    wheel->count--;
+    return timer;
+}
+
+int64_t timer_wheel_next_timeout(TimerWheel* wheel, uint64_t now_ms) {
+    if (!list_empty(&wheel->expired)) return 0;
+    if (wheel->count == 0) return -1;
+    
+    uint64_t until = UINT64_MAX;
+    
+    if (wheel->level_count[0] > 0) {
+        for (uint64_t d = 1; d < WHEEL_SIZE; d++) {
+            if (!list_empty(&wheel->slots[0][(wheel->tick + d) & WHEEL_MASK])) {
+                until = wheel->tick + d;
+                break;
+            }
+        }
+    }
+    
+    // Higher levels only matter at the next cascade of the lowest busy one
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if (wheel->level_count[level] == 0) continue;
+        
+        uint64_t boundary = (wheel->tick | ((1ULL << (WHEEL_BITS * level)) - 1)) + 1;
+        if (boundary < until) until = boundary;
+        break;
+    }
+    
+    uint64_t deadline_ms = wheel->base_ms + until * wheel->tick_ms;
+    return deadline_ms > now_ms ? (int64_t)(deadline_ms - now_ms) : 0;
+}
+
+size_t timer_wheel_count(const TimerWheel* wheel) {
+    return wheel->count;
+}
+
+void timer_wheel_destroy(TimerWheel* wheel) {
+    free(wheel);
+}
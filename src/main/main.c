@@ -4,8 +4,12 @@
 #include <signal.h>
 #include "bluetooth/device_manager.h"
 
+#define SCAN_WINDOW_S 10
+#define SCAN_PERIOD_S 30
+
 static DeviceManager* manager = NULL;
 static volatile int running = 1;
+static volatile int windows_done = 0;
 
 void signal_handler(int sig) {
     (void)sig;  // Mark parameter as unused
@@ -21,6 +25,9 @@ void on_device_discovered(BluetoothDevice* device, void* user_data) {
 void on_scan_status(bool scanning, void* user_data) {
     (void)user_data;  // Mark parameter as unused
     printf("Scan %s\n", scanning ? "started" : "stopped");
+    if (!scanning) {
+        windows_done++;
+    }
 }
 
 void on_error(ErrorCode error __attribute__((unused)), const char* message, void* user_data) {
@@ -28,11 +35,32 @@ void on_error(ErrorCode error __attribute__((unused)), const char* message, void
     fprintf(stderr, "Error: %s\n", message);
 }
 
+/* List all discovered devices */
+static void list_devices(void) {
+    printf("\nDiscovered devices:\n");
+    DeviceSnapshot* devices = device_manager_snapshot(manager);
+    size_t count = device_snapshot_count(devices);
+    
+    if (count == 0) {
+        printf("No devices found..\n");
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            const BluetoothDevice* device = device_snapshot_get(devices, i);
+            printf("- %s (%s) Type: %d RSSI: %d\n", 
+                   device->alias, device->address, device->type, device->rssi);
+        }
+        
+        printf("\nTotal devices found: %zu\n\n", count);
+    }
+    device_snapshot_unref(devices);
+}
+
 int main() {
     signal(SIGINT, signal_handler);
     
     DeviceManagerConfig config = {
-        .scan_duration = 0,
+        .scan_duration = SCAN_WINDOW_S,
+        .scan_interval = SCAN_PERIOD_S,
         .filter_duplicates = true,
         .on_discovered = on_device_discovered,
         .on_scan_status = on_scan_status,
@@ -54,42 +82,23 @@ int main() {
         return 1;
     }
     
-    printf("Scanning for 10 seconds (Press Ctrl+C to stop early)...\n");
+    printf("Scanning %d seconds out of every %d (Press Ctrl+C to stop)...\n",
+           SCAN_WINDOW_S, SCAN_PERIOD_S);
     
-    // Sleep with interrupt checking
-    for (int i = 0; i < 10 && running; i++) {
+    // The scan scheduler opens and closes the windows; list after each one
+    int windows_listed = 0;
+    while (running) {
         sleep(1);
-    }
-    
-    if (running) {
-        device_manager_stop_discovery(manager);
-        printf("Scan stopped..\n");
-    } else {
-        printf("Scan interrupted by user..\n");
-    }
-    
-    // List all discovered devices
-    printf("\nDiscovered devices:\n");
-    GList* devices = device_manager_get_devices(manager);
-    
-    if (devices == NULL) {
-        printf("No devices found..\n");
-    } else {
-        GList* iter = devices;
-        int count = 0;
-        
-        while (iter) {
-            BluetoothDevice* device = (BluetoothDevice*)iter->data;
-            printf("- %s (%s) Type: %d RSSI: %d\n", 
-                   device->alias, device->address, device->type, device->rssi);
-            iter = iter->next;
-            count++;
+        if (windows_done != windows_listed) {
+            windows_listed = windows_done;
+            list_devices();
         }
-        
-        printf("\nTotal devices found: %d\n", count);
-        g_list_free(devices);
     }
     
+    device_manager_stop_discovery(manager);
+    printf("Scan stopped..\n");
+    list_devices();
+    
     device_manager_destroy(manager);
     
     printf("Done!!..\n");
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include "bluetooth/connection_manager.h"
+
+/*
+ * Asynchronous operation check against the devices given on the command
+ * line (already known to BlueZ): connect to all of them at once, cancel a
+ * disconnect before BlueZ answers, give a connect a deadline it cannot
+ * meet, then destroy the manager with connects still in flight. Every
+ * operation must complete through its callback exactly once.
+ */
+
+#define WAIT_SEC 15
+
+typedef struct {
+    atomic_int calls;
+    ErrorCode result;
+} Outcome;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void on_done(ConnectionOperation* operation, ErrorCode result,
+                    const char* error_message, void* user_data) {
+    Outcome* outcome = user_data;
+    outcome->result = result;
+    atomic_fetch_add(&outcome->calls, 1);
+    
+    if (result != SUCCESS) {
+        printf("  %s %d: %d %s\n", connection_operation_get_address(operation),
+               connection_operation_get_type(operation), result,
+               error_message ? error_message : "");
+    }
+}
+
+/* Wait until every outcome has been reported at least once */
+static bool wait_for(Outcome* outcomes, size_t count) {
+    double deadline = now_sec() + WAIT_SEC;
+    for (;;) {
+        size_t done = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (atomic_load(&outcomes[i].calls) > 0) done++;
+        }
+        if (done == count) return true;
+        if (now_sec() > deadline) return false;
+        sleep_ms(10);
+    }
+}
+
+/* Number of outcomes not reported exactly once */
+static int check_once(const char* phase, Outcome* outcomes, size_t count) {
+    int failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        int calls = atomic_load(&outcomes[i].calls);
+        if (calls != 1) {
+            fprintf(stderr, "%s: operation %zu completed %d times\n", phase, i, calls);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <device_address>...\n", argv[0]);
+        return 1;
+    }
+    
+    const char* const* addresses = (const char* const*)&argv[1];
+    size_t count = (size_t)argc - 1;
+    
+    ConnectionManagerConfig config = {
+        .connection_timeout = 10,
+        .auto_reconnect = false,
+        .auto_trust = false
+    };
+    ConnectionManager* manager = connection_manager_create(&config);
+    if (!manager) {
+        fprintf(stderr, "Failed to create connection manager\n");
+        return 1;
+    }
+    
+    Outcome* outcomes = calloc(count, sizeof(Outcome));
+    ConnectionOperation** operations = calloc(count, sizeof(ConnectionOperation*));
+    if (!outcomes || !operations) return 1;
+    
+    int failures = 0;
+    
+    // 1. Everything at once on the one connection
+    printf("1. Connecting to %zu devices concurrently...\n", count);
+    double start = now_sec();
+    size_t issued = 0;
+    for (size_t i = 0; i < count; i++) {
+        operations[i] = connection_manager_connect_async(manager, addresses[i], 0,
+                                                         on_done, &outcomes[i]);
+        if (operations[i]) {
+            issued++;
+        } else {
+            fprintf(stderr, "  %s: not issued\n", addresses[i]);
+            atomic_store(&outcomes[i].calls, 1);
+            outcomes[i].result = ERR_NO_DEVICE;
+        }
+    }
+    if (!wait_for(outcomes, count)) {
+        fprintf(stderr, "Connects still running after %d seconds\n", WAIT_SEC);
+    }
+    
+    size_t succeeded = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (operations[i] && outcomes[i].result == SUCCESS) succeeded++;
+    }
+    printf("   %zu issued, %zu connected in %.0f ms\n",
+           issued, succeeded, (now_sec() - start) * 1000);
+    failures += check_once("connect", outcomes, count);
+    
+    for (size_t i = 0; i < count; i++) {
+        connection_operation_unref(operations[i]);
+    }
+    
+    // 2. Cancel before the reply - a second cancel must be a no-op
+    printf("2. Cancelling a disconnect of %s...\n", addresses[0]);
+    Outcome cancelled = { 0 };
+    ConnectionOperation* operation = connection_manager_disconnect_async(manager, addresses[0], 0,
+                                                                         on_done, &cancelled);
+    if (operation) {
+        connection_operation_cancel(operation);
+        connection_operation_cancel(operation);
+        wait_for(&cancelled, 1);
+        sleep_ms(500);  // A late reply must not report again
+        printf("   result %d\n", cancelled.result);
+        failures += check_once("cancel", &cancelled, 1);
+        connection_operation_unref(operation);
+    }
+    
+    // 3. A deadline BlueZ cannot meet
+    printf("3. Connecting to %s with a 1 ms deadline...\n", addresses[0]);
+    Outcome late = { 0 };
+    operation = connection_manager_connect_async(manager, addresses[0], 1, on_done, &late);
+    if (operation) {
+        wait_for(&late, 1);
+        printf("   result %d (%s)\n", late.result,
+               late.result == ERR_TIMEOUT ? "timed out" : "answered in time");
+        failures += check_once("timeout", &late, 1);
+        connection_operation_unref(operation);
+    }
+    
+    // 4. Destroy cancels whatever is still in flight before returning
+    printf("4. Destroying with %zu connects in flight...\n", count);
+    for (size_t i = 0; i < count; i++) {
+        atomic_store(&outcomes[i].calls, 0);
+        operations[i] = connection_manager_connect_async(manager, addresses[i], 0,
+                                                         on_done, &outcomes[i]);
+        if (!operations[i]) atomic_store(&outcomes[i].calls, 1);
+    }
+    connection_manager_destroy(manager);
+    failures += check_once("destroy", outcomes, count);
+    
+    for (size_t i = 0; i < count; i++) {
+        connection_operation_unref(operations[i]);
+    }
+    free(operations);
+    free(outcomes);
+    
+    printf("%s\n", failures ? "FAILED" : "All operations completed exactly once");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "bluetooth/connection_manager.h"
+
+/*
+ * Bulk connect check against the devices given on the command line
+ * (already known to BlueZ): connect them all through the scheduler at a
+ * low and a high per-adapter limit, disconnecting in between, then cancel
+ * a batch right after starting it. Progress must add up to the batch
+ * size once nothing is queued or in flight.
+ */
+
+#define WAIT_SEC 60
+
+static const int limits[] = { 4, 16 };
+
+typedef struct {
+    atomic_int reports;
+    atomic_int max_in_flight;
+} Observed;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void on_progress(ConnectBatch* batch, const ConnectBatchProgress* progress, void* user_data) {
+    (void)batch;
+    Observed* observed = user_data;
+    atomic_fetch_add(&observed->reports, 1);
+    
+    int seen = atomic_load(&observed->max_in_flight);
+    while (progress->in_flight > seen &&
+           !atomic_compare_exchange_weak(&observed->max_in_flight, &seen, progress->in_flight)) {
+        // seen was refreshed, try again
+    }
+}
+
+/* Wait for a batch to drain; false on timeout */
+static bool wait_for_batch(ConnectBatch* batch, ConnectBatchProgress* progress) {
+    double deadline = now_sec() + WAIT_SEC;
+    for (;;) {
+        connect_batch_get_progress(batch, progress);
+        if (progress->queued == 0 && progress->in_flight == 0) return true;
+        if (now_sec() > deadline) return false;
+        sleep_ms(10);
+    }
+}
+
+/* Number of broken progress invariants of a drained batch */
+static int check_progress(const char* phase, const ConnectBatchProgress* progress, size_t count) {
+    if (progress->total == (int)count &&
+        progress->succeeded + progress->failed == progress->total) {
+        return 0;
+    }
+    fprintf(stderr, "%s: total %d, succeeded %d, failed %d, queued %d, in flight %d\n",
+            phase, progress->total, progress->succeeded, progress->failed,
+            progress->queued, progress->in_flight);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <device_address>...\n", argv[0]);
+        return 1;
+    }
+    
+    const char* const* addresses = (const char* const*)&argv[1];
+    size_t count = (size_t)argc - 1;
+    int failures = 0;
+    
+    // Later addresses first, to exercise the priority order
+    int* priorities = malloc(count * sizeof(int));
+    if (!priorities) return 1;
+    for (size_t i = 0; i < count; i++) {
+        priorities[i] = (int)i;
+    }
+    
+    for (size_t pass = 0; pass < sizeof(limits) / sizeof(limits[0]); pass++) {
+        ConnectionManagerConfig config = {
+            .connection_timeout = 10,
+            .max_connects_per_adapter = limits[pass]
+        };
+        ConnectionManager* manager = connection_manager_create(&config);
+        if (!manager) {
+            fprintf(stderr, "Failed to create connection manager\n");
+            return 1;
+        }
+        
+        printf("%zu. Connecting %zu devices, %d at a time per adapter...\n",
+               pass + 1, count, limits[pass]);
+        
+        Observed observed = { 0 };
+        ConnectPolicy policy = {
+            .priorities = priorities,
+            .on_progress = on_progress,
+            .user_data = &observed
+        };
+        
+        double start = now_sec();
+        ConnectBatch* batch = connection_manager_connect_many(manager, addresses, count, &policy);
+        ConnectBatchProgress progress = { 0 };
+        if (!batch || !wait_for_batch(batch, &progress)) {
+            fprintf(stderr, "Batch did not finish within %d seconds\n", WAIT_SEC);
+            failures++;
+        }
+        
+        printf("   %d connected, %d failed in %.0f ms, at most %d in flight, %d reports\n",
+               progress.succeeded, progress.failed, (now_sec() - start) * 1000,
+               atomic_load(&observed.max_in_flight), atomic_load(&observed.reports));
+        failures += check_progress("connect_many", &progress, count);
+        connect_batch_unref(batch);
+        
+        for (size_t i = 0; i < count; i++) {
+            connection_manager_disconnect(manager, addresses[i]);
+        }
+        connection_manager_destroy(manager);
+    }
+    
+    // Cancelling drops the queue and cancels whatever already started
+    printf("3. Cancelling a batch of %zu right after starting it...\n", count);
+    ConnectionManagerConfig config = {
+        .connection_timeout = 10,
+        .max_connects_per_adapter = 1
+    };
+    ConnectionManager* manager = connection_manager_create(&config);
+    if (!manager) {
+        fprintf(stderr, "Failed to create connection manager\n");
+        return 1;
+    }
+    
+    ConnectBatch* batch = connection_manager_connect_many(manager, addresses, count, NULL);
+    connect_batch_cancel(batch);
+    
+    ConnectBatchProgress progress = { 0 };
+    if (!batch || !wait_for_batch(batch, &progress)) {
+        fprintf(stderr, "Cancelled batch did not drain\n");
+        failures++;
+    }
+    printf("   %d connected before the cancel, %d dropped\n", progress.succeeded, progress.failed);
+    failures += check_progress("cancel", &progress, count);
+    connect_batch_unref(batch);
+    
+    for (size_t i = 0; i < count; i++) {
+        connection_manager_disconnect(manager, addresses[i]);
+    }
+    connection_manager_destroy(manager);
+    free(priorities);
+    
+    printf("%s\n", failures ? "FAILED" : "Bulk connect progress is consistent");
+    return failures ? 1 : 0;
+}
@@ -89,6 +89,8 @@ int main(int argc, char* argv[]) {
         .connection_timeout = 10,  // 10 seconds
         .auto_reconnect = false,
         .auto_trust = true,
+        .device_manager = dev_manager,
+        .adapter_selection = ADAPTER_SELECT_BEST_RSSI,
         .user_data = NULL
     };
     
@@ -125,6 +127,13 @@ int main(int argc, char* argv[]) {
     printf("Paired: %s, Trusted: %s\n", 
            device->paired ? "Yes" : "No",
            device->trusted ? "Yes" : "No");
+    free(device);
+    
+    DeviceSighting sightings[8];
+    size_t sighting_count = device_manager_get_sightings(dev_manager, target_address, sightings, 8);
+    for (size_t i = 0; i < sighting_count && i < 8; i++) {
+        printf("Seen by %s at %d dBm\n", sightings[i].adapter, sightings[i].rssi);
+    }
     
     // Ask user what to do
     printf("\nChoose action:\n");
@@ -148,7 +157,15 @@ int main(int argc, char* argv[]) {
             printf("\nConnecting to %s...\n", target_address);
             if (connection_manager_connect(conn_manager, target_address) == SUCCESS) {
                 printf("Connected successfully!\n");
-                
+
+                DeviceStatus status;
+                if (connection_manager_get_status(conn_manager, target_address, &status) == SUCCESS) {
+                    printf("Services resolved: %s, Paired: %s, Trusted: %s\n",
+                           status.services_resolved ? "Yes" : "No",
+                           status.paired ? "Yes" : "No",
+                           status.trusted ? "Yes" : "No");
+                }
+
                 // Keep connection for 10 seconds
                 printf("Keeping connection for 10 seconds...\n");
                 sleep(10);
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bluetooth/bt_addr.h"
+#include "bluetooth/device_cache.h"
+
+/*
+ * Device cache check: write a venue's worth of devices, update some of them
+ * so the journal has to compact, then reopen the file and time the load.
+ */
+
+#define DEVICES 10000
+#define UPDATES 5000
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static DeviceCacheRecord make_record(size_t i, int generation) {
+    DeviceCacheRecord record = {
+        .addr = 0xDC2C26000000ULL + i,
+        .last_seen = 1700000000 + generation,
+        .class = 0x240404,
+        .type = DEVICE_AUDIO_SINK,
+        .rssi = (int8_t)(-40 - (int)(i % 50)),
+        .flags = 0
+    };
+    snprintf(record.alias, sizeof(record.alias), "Device %zu gen %d", i, generation);
+    return record;
+}
+
+int main(int argc, char* argv[]) {
+    char path[] = "/tmp/test_device_cache_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    
+    const char* cache_path = argc > 1 ? argv[1] : path;
+    
+    DeviceCache* cache = device_cache_open(cache_path);
+    if (!cache) {
+        fprintf(stderr, "Failed to create cache at %s\n", cache_path);
+        return 1;
+    }
+    
+    for (size_t i = 0; i < DEVICES; i++) {
+        DeviceCacheRecord record = make_record(i, 0);
+        if (!device_cache_put(cache, &record)) {
+            fprintf(stderr, "Append %zu failed\n", i);
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < UPDATES; i++) {
+        DeviceCacheRecord record = make_record(i * 2, 1);
+        device_cache_put(cache, &record);
+    }
+    device_cache_close(cache);
+    
+    // Reopen and check the latest record for every device won
+    double start = now_sec();
+    cache = device_cache_open(cache_path);
+    double elapsed = now_sec() - start;
+    
+    int result = 0;
+    if (!cache || device_cache_count(cache) != DEVICES) {
+        fprintf(stderr, "Reopened cache has %zu devices, expected %d\n",
+                device_cache_count(cache), DEVICES);
+        result = 1;
+    }
+    
+    for (size_t i = 0; cache && result == 0 && i < DEVICES; i++) {
+        DeviceCacheRecord expected = make_record(i, (i % 2 == 0 && i / 2 < UPDATES) ? 1 : 0);
+        const DeviceCacheRecord* record = device_cache_find(cache, expected.addr);
+        if (!record || strcmp(record->alias, expected.alias) != 0 ||
+            record->last_seen != expected.last_seen || record->rssi != expected.rssi) {
+            fprintf(stderr, "Record %zu does not match\n", i);
+            result = 1;
+        }
+    }
+    
+    printf("Loaded %zu cached devices in %.1f us\n", device_cache_count(cache), elapsed * 1e6);
+    
+    device_cache_close(cache);
+    if (argc <= 1) unlink(path);
+    return result;
+}
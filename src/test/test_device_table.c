@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include "bluetooth/bt_addr.h"
+#include "bluetooth/device_store.h"
+#include "bluetooth/device_table.h"
+
+/*
+ * Benchmark: integer-keyed DeviceTable vs the GHashTable (strdup'd string
+ * keys, g_str_hash) the managers used before. Each round inserts N devices,
+ * looks every one up LOOKUPS times from its string form (as the D-Bus
+ * handlers do), then removes them all.
+ */
+
+#define ROUNDS 5
+#define LOOKUPS 10
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Random addresses spread over a handful of vendor OUIs */
+static char (*make_addresses(size_t count))[BT_ADDR_STR_LEN] {
+    static const bt_addr_t ouis[] = { 0x001A7D, 0xDC2C26, 0x38F9D3, 0xF4F5D8 };
+    char (*addresses)[BT_ADDR_STR_LEN] = malloc(count * BT_ADDR_STR_LEN);
+    if (!addresses) return NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        bt_addr_t addr = ouis[i % 4] << 24 | ((bt_addr_t)rand() & 0xFFFFFF);
+        bt_addr_format(addr, addresses[i]);
+    }
+    return addresses;
+}
+
+static double bench_ghash(char (*addresses)[BT_ADDR_STR_LEN], size_t count, size_t* hits) {
+    double start = now_sec();
+
+    for (int round = 0; round < ROUNDS; round++) {
+        GHashTable* table = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+
+        for (size_t i = 0; i < count; i++) {
+            g_hash_table_replace(table, strdup(addresses[i]), addresses[i]);
+        }
+        for (int pass = 0; pass < LOOKUPS; pass++) {
+            for (size_t i = 0; i < count; i++) {
+                if (g_hash_table_lookup(table, addresses[i])) (*hits)++;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            g_hash_table_remove(table, addresses[i]);
+        }
+
+        g_hash_table_destroy(table);
+    }
+
+    return now_sec() - start;
+}
+
+static double bench_device_table(char (*addresses)[BT_ADDR_STR_LEN], size_t count, size_t* hits) {
+    double start = now_sec();
+
+    for (int round = 0; round < ROUNDS; round++) {
+        DeviceTable* table = device_table_create(0);
+        bt_addr_t key;
+
+        for (size_t i = 0; i < count; i++) {
+            if (bt_addr_parse(addresses[i], &key)) {
+                device_table_insert(table, key, addresses[i], NULL);
+            }
+        }
+        for (int pass = 0; pass < LOOKUPS; pass++) {
+            for (size_t i = 0; i < count; i++) {
+                if (bt_addr_parse(addresses[i], &key) && device_table_lookup(table, key)) (*hits)++;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (bt_addr_parse(addresses[i], &key)) {
+                device_table_remove(table, key);
+            }
+        }
+
+        device_table_destroy(table, NULL);
+    }
+
+    return now_sec() - start;
+}
+
+static int check_addresses(void) {
+    bt_addr_t addr;
+    char text[BT_ADDR_STR_LEN];
+
+    if (!bt_addr_parse("aa:bb:cc:00:11:22", &addr) || addr != 0xAABBCC001122ULL) return 1;
+    bt_addr_format(addr, text);
+    if (strcmp(text, "AA:BB:CC:00:11:22") != 0) return 1;
+    if (!bt_addr_from_path("/org/bluez/hci0/dev_00_1A_7D_DA_71_13", &addr) ||
+        addr != 0x001A7DDA7113ULL) return 1;
+    if (bt_addr_parse("AA:BB:CC", &addr) || bt_addr_parse("AA:BB:CC:00:11:22:33", &addr) ||
+        bt_addr_parse("GG:BB:CC:00:11:22", &addr)) return 1;
+
+    return 0;
+}
+
+/* Fill a DeviceStore the way a dense venue would and report its footprint */
+static int report_store_memory(size_t count) {
+    static const char* names[] = { "Galaxy Buds2", "AirPods Pro", "[TV] Samsung", "JBL Flip 5", "Tile" };
+    DeviceStore* store = device_store_create(0);
+    if (!store) return 1;
+
+    for (size_t i = 0; i < count; i++) {
+        DeviceSlot slot = device_store_add(store, 0xDC2C26000000ULL + i);
+        if (slot == DEVICE_SLOT_NONE || !device_store_set_name(store, slot, names[i % 5]) ||
+            !device_store_set_alias(store, slot, names[i % 5])) {
+            device_store_destroy(store);
+            return 1;
+        }
+        device_store_set_rssi(store, slot, (int8_t)(-40 - (int)(i % 50)));
+    }
+
+    size_t hot = device_store_hot_bytes(store);
+    printf("\nDeviceStore with %zu devices: %zu KB hot, %zu KB cold (%zu bytes per BluetoothDevice view)\n",
+           count, hot / 1024, device_store_cold_bytes(store) / 1024, sizeof(BluetoothDevice));
+
+    device_store_destroy(store);
+    return hot < 1024 * 1024 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (check_addresses() != 0) {
+        fprintf(stderr, "bt_addr parse/format check failed\n");
+        return 1;
+    }
+
+    size_t sizes[] = { 100, 1000, 10000, 100000 };
+    size_t nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    if (argc > 1) {
+        sizes[0] = strtoul(argv[1], NULL, 10);
+        nsizes = 1;
+    }
+
+    srand(42);
+    printf("%10s %16s %16s %8s\n", "devices", "GHashTable ns/op", "DeviceTable ns/op", "speedup");
+
+    for (size_t s = 0; s < nsizes; s++) {
+        size_t count = sizes[s];
+        char (*addresses)[BT_ADDR_STR_LEN] = make_addresses(count);
+        if (!addresses) return 1;
+
+        size_t ghash_hits = 0, table_hits = 0;
+        double ghash = bench_ghash(addresses, count, &ghash_hits);
+        double table = bench_device_table(addresses, count, &table_hits);
+
+        if (ghash_hits != table_hits) {
+            fprintf(stderr, "Lookup results differ (%zu vs %zu)\n", ghash_hits, table_hits);
+            free(addresses);
+            return 1;
+        }
+
+        double ops = (double)ROUNDS * count * (LOOKUPS + 2);
+        printf("%10zu %16.1f %16.1f %7.2fx\n", count,
+               ghash * 1e9 / ops, table * 1e9 / ops, ghash / table);
+
+        free(addresses);
+    }
+
+    if (report_store_memory(10000) != 0) {
+        fprintf(stderr, "DeviceStore hot data exceeds 1 MB\n");
+        return 1;
+    }
+
+    return 0;
+}
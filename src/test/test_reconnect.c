@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bluetooth/connection_manager.h"
+
+/*
+ * Auto-reconnect check against one device already known to BlueZ. A
+ * second manager cuts the link behind the first one's back a few times;
+ * each drop must be retried after a jittered delay within the backoff
+ * window and the link must come back. A deliberate disconnect afterwards
+ * must not be undone.
+ */
+
+#define BASE_DELAY_MS 500
+#define DROPS 3
+#define WAIT_SEC 20
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Wait until the device has been reconnected `successes` times */
+static bool wait_for_reconnect(ConnectionManager* manager, const char* address,
+                               uint32_t successes, ReconnectStats* stats) {
+    double deadline = now_sec() + WAIT_SEC;
+    for (;;) {
+        if (connection_manager_get_reconnect_stats(manager, address, stats) == SUCCESS &&
+            stats->successes >= successes &&
+            connection_manager_get_state(manager, address) == STATE_CONNECTED) {
+            return true;
+        }
+        if (now_sec() > deadline) return false;
+        sleep_ms(10);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <device_address>\n", argv[0]);
+        return 1;
+    }
+    
+    const char* address = argv[1];
+    int failures = 0;
+    
+    ConnectionManagerConfig config = {
+        .connection_timeout = 10,
+        .auto_reconnect = true,
+        .reconnect_base_delay_ms = BASE_DELAY_MS,
+        .reconnect_max_delay_ms = 4 * BASE_DELAY_MS
+    };
+    ConnectionManager* manager = connection_manager_create(&config);
+    
+    // Stands in for the device or another program dropping the link
+    ConnectionManagerConfig other_config = { .connection_timeout = 10 };
+    ConnectionManager* other = connection_manager_create(&other_config);
+    
+    if (!manager || !other) {
+        fprintf(stderr, "Failed to create connection managers\n");
+        return 1;
+    }
+    
+    printf("Connecting to %s...\n", address);
+    if (connection_manager_connect(manager, address) != SUCCESS) {
+        fprintf(stderr, "Initial connect failed\n");
+        connection_manager_destroy(other);
+        connection_manager_destroy(manager);
+        return 1;
+    }
+    
+    ReconnectStats stats = { 0 };
+    for (uint32_t drop = 1; drop <= DROPS; drop++) {
+        double start = now_sec();
+        connection_manager_disconnect(other, address);
+        
+        if (!wait_for_reconnect(manager, address, drop, &stats)) {
+            fprintf(stderr, "Drop %u: not reconnected within %d seconds\n", drop, WAIT_SEC);
+            failures++;
+            break;
+        }
+        
+        // No failures in a row, so the delay is drawn from [base/2, base]
+        printf("Drop %u: retried after %u ms, back up after %.0f ms\n",
+               drop, stats.last_delay_ms, (now_sec() - start) * 1000);
+        if (stats.last_delay_ms < BASE_DELAY_MS / 2 || stats.last_delay_ms > BASE_DELAY_MS) {
+            fprintf(stderr, "Drop %u: delay %u ms outside the backoff window\n",
+                    drop, stats.last_delay_ms);
+            failures++;
+        }
+    }
+    
+    if (stats.drops != DROPS || stats.attempts < DROPS || stats.consecutive_failures != 0) {
+        fprintf(stderr, "Stats: %u drops, %u attempts, %u successes, %u failures (%u in a row)\n",
+                stats.drops, stats.attempts, stats.successes, stats.failures,
+                stats.consecutive_failures);
+        failures++;
+    }
+    
+    printf("Disconnecting deliberately...\n");
+    connection_manager_disconnect(manager, address);
+    sleep_ms(4 * BASE_DELAY_MS);
+    
+    ReconnectStats after = { 0 };
+    connection_manager_get_reconnect_stats(manager, address, &after);
+    if (after.attempts != stats.attempts || after.pending ||
+        connection_manager_get_state(manager, address) != STATE_DISCONNECTED) {
+        fprintf(stderr, "A deliberate disconnect was retried\n");
+        failures++;
+    }
+    
+    connection_manager_destroy(other);
+    connection_manager_destroy(manager);
+    
+    printf("%s\n", failures ? "FAILED" : "Reconnects follow the backoff");
+    return failures ? 1 : 0;
+}
@@ -6,6 +6,7 @@
 
 static DeviceManager* manager = NULL;
 static volatile int running = 1;
+static volatile int scanning = 0;
 
 void signal_handler(int sig) {
     (void)sig;  // Mark parameter as unused
@@ -18,9 +19,15 @@ void on_device_discovered(BluetoothDevice* device, void* user_data) {
     printf("Device: %s (%s) - RSSI: %d\n", device->alias, device->address, device->rssi);
 }
 
-void on_scan_status(bool scanning, void* user_data) {
+void on_scan_status(bool active, void* user_data) {
     (void)user_data;  // Mark parameter as unused
-    printf("Scan %s\n", scanning ? "started" : "stopped");
+    printf("Scan %s\n", active ? "started" : "stopped");
+    scanning = active;
+}
+
+void on_adapter(const char* adapter_path, bool present, void* user_data) {
+    (void)user_data;  // Mark parameter as unused
+    printf("Adapter %s %s\n", adapter_path, present ? "added" : "removed");
 }
 
 void on_error(ErrorCode error __attribute__((unused)), const char* message, void* user_data) {
@@ -32,10 +39,11 @@ int main() {
     signal(SIGINT, signal_handler);
     
     DeviceManagerConfig config = {
-        .scan_duration = 0,
+        .scan_duration = 10,
         .filter_duplicates = true,
         .on_discovered = on_device_discovered,
         .on_scan_status = on_scan_status,
+        .on_adapter = on_adapter,
         .on_error = on_error,
         .user_data = NULL
     };
@@ -46,8 +54,16 @@ int main() {
         return 1;
     }
     
+    AdapterInfo adapters[8];
+    size_t adapter_count = device_manager_get_adapters(manager, adapters, 8);
+    for (size_t i = 0; i < adapter_count && i < 8; i++) {
+        printf("Adapter: %s (%zu known devices)\n", adapters[i].path, adapters[i].devices);
+    }
+    
     printf("Starting Bluetooth scan...\n");
     
+    // Before starting: on_scan_status(false) may arrive before start returns
+    scanning = 1;
     if (device_manager_start_discovery(manager) != SUCCESS) {
         fprintf(stderr, "Failed to start discovery\n");
         device_manager_destroy(manager);
@@ -56,38 +72,55 @@ int main() {
     
     printf("Scanning for 10 seconds (Press Ctrl+C to stop early)...\n");
     
-    // Sleep with interrupt checking
-    for (int i = 0; i < 10 && running; i++) {
+    // The scan scheduler ends the scan; just wait for it or Ctrl+C
+    while (running && scanning) {
         sleep(1);
     }
     
     if (running) {
-        device_manager_stop_discovery(manager);
         printf("Scan stopped..\n");
     } else {
+        device_manager_stop_discovery(manager);
         printf("Scan interrupted by user..\n");
     }
     
     // List all discovered devices
     printf("\nDiscovered devices:\n");
-    GList* devices = device_manager_get_devices(manager);
+    DeviceSnapshot* devices = device_manager_snapshot(manager);
+    size_t count = device_snapshot_count(devices);
     
-    if (devices == NULL) {
+    if (count == 0) {
         printf("No devices found..\n");
     } else {
-        GList* iter = devices;
-        int count = 0;
-        
-        while (iter) {
-            BluetoothDevice* device = (BluetoothDevice*)iter->data;
+        for (size_t i = 0; i < count; i++) {
+            const BluetoothDevice* device = device_snapshot_get(devices, i);
             printf("- %s (%s) Type: %d RSSI: %d\n", 
                    device->alias, device->address, device->type, device->rssi);
-            iter = iter->next;
-            count++;
         }
         
-        printf("\nTotal devices found: %d\n", count);
-        g_list_free(devices);
+        printf("\nTotal devices found: %zu\n", count);
+    }
+    device_snapshot_unref(devices);
+    
+    DuplicateFilterStats filter;
+    if (device_manager_get_filter_stats(manager, &filter) == SUCCESS) {
+        printf("Duplicate filter: %llu of %llu updates suppressed\n",
+               (unsigned long long)filter.suppressed, (unsigned long long)filter.received);
+    }
+    
+    BusFilterStats bus;
+    if (device_manager_get_bus_stats(manager, &bus) == SUCCESS) {
+        printf("Signals: %llu received, %llu rejected\n",
+               (unsigned long long)bus.signals_received, (unsigned long long)bus.signals_rejected);
+    }
+    
+    DeviceManagerStats stats;
+    if (device_manager_get_stats(manager, &stats) == SUCCESS) {
+        printf("Parse p99: %llu ns, lock wait p99: %llu ns, lock hold p99: %llu ns\n",
+               (unsigned long long)stats.parse.p99_ns, (unsigned long long)stats.lock_wait.p99_ns,
+               (unsigned long long)stats.lock_hold.p99_ns);
+        printf("Callback delay p99: %llu ns, %llu events dropped\n",
+               (unsigned long long)stats.callback_delay.p99_ns, (unsigned long long)stats.callbacks_dropped);
     }
     
     device_manager_destroy(manager);